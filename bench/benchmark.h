@@ -0,0 +1,172 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_BENCHMARK_H
+#define RCP_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace rcp {
+namespace bench {
+
+// keep the compiler from removing benchmarked code
+template<typename T>
+inline void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+
+struct Result
+{
+    std::string name;
+    uint64_t iterations;
+    uint64_t opsPerIteration;
+    double nsPerOpMedian;
+    double nsPerOpMin;
+    double bytesPerOp;
+};
+
+
+/*
+* Suite - runs and collects benchmarks
+*
+* every benchmark is calibrated once to run at least minTime,
+* then measured for a number of repetitions.
+* median and minimum time per operation are reported.
+*/
+class Suite
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    Suite()
+    {}
+
+    void setFilter(const std::string& filter) { m_filter = filter; }
+    void setMinTimeMs(double ms) { m_minTimeNs = ms * 1e6; }
+    void setRepetitions(size_t repetitions) { m_repetitions = std::max<size_t>(1, repetitions); }
+
+    bool enabled(const std::string& name) const
+    {
+        return m_filter.empty() || name.find(m_filter) != std::string::npos;
+    }
+
+    // func() performs opsPerIteration operations
+    template<typename F>
+    void run(const std::string& name, F func, uint64_t opsPerIteration = 1, double bytesPerOp = 0)
+    {
+        if (!enabled(name))
+        {
+            return;
+        }
+
+        // warm up and calibrate
+        uint64_t iterations = 1;
+        while (true)
+        {
+            double ns = measure(func, iterations);
+            if (ns >= m_minTimeNs || iterations >= (uint64_t(1) << 30))
+            {
+                break;
+            }
+
+            double factor = ns > 0 ? (m_minTimeNs * 1.2) / ns : 10.0;
+            iterations = std::max<uint64_t>(iterations + 1,
+                                            static_cast<uint64_t>(double(iterations) * std::min(factor, 10.0)));
+        }
+
+        std::vector<double> per_op;
+        for (size_t r = 0; r < m_repetitions; r++)
+        {
+            double ns = measure(func, iterations);
+            per_op.push_back(ns / double(iterations * opsPerIteration));
+        }
+        std::sort(per_op.begin(), per_op.end());
+
+        Result result;
+        result.name = name;
+        result.iterations = iterations;
+        result.opsPerIteration = opsPerIteration;
+        result.nsPerOpMedian = per_op[per_op.size() / 2];
+        result.nsPerOpMin = per_op.front();
+        result.bytesPerOp = bytesPerOp;
+        m_results.push_back(result);
+
+        std::cerr << name << ": " << result.nsPerOpMedian << " ns/op\n";
+    }
+
+    const std::vector<Result>& results() const { return m_results; }
+
+    void writeJson(std::ostream& out) const
+    {
+        out << "{\n  \"benchmarks\": [\n";
+        for (size_t i = 0; i < m_results.size(); i++)
+        {
+            const Result& r = m_results[i];
+            out << "    {"
+                << "\"name\": \"" << r.name << "\", "
+                << "\"iterations\": " << r.iterations << ", "
+                << "\"ops_per_iteration\": " << r.opsPerIteration << ", "
+                << "\"ns_per_op\": " << r.nsPerOpMedian << ", "
+                << "\"ns_per_op_min\": " << r.nsPerOpMin << ", "
+                << "\"ops_per_sec\": " << (r.nsPerOpMedian > 0 ? 1e9 / r.nsPerOpMedian : 0);
+
+            if (r.bytesPerOp > 0)
+            {
+                out << ", \"bytes_per_op\": " << r.bytesPerOp;
+            }
+
+            out << "}" << (i + 1 < m_results.size() ? "," : "") << "\n";
+        }
+        out << "  ]\n}\n";
+    }
+
+private:
+    template<typename F>
+    static double measure(F& func, uint64_t iterations)
+    {
+        clock::time_point start = clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            func();
+        }
+        return double(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count());
+    }
+
+    std::string m_filter;
+    double m_minTimeNs{50e6};
+    size_t m_repetitions{5};
+    std::vector<Result> m_results;
+};
+
+}
+}
+
+#endif // RCP_BENCHMARK_H
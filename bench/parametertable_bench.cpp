@@ -0,0 +1,149 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+// compares ParameterTable with std::map<int16_t, ParameterPtr>
+// for insert, lookup and iteration
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <random>
+
+#include "src/rcp.h"
+
+using namespace rcp;
+
+typedef std::chrono::steady_clock bench_clock;
+
+static const size_t LOOKUPS = 1000000;
+static const size_t ITERATIONS = 100;
+
+static double nsSince(const bench_clock::time_point& start, size_t ops)
+{
+    auto d = std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start);
+    return double(d.count()) / double(ops);
+}
+
+static void printResult(const std::string& name, size_t count, double insert_ns, double lookup_ns, double iterate_ns)
+{
+    std::cout << std::left << std::setw(8) << name
+              << std::right << std::setw(8) << count
+              << std::fixed << std::setprecision(2)
+              << std::setw(14) << insert_ns
+              << std::setw(14) << lookup_ns
+              << std::setw(14) << iterate_ns
+              << "\n";
+}
+
+template<typename F>
+static double measure(size_t ops, F func)
+{
+    bench_clock::time_point start = bench_clock::now();
+    func();
+    return nsSince(start, ops);
+}
+
+static void run(size_t count)
+{
+    std::vector<ParameterPtr> parameters;
+    std::vector<int16_t> ids;
+    for (size_t i = 1; i <= count; i++)
+    {
+        parameters.push_back(Int32Parameter::create(static_cast<int16_t>(i)));
+    }
+
+    std::mt19937 rng(1234);
+    std::uniform_int_distribution<size_t> dist(1, count);
+    for (size_t i = 0; i < LOOKUPS; i++)
+    {
+        ids.push_back(static_cast<int16_t>(dist(rng)));
+    }
+
+    size_t sum = 0;
+
+    // std::map
+    {
+        std::map<int16_t, ParameterPtr> map;
+
+        double insert_ns = measure(count, [&]() {
+            for (auto& p : parameters) map[p->getId()] = p;
+        });
+
+        double lookup_ns = measure(LOOKUPS, [&]() {
+            for (int16_t id : ids)
+            {
+                auto it = map.find(id);
+                if (it != map.end()) sum += it->second->getId();
+            }
+        });
+
+        double iterate_ns = measure(count * ITERATIONS, [&]() {
+            for (size_t i = 0; i < ITERATIONS; i++)
+                for (auto& p : map) sum += p.second->getId();
+        });
+
+        printResult("map", count, insert_ns, lookup_ns, iterate_ns);
+    }
+
+    // ParameterTable
+    {
+        ParameterTable table;
+
+        double insert_ns = measure(count, [&]() {
+            for (auto& p : parameters) table.set(p->getId(), p);
+        });
+
+        double lookup_ns = measure(LOOKUPS, [&]() {
+            for (int16_t id : ids)
+            {
+                const ParameterPtr& p = table.get(id);
+                if (p) sum += p->getId();
+            }
+        });
+
+        double iterate_ns = measure(count * ITERATIONS, [&]() {
+            for (size_t i = 0; i < ITERATIONS; i++)
+                for (auto& p : table) sum += p->getId();
+        });
+
+        printResult("table", count, insert_ns, lookup_ns, iterate_ns);
+    }
+
+    // keep results alive
+    if (sum == 0)
+    {
+        std::cout << "";
+    }
+}
+
+int main(int /*argc*/, char const */*argv*/[])
+{
+    std::cout << std::left << std::setw(8) << "type"
+              << std::right << std::setw(8) << "count"
+              << std::setw(14) << "insert ns/op"
+              << std::setw(14) << "lookup ns/op"
+              << std::setw(14) << "iterate ns/op"
+              << "\n";
+
+    run(1000);
+    run(10000);
+    run(30000);
+
+    return 0;
+}
@@ -0,0 +1,691 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+// microbenchmarks for serialization, parsing, parameter management,
+// server update fan-out and end-to-end updates over loopback transporters
+//
+// usage: rcp_bench [--filter <substring>] [--min-time <ms>] [--repetitions <n>]
+//                  [--stream <file>] [--out <file.json>]
+//
+// results are printed to stderr, json is written to --out or stdout.
+// all inputs are generated from fixed seeds.
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "src/rcp.h"
+#include "src/parameterclient.h"
+#include "src/loopbacktransporter.h"
+#include "src/tcptransporter.h"
+#include "src/shmtransporter.h"
+#include "src/unixtransporter.h"
+#include "src/iouringtransporter.h"
+#include "bench/benchmark.h"
+
+using namespace rcp;
+using namespace rcp::bench;
+
+static const uint32_t SEED = 1234;
+
+
+//------------------------------------------------------------------
+// server transporter dropping all data
+class NullServerTransporter : public ServerTransporter
+{
+public:
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    void bind(int /*port*/) override {}
+    void unbind() override {}
+    void sendToOne(const char* /*data*/, size_t size, void* /*id*/) override
+    {
+        bytes += size;
+        sends++;
+    }
+    void sendToAll(const char* /*data*/, size_t size, void* /*excludeId*/) override
+    {
+        bytes += size;
+        sends++;
+    }
+    int getConnectionCount() override { return 1; }
+
+    size_t bytes{0};
+    size_t sends{0};
+};
+
+
+//------------------------------------------------------------------
+// per datatype: write and parse of UPDATE and UPDATEVALUE packets
+template<typename P, typename V>
+static void benchDatatype(Suite& suite, const std::string& type, const V& value)
+{
+    const std::string prefix = "datatype/" + type + "/";
+
+    auto parameter = P::create(1);
+    parameter->setValue(value);
+    parameter->setLabel("label");
+    parameter->setDescription("a parameter description");
+    ParameterPtr p = parameter;
+
+    BufferWriter writer;
+
+    // serialize once to know the size
+    Packet full_packet(COMMAND_UPDATE);
+    full_packet.setData(p);
+    full_packet.write(writer, true);
+    std::vector<char> full(writer.data(), writer.data() + writer.size());
+
+    Packet value_packet(COMMAND_UPDATEVALUE);
+    value_packet.setData(p);
+    writer.clear();
+    value_packet.write(writer, true);
+    std::vector<char> update_value(writer.data(), writer.data() + writer.size());
+
+    suite.run(prefix + "write_full", [&]() {
+        writer.clear();
+        full_packet.write(writer, true);
+        doNotOptimize(writer.size());
+    }, 1, double(full.size()));
+
+    suite.run(prefix + "write_updatevalue", [&]() {
+        writer.clear();
+        value_packet.write(writer, true);
+        doNotOptimize(writer.size());
+    }, 1, double(update_value.size()));
+
+    suite.run(prefix + "parse_full", [&]() {
+        Option<Packet> packet = Packet::parse(full.data(), full.size());
+        doNotOptimize(packet.hasValue());
+    }, 1, double(full.size()));
+
+    suite.run(prefix + "parse_updatevalue", [&]() {
+        Option<Packet> packet = Packet::parse(update_value.data(), update_value.size());
+        doNotOptimize(packet.hasValue());
+    }, 1, double(update_value.size()));
+}
+
+static void benchDatatypes(Suite& suite)
+{
+    benchDatatype<BooleanParameter>(suite, "boolean", true);
+    benchDatatype<Int8Parameter>(suite, "int8", int8_t(-12));
+    benchDatatype<UInt8Parameter>(suite, "uint8", uint8_t(12));
+    benchDatatype<Int16Parameter>(suite, "int16", int16_t(-1234));
+    benchDatatype<UInt16Parameter>(suite, "uint16", uint16_t(1234));
+    benchDatatype<Int32Parameter>(suite, "int32", int32_t(-123456));
+    benchDatatype<UInt32Parameter>(suite, "uint32", uint32_t(123456));
+    benchDatatype<Int64Parameter>(suite, "int64", int64_t(-123456789012));
+    benchDatatype<UInt64Parameter>(suite, "uint64", uint64_t(123456789012));
+    benchDatatype<Float32Parameter>(suite, "float32", 1.5f);
+    benchDatatype<Float64Parameter>(suite, "float64", 1.5);
+    benchDatatype<Vector2I32Parameter>(suite, "vector2i32", Vector2<int>(1, 2));
+    benchDatatype<Vector2F32Parameter>(suite, "vector2f32", Vector2<float>(1.f, 2.f));
+    benchDatatype<Vector3I32Parameter>(suite, "vector3i32", Vector3<int>(1, 2, 3));
+    benchDatatype<Vector3F32Parameter>(suite, "vector3f32", Vector3<float>(1.f, 2.f, 3.f));
+    benchDatatype<Vector4I32Parameter>(suite, "vector4i32", Vector4<int>(1, 2, 3, 4));
+    benchDatatype<Vector4F32Parameter>(suite, "vector4f32", Vector4<float>(1.f, 2.f, 3.f, 4.f));
+    benchDatatype<StringParameter>(suite, "string", std::string("a string value of some length"));
+    benchDatatype<EnumParameter>(suite, "enum", TinyString("entry"));
+    benchDatatype<RGBParameter>(suite, "rgb", Color(0x00ff8040));
+    benchDatatype<RGBAParameter>(suite, "rgba", Color(0xff00ff80));
+    benchDatatype<URIParameter>(suite, "uri", std::string("https://rabbitcontrol.cc"));
+    benchDatatype<IPv4Parameter>(suite, "ipv4", IPv4(0xc0a80001));
+    benchDatatype<IPv6Parameter>(suite, "ipv6", IPv6(1, 2, 3, 4));
+}
+
+
+//------------------------------------------------------------------
+// Packet::parse over a recorded stream of back to back packets
+static std::vector<char> generateStream(size_t count)
+{
+    std::mt19937 rng(SEED);
+    std::uniform_int_distribution<int> kind(0, 3);
+
+    std::vector<ParameterPtr> parameters;
+    parameters.push_back(Float32Parameter::create(1, 0.5f));
+    parameters.push_back(Int32Parameter::create(2, 42));
+    parameters.push_back(Vector3F32Parameter::create(3, Vector3<float>(1.f, 2.f, 3.f)));
+    parameters.push_back(StringParameter::create(4, std::string("text")));
+    for (auto& p : parameters)
+    {
+        p->setLabel("label " + std::to_string(p->getId()));
+    }
+
+    BufferWriter writer;
+    for (size_t i = 0; i < count; i++)
+    {
+        ParameterPtr& p = parameters[i % parameters.size()];
+
+        // mostly value updates, some full updates
+        Packet packet(kind(rng) == 0 ? COMMAND_UPDATE : COMMAND_UPDATEVALUE);
+        packet.setData(p);
+        packet.write(writer, true);
+    }
+
+    return std::vector<char>(writer.data(), writer.data() + writer.size());
+}
+
+static size_t countPackets(const std::vector<char>& stream)
+{
+    ByteReader reader(stream.data(), stream.size());
+    size_t count = 0;
+
+    while (reader.remaining() > 0)
+    {
+        Option<Packet> packet = Packet::parse(reader);
+        if (!packet.hasValue())
+        {
+            break;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+static void benchStream(Suite& suite, const std::string& file)
+{
+    std::vector<char> stream;
+    std::string name = "stream/generated";
+
+    if (!file.empty())
+    {
+        std::ifstream in(file, std::ios::binary);
+        if (!in)
+        {
+            std::cerr << "could not open stream file: " << file << "\n";
+            return;
+        }
+        stream.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        name = "stream/file";
+    }
+    else
+    {
+        stream = generateStream(1000);
+    }
+
+    size_t packets = countPackets(stream);
+    if (packets == 0)
+    {
+        std::cerr << "no packets in stream\n";
+        return;
+    }
+
+    suite.run(name + "/parse", [&]() {
+        doNotOptimize(countPackets(stream));
+    }, packets, double(stream.size()) / double(packets));
+}
+
+
+//------------------------------------------------------------------
+// ParameterManager create, lookup and remove
+static void benchManager(Suite& suite, size_t count)
+{
+    const std::string suffix = "_" + std::to_string(count);
+
+    suite.run("manager/create" + suffix, [&]() {
+        std::shared_ptr<ParameterManager> manager = std::make_shared<ParameterManager>();
+        manager->reserveIds(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            manager->createFloat32Parameter("p");
+        }
+        doNotOptimize(manager.get());
+    }, count);
+
+    suite.run("manager/create_remove" + suffix, [&]() {
+        std::shared_ptr<ParameterManager> manager = std::make_shared<ParameterManager>();
+        manager->reserveIds(count);
+        std::vector<int16_t> ids;
+        ids.reserve(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            ids.push_back(manager->createFloat32Parameter("p")->getId());
+        }
+        for (int16_t id : ids)
+        {
+            manager->removeParameter(id);
+        }
+        doNotOptimize(manager.get());
+    }, count);
+
+    // lookup of random existing ids
+    std::shared_ptr<ParameterManager> manager = std::make_shared<ParameterManager>();
+    std::vector<int16_t> ids;
+    for (size_t i = 0; i < count; i++)
+    {
+        ids.push_back(manager->createFloat32Parameter("p")->getId());
+    }
+
+    static const size_t LOOKUPS = 1000;
+    std::vector<int16_t> lookups;
+    std::mt19937 rng(SEED);
+    std::uniform_int_distribution<size_t> dist(0, ids.size() - 1);
+    for (size_t i = 0; i < LOOKUPS; i++)
+    {
+        lookups.push_back(ids[dist(rng)]);
+    }
+
+    suite.run("manager/lookup" + suffix, [&]() {
+        for (int16_t id : lookups)
+        {
+            doNotOptimize(manager->getParameter(id).get());
+        }
+    }, LOOKUPS);
+}
+
+
+//------------------------------------------------------------------
+// ParameterServer::update with changed parameters to N transporters
+static void benchFanOut(Suite& suite, size_t transporters, size_t frameSize)
+{
+    static const size_t PARAMETERS = 500;
+
+    ParameterServer server;
+    std::vector<std::unique_ptr<NullServerTransporter> > outputs;
+    for (size_t i = 0; i < transporters; i++)
+    {
+        outputs.emplace_back(new NullServerTransporter());
+        server.addTransporter(*outputs.back());
+    }
+    server.setMaxFrameSize(frameSize);
+
+    std::vector<Float32ParameterPtr> parameters;
+    server.reserveIds(PARAMETERS);
+    for (size_t i = 0; i < PARAMETERS; i++)
+    {
+        parameters.push_back(server.createFloat32Parameter("p" + std::to_string(i)));
+    }
+    server.update();
+
+    float value = 0;
+    std::string name = "server/update_fanout_" + std::to_string(transporters);
+    if (frameSize > 0)
+    {
+        name += "_frame" + std::to_string(frameSize);
+    }
+
+    suite.run(name, [&]() {
+        value += 1.f;
+        for (auto& p : parameters)
+        {
+            p->setValue(value);
+        }
+        server.update();
+    }, PARAMETERS);
+}
+
+// UPDATEVALUE received by the server, applied and forwarded
+static void benchServerReceive(Suite& suite)
+{
+    ParameterServer server;
+    NullServerTransporter transporter;
+    server.addTransporter(transporter);
+
+    Float32ParameterPtr parameter = server.createFloat32Parameter("p");
+
+    // alternate two values, so every packet is a change
+    std::vector<std::vector<char> > packets;
+    for (int i = 0; i < 2; i++)
+    {
+        Float32ParameterPtr copy = Float32Parameter::create(parameter->getId(), float(i));
+        ParameterPtr p = copy;
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(p);
+        BufferWriter writer;
+        packet.write(writer, true);
+        packets.push_back(std::vector<char>(writer.data(), writer.data() + writer.size()));
+    }
+
+    size_t n = 0;
+    suite.run("server/receive_updatevalue", [&]() {
+        const std::vector<char>& data = packets[n++ & 1];
+        server.received(data.data(), data.size(), transporter, nullptr);
+    }, 1, double(packets[0].size()));
+}
+
+
+// server update to clients over loopback transporters, including client parsing
+static void benchLoopback(Suite& suite, size_t clients)
+{
+    static const size_t PARAMETERS = 500;
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    std::vector<Float32ParameterPtr> parameters;
+    server.reserveIds(PARAMETERS);
+    for (size_t i = 0; i < PARAMETERS; i++)
+    {
+        parameters.push_back(server.createFloat32Parameter("p" + std::to_string(i)));
+    }
+    server.update();
+
+    std::vector<std::unique_ptr<LoopbackClientTransporter> > transporters;
+    std::vector<std::unique_ptr<ParameterClient> > parameter_clients;
+    for (size_t i = 0; i < clients; i++)
+    {
+        transporters.emplace_back(new LoopbackClientTransporter(server_transporter));
+        parameter_clients.emplace_back(new ParameterClient(*transporters.back()));
+        parameter_clients.back()->connect("localhost", 10000);
+    }
+
+    auto pump = [&]() {
+        size_t count;
+        do
+        {
+            count = server_transporter.process();
+            for (auto& t : transporters)
+            {
+                count += t->process();
+            }
+        } while (count > 0);
+    };
+
+    // handshake and init
+    pump();
+
+    float value = 0;
+    suite.run("loopback/update_" + std::to_string(clients), [&]() {
+        value += 1.f;
+        for (auto& p : parameters)
+        {
+            p->setValue(value);
+        }
+        server.update();
+        pump();
+    }, PARAMETERS);
+
+    parameter_clients.clear();
+    transporters.clear();
+}
+
+
+#ifdef __linux__
+// sends every message back to its sender
+class EchoReceiver : public ServerTransporterReceiver
+{
+public:
+    void received(std::istream& /*data*/, ServerTransporter& /*transporter*/, void* /*id*/) override {}
+    void received(const char* data, size_t size, ServerTransporter& transporter, void* id) override
+    {
+        transporter.sendToOne(data, size, id);
+    }
+};
+
+class ReceiveCounter : public ClientTransporterListener
+{
+public:
+    void connected() override {}
+    void disconnected() override {}
+    void received(std::istream& /*data*/) override {}
+    void received(const char* /*data*/, size_t /*size*/) override
+    {
+        count.fetch_add(1, std::memory_order_release);
+    }
+
+    std::atomic<size_t> count{0};
+};
+
+// one message to the server and back
+template<typename Server, typename Client>
+static void benchRoundtrip(Suite& suite, const std::string& name, Server& server_transporter, Client& client_transporter, int port)
+{
+    if (!suite.enabled(name))
+    {
+        return;
+    }
+
+    EchoReceiver echo;
+    server_transporter.addReceivedCb(&echo, &ServerTransporterReceiver::received);
+    server_transporter.bind(port);
+
+    ReceiveCounter counter;
+    client_transporter.addReceivedCb(&counter, &ClientTransporterListener::received);
+    client_transporter.connect("127.0.0.1", server_transporter.getPort());
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!client_transporter.isConnected() &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+
+    if (client_transporter.isConnected())
+    {
+        char message[64] = { 0 };
+        size_t expected = 0;
+
+        suite.run(name, [&]() {
+            expected++;
+            client_transporter.send(message, sizeof(message));
+            while (counter.count.load(std::memory_order_acquire) < expected)
+            {
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    client_transporter.disconnect();
+    client_transporter.removeReceivedCb(&counter);
+    server_transporter.unbind();
+    server_transporter.removeReceivedCb(&echo);
+}
+
+// bursts of packets to many clients, as ParameterServer::update() sends them
+template<typename Server>
+static void benchBroadcast(Suite& suite, const std::string& name, Server& server_transporter, size_t clients)
+{
+    if (!suite.enabled(name))
+    {
+        return;
+    }
+
+    static const size_t BURST = 16;
+
+    server_transporter.setBindAddress("127.0.0.1");
+    server_transporter.bind(0);
+
+    EventLoop loop;
+    loop.start();
+
+    ReceiveCounter counter;
+    std::vector<std::unique_ptr<TcpClientTransporter> > client_transporters;
+    for (size_t i = 0; i < clients; i++)
+    {
+        client_transporters.emplace_back(new TcpClientTransporter(loop));
+        client_transporters.back()->addReceivedCb(&counter, &ClientTransporterListener::received);
+        client_transporters.back()->connect("127.0.0.1", server_transporter.getPort());
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (server_transporter.getConnectionCount() < static_cast<int>(clients) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::yield();
+    }
+
+    if (server_transporter.getConnectionCount() == static_cast<int>(clients))
+    {
+        std::vector<SharedBuffer> packets;
+        for (size_t i = 0; i < BURST; i++)
+        {
+            packets.push_back(SharedBuffer(std::vector<char>(64, static_cast<char>(i))));
+        }
+
+        size_t expected = 0;
+
+        suite.run(name, [&]() {
+            for (const SharedBuffer& packet : packets)
+            {
+                server_transporter.sendToAll(packet, nullptr);
+            }
+
+            expected += BURST * clients;
+            while (counter.count.load(std::memory_order_acquire) < expected)
+            {
+                std::this_thread::yield();
+            }
+        }, BURST * clients, 64);
+    }
+
+    for (auto& client_transporter : client_transporters)
+    {
+        client_transporter->disconnect();
+    }
+    loop.invoke([]() {});
+
+    server_transporter.unbind();
+    loop.stop();
+}
+
+static void benchTransports(Suite& suite)
+{
+    {
+        TcpServerTransporter server_transporter;
+        server_transporter.setBindAddress("127.0.0.1");
+        TcpClientTransporter client_transporter;
+        benchRoundtrip(suite, "transport/roundtrip_tcp", server_transporter, client_transporter, 0);
+    }
+
+    {
+        UnixServerTransporter server_transporter;
+        UnixClientTransporter client_transporter;
+        benchRoundtrip(suite, "transport/roundtrip_unix", server_transporter, client_transporter, 40000 + static_cast<int>(getpid() % 20000));
+    }
+
+    {
+        ShmServerTransporter server_transporter;
+        ShmClientTransporter client_transporter;
+        benchRoundtrip(suite, "transport/roundtrip_shm", server_transporter, client_transporter, 40000 + static_cast<int>(getpid() % 20000));
+    }
+
+    if (IoUringServerTransporter::isSupported())
+    {
+        IoUringServerTransporter server_transporter;
+        server_transporter.setBindAddress("127.0.0.1");
+        TcpClientTransporter client_transporter;
+        benchRoundtrip(suite, "transport/roundtrip_iouring", server_transporter, client_transporter, 0);
+    }
+
+    {
+        TcpServerTransporter server_transporter;
+        benchBroadcast(suite, "transport/broadcast_epoll", server_transporter, 32);
+    }
+
+    if (IoUringServerTransporter::isSupported())
+    {
+        IoUringServerTransporter server_transporter;
+        benchBroadcast(suite, "transport/broadcast_iouring", server_transporter, 32);
+    }
+}
+#endif
+
+
+//------------------------------------------------------------------
+static void usage()
+{
+    std::cerr << "usage: rcp_bench [--filter <substring>] [--min-time <ms>] [--repetitions <n>]"
+                 " [--stream <file>] [--out <file.json>]\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Suite suite;
+    suite.setMinTimeMs(20);
+
+    std::string out_file;
+    std::string stream_file;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--filter" && has_value)
+        {
+            suite.setFilter(argv[++i]);
+        }
+        else if (arg == "--min-time" && has_value)
+        {
+            suite.setMinTimeMs(std::atof(argv[++i]));
+        }
+        else if (arg == "--repetitions" && has_value)
+        {
+            suite.setRepetitions(static_cast<size_t>(std::atoi(argv[++i])));
+        }
+        else if (arg == "--stream" && has_value)
+        {
+            stream_file = argv[++i];
+        }
+        else if (arg == "--out" && has_value)
+        {
+            out_file = argv[++i];
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    benchDatatypes(suite);
+    benchStream(suite, stream_file);
+
+    benchManager(suite, 1000);
+    benchManager(suite, 10000);
+    benchManager(suite, 30000);
+
+    benchServerReceive(suite);
+    benchFanOut(suite, 1, 0);
+    benchFanOut(suite, 10, 0);
+    benchFanOut(suite, 100, 0);
+    benchFanOut(suite, 10, 1400);
+
+    benchLoopback(suite, 1);
+    benchLoopback(suite, 10);
+#ifdef __linux__
+    benchTransports(suite);
+#endif
+
+    if (out_file.empty())
+    {
+        suite.writeJson(std::cout);
+    }
+    else
+    {
+        std::ofstream out(out_file);
+        suite.writeJson(out);
+    }
+
+    return 0;
+}
@@ -73,12 +73,9 @@ public:
         return m_isConnected;
     }
 
-    virtual void send(std::istream& /*data*/) override
-    {
-        std::cout << "send stream:\n";
-    }
+    using rcp::ClientTransporter::send;
 
-    virtual void send(char* data, size_t size) override
+    virtual void send(const char* data, size_t size) override
     {
         std::cout << "send: " << data << " : " << size << "\n";
     }
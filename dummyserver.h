@@ -98,13 +98,16 @@ public:
         std::cout << "ubind\n";
     }
 
-    virtual void sendToOne(std::istream& data, void* /*id*/) override
+    using rcp::ServerTransporter::sendToOne;
+    using rcp::ServerTransporter::sendToAll;
+
+    virtual void sendToOne(const char* data, size_t size, void* /*id*/) override
     {
-        logStream(data, "send to one: ");
+        std::cout << "send to one: " << rcp::value_to_string(std::vector<char>(data, data + size)) << "\n";
     }
-    virtual void sendToAll(std::istream& data, void* /*excludeId*/) override
+    virtual void sendToAll(const char* data, size_t size, void* /*excludeId*/) override
     {
-        logStream(data, "send to all: ");
+        std::cout << "send to all: " << rcp::value_to_string(std::vector<char>(data, data + size)) << "\n";
     }
 
     virtual int getConnectionCount() override
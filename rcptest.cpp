@@ -38,6 +38,12 @@
 #include <strstream>
 #include <cassert>
 #include <thread>
+#include <atomic>
+#include <cstring>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 #include "src/parameterclient.h"
 
@@ -46,6 +52,17 @@
 #include "dummyserver.h"
 #include "dummyclient.h"
 #include "src/infodata.h"
+#include "src/loopbacktransporter.h"
+#include "src/tcptransporter.h"
+#include "src/websocket.h"
+#include "src/websockettransporter.h"
+#include "src/shmring.h"
+#include "src/shmtransporter.h"
+#include "src/unixtransporter.h"
+#include "src/iouringtransporter.h"
+#include "src/multicast.h"
+#include "src/packetscanner.h"
+#include "src/outboundqueue.h"
 
 
 using namespace rcp;
@@ -577,6 +594,7 @@ void _parseStream(std::istream& stream)
     case COMMAND_MAX_:
     case COMMAND_DISCOVER:
     case COMMAND_INITIALIZE:
+    case COMMAND_SUBSCRIBE:
         std::cout << "command not handled: " << the_packet.getCommand();
         break;
 
@@ -999,6 +1017,2752 @@ void testVector4fParameter()
 }
 
 
+void testBufferWriter()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    Int8ParameterPtr param = Int8Parameter::create(1, 32);
+    param->setLabel("param label");
+    param->setDescription("param description");
+    param->setMinimum(-1);
+    param->setMaximum(111);
+    param->setUnit("CM");
+
+    Packet packet(COMMAND_UPDATE);
+    packet.setData(param);
+
+    StringStreamWriter stream_writer;
+    packet.write(stream_writer, true);
+
+    BufferWriter buffer_writer(4);
+    packet.write(buffer_writer, true);
+
+    // both writers need to produce the same bytes
+    std::string expected = stream_writer.getBuffer().str();
+    assert(expected.size() == buffer_writer.size());
+    assert(std::memcmp(expected.data(), buffer_writer.data(), buffer_writer.size()) == 0);
+
+    buffer_writer.dump();
+
+    std::cout << "\n\n";
+}
+
+void testByteReader()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    Float32ParameterPtr param = Float32Parameter::create(3);
+    param->setLabel("float");
+    param->setValue(1.5f);
+
+    Packet packet(COMMAND_UPDATE);
+    packet.setData(param);
+
+    // two packets back to back
+    BufferWriter writer;
+    packet.write(writer, true);
+    size_t first_size = writer.size();
+    packet.write(writer, true);
+
+    // parse from memory
+    ByteReader reader(writer.data(), writer.size());
+    Option<Packet> p1 = Packet::parse(reader);
+    assert(p1.hasValue());
+    assert(reader.position() == first_size);
+
+    Option<Packet> p2 = Packet::parse(reader);
+    assert(p2.hasValue());
+    assert(reader.remaining() == 0);
+
+    Float32ParameterPtr parsed = std::dynamic_pointer_cast<Float32Parameter>(p2.value().getData());
+    assert(parsed);
+    assert(parsed->getValue() == 1.5f);
+    assert(parsed->getLabel() == "float");
+
+    // stream wrapper leaves the stream after the first packet
+    std::stringstream stream;
+    stream.write(writer.data(), writer.size());
+    assert(Packet::parse(stream).hasValue());
+    assert(size_t(stream.tellg()) == first_size);
+    assert(Packet::parse(stream).hasValue());
+
+    // non-seekable stream: only the bytes of each packet are consumed
+    {
+        struct PipeBuf : public std::streambuf
+        {
+            PipeBuf(char* data, size_t size) { setg(data, data, data + size); }
+        };
+
+        std::vector<char> data(writer.data(), writer.data() + writer.size());
+        PipeBuf buf(data.data(), data.size());
+        std::istream pipe(&buf);
+        assert(pipe.tellg() == std::streampos(-1));
+
+        assert(Packet::parse(pipe).hasValue());
+        assert(pipe.good());
+        Option<Packet> second = Packet::parse(pipe);
+        assert(second.hasValue());
+        parsed = std::dynamic_pointer_cast<Float32Parameter>(second.value().getData());
+        assert(parsed && parsed->getValue() == 1.5f);
+        assert(pipe.peek() == EOF);
+    }
+
+    // std::istream overloads of the parsers
+    {
+        std::stringstream values;
+        BufferWriter value_writer;
+        value_writer.write(static_cast<int16_t>(-2));
+        value_writer.write(static_cast<char>(5));
+        value_writer.write("hello", 5);
+        value_writer.write(2.5f);
+        param->write(value_writer, true);
+        values.write(value_writer.data(), value_writer.size());
+
+        int16_t number = 0;
+        number = readFromStream(values, number);
+        assert(number == -2);
+        assert(readTinyString(values) == "hello");
+
+        Float32ParameterPtr definition = Float32Parameter::create(1);
+        assert(definition->getDefaultTypeDefinition().readValue(values) == 2.5f);
+
+        ParameterPtr read = ParameterParser::parse(values);
+        assert(read && read->getId() == 3);
+        assert(values.peek() == EOF);
+    }
+
+    // truncated data must not produce a parameter
+    ByteReader truncated(writer.data(), 4);
+    Option<Packet> p3 = Packet::parse(truncated);
+    assert(!p3.hasValue() || !p3.value().hasData());
+    assert(truncated.eof());
+
+    std::cout << "\n\n";
+}
+
+void testUpdateValue()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    ParameterServer server;
+    DummyServerTransporter serverTransporter;
+    server.addTransporter(serverTransporter);
+
+    auto fp = server.createFloat32Parameter("f32");
+    auto sp = server.createStringParameter("str");
+
+    int called = 0;
+    fp->addValueUpdatedCb([&](float&) { called++; });
+
+    // float value
+    {
+        Float32ParameterPtr proxy = Float32Parameter::create(fp->getId());
+        proxy->setValue(3.25f);
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(proxy);
+        BufferWriter writer;
+        packet.write(writer, false);
+
+        server.received(writer.data(), writer.size(), serverTransporter, nullptr);
+        assert(fp->getValue() == 3.25f);
+        assert(called == 1);
+    }
+
+    // string value
+    {
+        StringParameterPtr proxy = StringParameter::create(sp->getId());
+        proxy->setValue("fast");
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(proxy);
+        BufferWriter writer;
+        packet.write(writer, false);
+
+        server.received(writer.data(), writer.size(), serverTransporter, nullptr);
+        assert(sp->getValue() == "fast");
+    }
+
+    // type mismatch falls back and leaves the value untouched
+    {
+        Int32ParameterPtr proxy = Int32Parameter::create(fp->getId());
+        proxy->setValue(7);
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(proxy);
+        BufferWriter writer;
+        packet.write(writer, false);
+
+        server.received(writer.data(), writer.size(), serverTransporter, nullptr);
+        assert(fp->getValue() == 3.25f);
+        assert(called == 1);
+    }
+
+    std::cout << "\n\n";
+}
+
+void testIdAllocator()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    IdAllocator allocator;
+
+    // lowest free id first, 0 is never used
+    assert(allocator.allocate() == 1);
+    assert(allocator.allocate() == 2);
+    assert(allocator.allocate() == 3);
+
+    assert(allocator.release(2));
+    assert(!allocator.release(2));
+    assert(!allocator.release(0));
+    assert(allocator.allocate() == 2);
+
+    assert(!allocator.reserve(3));
+    assert(allocator.reserve(100));
+
+    // bulk
+    std::vector<int16_t> ids;
+    assert(allocator.allocate(200, ids) == 200);
+    assert(ids.front() == 4);
+    assert(std::find(ids.begin(), ids.end(), 100) == ids.end());
+
+    // exhaust all ids: 65534 usable
+    while (allocator.allocate() != 0) {}
+    assert(allocator.usedCount() == 65534);
+    assert(allocator.isUsed(0) && allocator.isUsed(-1));
+
+    assert(allocator.release(-2));
+    assert(allocator.allocate() == -2);
+    assert(allocator.allocate() == 0);
+
+    // manager with reserved ids
+    ParameterServer server;
+    assert(server.reserveIds(10) == 10);
+    auto p1 = server.createInt32Parameter("a");
+    auto p2 = server.createInt32Parameter("b");
+    assert(p1->getId() == 1);
+    assert(p2->getId() == 2);
+    server.removeParameter(p1);
+    auto p3 = server.createInt32Parameter("c");
+    assert(p3->getId() == 3);
+
+    // unused reserved ids are free again
+    server.releaseReservedIds();
+    auto p4 = server.createInt32Parameter("d");
+    assert(p4->getId() == 1);
+    auto p5 = server.createInt32Parameter("e");
+    assert(p5->getId() == 4);
+
+    std::cout << "\n\n";
+}
+
+void testParameterTable()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    ParameterTable table;
+    std::map<int16_t, ParameterPtr> map;
+
+    int16_t ids[] = { 5, -3, 300, 1, -32768, 32767, 256, 255 };
+    for (int16_t id : ids)
+    {
+        ParameterPtr p = Int32Parameter::create(id);
+        assert(table.set(id, p));
+        map[id] = p;
+    }
+    assert(!table.set(5, map[5]));
+    assert(table.size() == map.size());
+
+    // same order as std::map
+    auto map_it = map.begin();
+    for (const ParameterPtr& p : table)
+    {
+        assert(p == map_it->second);
+        map_it++;
+    }
+    assert(map_it == map.end());
+
+    assert(table.get(300) == map[300]);
+    assert(table.get(301) == nullptr);
+    assert(table.erase(300));
+    assert(!table.erase(300));
+    assert(!table.contains(300));
+    assert(table.size() == map.size() - 1);
+
+    table.clear();
+    assert(table.empty());
+    assert(table.begin() == table.end());
+
+    std::cout << "\n\n";
+}
+
+void testAtomicIdSet()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    AtomicIdSet set;
+    assert(set.empty());
+    assert(set.set(7));
+    assert(!set.set(7));
+    assert(set.set(-5));
+    assert(set.set(1000));
+    assert(set.reset(1000));
+    assert(!set.test(1000));
+
+    // drained in signed order
+    std::vector<int16_t> drained;
+    set.drain([&](int16_t id) { drained.push_back(id); });
+    assert(drained.size() == 2);
+    assert(drained[0] == -5);
+    assert(drained[1] == 7);
+    assert(set.empty());
+
+    // concurrent setters - no id is lost
+    std::vector<bool> seen(65536, false);
+    std::atomic<bool> done(false);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&set, t]() {
+            for (int i = 1 + t; i < 65535; i += 4)
+            {
+                set.set(static_cast<int16_t>(i));
+            }
+        });
+    }
+
+    std::thread drainer([&]() {
+        while (!done)
+        {
+            set.drain([&](int16_t id) { seen[static_cast<uint16_t>(id)] = true; });
+        }
+    });
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    done = true;
+    drainer.join();
+
+    set.drain([&](int16_t id) { seen[static_cast<uint16_t>(id)] = true; });
+
+    for (int i = 1; i < 65535; i++)
+    {
+        assert(seen[i]);
+    }
+
+    std::cout << "\n\n";
+}
+
+class RecordingServerTransporter : public ServerTransporter
+{
+public:
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    void bind(int /*port*/) override {}
+    void unbind() override {}
+    void sendToOne(const char* data, size_t size, void* /*id*/) override
+    {
+        sent.push_back(std::vector<char>(data, data + size));
+    }
+    void sendToAll(const char* data, size_t size, void* /*excludeId*/) override
+    {
+        sent.push_back(std::vector<char>(data, data + size));
+    }
+    void sendToOne(const SharedBuffer& buffer, void* id) override
+    {
+        shared.push_back(buffer.data());
+        sendToOne(buffer.data(), buffer.size(), id);
+    }
+    int getConnectionCount() override { return 1; }
+
+    std::vector<std::vector<char> > sent;
+    std::vector<const char*> shared;
+};
+
+void testFrames()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    ParameterServer server;
+    RecordingServerTransporter transporter;
+    server.addTransporter(transporter);
+
+    std::vector<Float32ParameterPtr> params;
+    for (int i = 0; i < 50; i++)
+    {
+        params.push_back(server.createFloat32Parameter("p" + std::to_string(i)));
+    }
+
+    // one packet per send
+    server.update();
+    assert(transporter.sent.size() == 50);
+
+    // frames
+    server.setMaxFrameSize(128);
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        params[i]->setValue(float(i));
+    }
+    transporter.sent.clear();
+    server.update();
+    assert(transporter.sent.size() > 1);
+    assert(transporter.sent.size() < 50);
+
+    for (auto& frame : transporter.sent)
+    {
+        assert(frame.size() <= 128);
+    }
+
+    // client splits frames
+    DummyClientTransporter client_transporter;
+    ParameterClient client(client_transporter);
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        // parameters are unknown to the client, send full
+        Packet packet(COMMAND_UPDATE);
+        packet.setData(params[i]);
+        BufferWriter writer;
+        packet.write(writer, true);
+        client.received(writer.data(), writer.size());
+    }
+
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        params[i]->setValue(float(i) + 100.f);
+    }
+    transporter.sent.clear();
+    server.update();
+
+    for (auto& frame : transporter.sent)
+    {
+        client.received(frame.data(), frame.size());
+    }
+
+    for (size_t i = 0; i < params.size(); i++)
+    {
+        ParameterPtr p = client.getParameter(params[i]->getId());
+        Float32ParameterPtr fp = std::dynamic_pointer_cast<Float32Parameter>(p);
+        assert(fp);
+        assert(fp->getValue() == float(i) + 100.f);
+    }
+
+    // server forwards a received frame as one range
+    transporter.sent.clear();
+    std::vector<char> frame;
+    for (size_t i = 0; i < 3; i++)
+    {
+        Float32ParameterPtr proxy = Float32Parameter::create(params[i]->getId());
+        proxy->setValue(-1.f);
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(proxy);
+        BufferWriter writer;
+        packet.write(writer, false);
+        frame.insert(frame.end(), writer.data(), writer.data() + writer.size());
+    }
+    server.received(frame.data(), frame.size(), transporter, nullptr);
+    assert(transporter.sent.size() == 1);
+    assert(transporter.sent[0] == frame);
+    assert(params[2]->getValue() == -1.f);
+
+    std::cout << "\n\n";
+}
+
+void testInitCache()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    ParameterServer server;
+    RecordingServerTransporter transporter;
+    server.addTransporter(transporter);
+
+    auto group = server.createGroupParameter("group");
+    auto p1 = server.createInt32Parameter("a", group);
+    auto p2 = server.createInt32Parameter("b");
+    server.update();
+
+    std::string init_packet;
+    init_packet.push_back(COMMAND_INITIALIZE);
+    init_packet.push_back(TERMINATOR);
+
+    // group, a, b, initialize
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 4);
+    std::vector<const char*> first = transporter.shared;
+
+    // second client gets the same buffers
+    transporter.shared.clear();
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    assert(transporter.shared == first);
+
+    // only the changed parameter is serialized again
+    p1->setValue(42);
+    server.update();
+
+    transporter.shared.clear();
+    transporter.sent.clear();
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 4);
+    assert(transporter.shared[0] == first[0]);
+    assert(transporter.shared[1] != first[1]);
+    assert(transporter.shared[2] == first[2]);
+
+    Option<Packet> packet = Packet::parse(transporter.sent[1].data(), transporter.sent[1].size());
+    assert(packet.hasValue());
+    Int32ParameterPtr parsed = std::dynamic_pointer_cast<Int32Parameter>(packet.value().getData());
+    assert(parsed && parsed->getValue() == 42);
+
+    // changes from a client are in the next init
+    {
+        Packet update_packet(COMMAND_UPDATEVALUE);
+        Int32ParameterPtr value = std::make_shared<Int32Parameter>(p1->getId());
+        value->setValue(5);
+        update_packet.setData(value);
+        BufferWriter writer;
+        update_packet.write(writer, false);
+        server.received(writer.data(), writer.size(), transporter, &transporter);
+        assert(p1->getValue() == 5);
+    }
+    server.update();
+
+    transporter.shared.clear();
+    transporter.sent.clear();
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 4);
+    packet = Packet::parse(transporter.sent[1].data(), transporter.sent[1].size());
+    assert(packet.hasValue());
+    parsed = std::dynamic_pointer_cast<Int32Parameter>(packet.value().getData());
+    assert(parsed && parsed->getValue() == 5);
+
+    // full update from a client
+    {
+        Packet update_packet(COMMAND_UPDATE);
+        Int32ParameterPtr value = std::make_shared<Int32Parameter>(p1->getId());
+        value->setValue(6);
+        update_packet.setData(value);
+        BufferWriter writer;
+        update_packet.write(writer, false);
+        server.received(writer.data(), writer.size(), transporter, &transporter);
+        assert(p1->getValue() == 6);
+    }
+
+    transporter.shared.clear();
+    transporter.sent.clear();
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    packet = Packet::parse(transporter.sent[1].data(), transporter.sent[1].size());
+    assert(packet.hasValue());
+    parsed = std::dynamic_pointer_cast<Int32Parameter>(packet.value().getData());
+    assert(parsed && parsed->getValue() == 6);
+
+    // removed parameters are gone
+    server.removeParameter(p2);
+    server.update();
+    transporter.shared.clear();
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 3);
+
+    // added parameters are in the next init
+    auto p3 = server.createInt32Parameter("c", group);
+    auto p4 = server.createInt32Parameter("d");
+    server.update();
+    transporter.shared.clear();
+    server.received(init_packet.data(), init_packet.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 5);
+
+    // discover snapshots are patched per parameter
+    auto discover_packet = [](int16_t id)
+    {
+        WriteablePtr id_data = IdData::create(id);
+        Packet packet(COMMAND_DISCOVER, id_data);
+        BufferWriter writer;
+        packet.write(writer, false);
+        return std::string(writer.data(), writer.size());
+    };
+    const std::string discover_group = discover_packet(group->getId());
+    const std::string discover_d = discover_packet(p4->getId());
+
+    // group, a, c, discover
+    transporter.shared.clear();
+    server.received(discover_group.data(), discover_group.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 4);
+    std::vector<const char*> group_first = transporter.shared;
+
+    // d, discover
+    transporter.shared.clear();
+    server.received(discover_d.data(), discover_d.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 2);
+    std::vector<const char*> d_first = transporter.shared;
+
+    // a value change replaces its slot only
+    p1->setValue(7);
+    server.update();
+
+    transporter.shared.clear();
+    server.received(discover_group.data(), discover_group.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 4);
+    assert(transporter.shared[0] == group_first[0]);
+    assert(transporter.shared[1] != group_first[1]);
+    assert(transporter.shared[2] == group_first[2]);
+    assert(transporter.shared[3] == group_first[3]);
+    group_first = transporter.shared;
+
+    transporter.shared.clear();
+    server.received(discover_d.data(), discover_d.size(), transporter, nullptr);
+    assert(transporter.shared == d_first);
+
+    // an option change drops the subtrees containing it only
+    p3->setLabel("e");
+    server.update();
+
+    transporter.shared.clear();
+    server.received(discover_d.data(), discover_d.size(), transporter, nullptr);
+    assert(transporter.shared == d_first);
+
+    transporter.shared.clear();
+    server.received(discover_group.data(), discover_group.size(), transporter, nullptr);
+    assert(transporter.shared.size() == 4);
+    assert(transporter.shared[2] != group_first[2]);
+
+    std::cout << "\n\n";
+}
+
+
+static size_t pumpLoopback(LoopbackServerTransporter& server, std::vector<LoopbackClientTransporter*> clients)
+{
+    size_t total = 0;
+    size_t count;
+    do
+    {
+        count = server.process();
+        for (auto* c : clients)
+        {
+            count += c->process();
+        }
+        total += count;
+    } while (count > 0);
+
+    return total;
+}
+
+void testLoopback()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    // wrong port
+    LoopbackClientTransporter other_transporter(server_transporter);
+    other_transporter.connect("localhost", 9999);
+    assert(!other_transporter.isConnected());
+
+    LoopbackClientTransporter transporter_a(server_transporter);
+    LoopbackClientTransporter transporter_b(server_transporter);
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+
+    client_a.connect("localhost", 10000);
+    client_b.connect("localhost", 10000);
+    assert(server_transporter.getConnectionCount() == 2);
+
+    // version handshake and init
+    assert(pumpLoopback(server_transporter, { &transporter_a, &transporter_b }) > 0);
+
+    Float32ParameterPtr value_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(value->getId()));
+    Float32ParameterPtr value_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(value->getId()));
+    assert(value_a && value_b);
+    assert(value_a->getValue() == 1.f);
+    assert(client_b.getParameter(text->getId()));
+
+    // server to clients
+    value->setValue(2.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter_a, &transporter_b });
+    assert(value_a->getValue() == 2.f);
+    assert(value_b->getValue() == 2.f);
+
+    // client to server, forwarded to the other client
+    value_a->setValue(3.f);
+    client_a.update();
+    pumpLoopback(server_transporter, { &transporter_a, &transporter_b });
+    assert(value->getValue() == 3.f);
+    assert(value_b->getValue() == 3.f);
+
+    // latency: nothing is delivered before it is due
+    server_transporter.setLatency(std::chrono::microseconds(20000));
+    value->setValue(4.f);
+    server.update();
+    assert(transporter_a.process() == 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    assert(transporter_a.process() == 1);
+    assert(value_a->getValue() == 4.f);
+    server_transporter.setLatency(std::chrono::microseconds(0));
+    pumpLoopback(server_transporter, { &transporter_a, &transporter_b });
+
+    // worker threads
+    server_transporter.startWorker();
+    transporter_a.startWorker();
+    transporter_b.startWorker();
+
+    value->setValue(5.f);
+    server.update();
+
+    for (int i = 0; i < 1000 && (value_a->getValue() != 5.f || value_b->getValue() != 5.f); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    assert(value_a->getValue() == 5.f);
+    assert(value_b->getValue() == 5.f);
+
+    transporter_a.stopWorker();
+    transporter_b.stopWorker();
+    server_transporter.stopWorker();
+    assert(server_transporter.droppedCount() == 0);
+
+    // disconnect
+    transporter_b.disconnect();
+    assert(server_transporter.getConnectionCount() == 1);
+
+    server_transporter.unbind();
+    assert(!transporter_a.isConnected());
+    transporter_a.process();
+    assert(server_transporter.getConnectionCount() == 0);
+
+    // a stuck worker does not block the producer forever
+    {
+        LoopbackConnection::Direction direction(4);
+        direction.consumerWorker.store(true);
+
+        SharedBuffer buffer("x", 1);
+        while (direction.push(buffer, LoopbackConnection::clock::duration::zero())) {}
+
+        assert(direction.dropped.load() == 1);
+    }
+
+    std::cout << "\n\n";
+}
+
+
+#ifdef __linux__
+template<typename F>
+static bool waitFor(F condition, int timeoutMs = 5000)
+{
+    for (int i = 0; i < timeoutMs; i++)
+    {
+        if (condition())
+        {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return condition();
+}
+
+class ConnectionCounter : public ServerTransporterReceiver
+{
+public:
+    void received(std::istream& /*data*/, ServerTransporter& /*transporter*/, void* /*id*/) override {}
+    void received(const char* /*data*/, size_t /*size*/, ServerTransporter& /*transporter*/, void* /*id*/) override {}
+    void clientConnected(ServerTransporter& /*transporter*/, void* id) override { connected++; last = id; }
+    void clientDisconnected(ServerTransporter& /*transporter*/, void* /*id*/) override { disconnected++; }
+
+    std::atomic<int> connected{0};
+    std::atomic<int> disconnected{0};
+    std::atomic<void*> last{nullptr};
+};
+
+void testTcp()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    TcpServerTransporter server_transporter;
+    server_transporter.setBindAddress("127.0.0.1");
+
+    ConnectionCounter counter;
+    server_transporter.addReceivedCb(&counter, &ServerTransporterReceiver::received);
+
+    ParameterServer server(server_transporter);
+    server_transporter.bind(0);
+    assert(server_transporter.isBound());
+    int port = server_transporter.getPort();
+    assert(port > 0);
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    TcpClientTransporter transporter_a;
+    TcpClientTransporter transporter_b;
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+    client_a.connect("127.0.0.1", port);
+    client_b.connect("127.0.0.1", port);
+
+    // version handshake and init
+    assert(waitFor([&]() { return client_a.getParameter(text->getId()) && client_b.getParameter(text->getId()); }));
+    assert(counter.connected == 2);
+
+    Float32ParameterPtr value_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(value->getId()));
+    Float32ParameterPtr value_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(value->getId()));
+    assert(value_a && value_b);
+    assert(value_a->getValue() == 1.f);
+
+    // server to clients
+    value->setValue(2.f);
+    server.update();
+    assert(waitFor([&]() { return value_a->getValue() == 2.f && value_b->getValue() == 2.f; }));
+
+    // client to server, forwarded to the other client
+    value_a->setValue(3.f);
+    client_a.update();
+    assert(waitFor([&]() { return value->getValue() == 3.f && value_b->getValue() == 3.f; }));
+
+    // message bigger than socket buffers
+    text->setValue(std::string(1024 * 1024, 'x'));
+    server.update();
+    StringParameterPtr text_b = std::dynamic_pointer_cast<StringParameter>(client_b.getParameter(text->getId()));
+    assert(text_b);
+    assert(waitFor([&]() { return text_b->getValue().size() == 1024 * 1024; }));
+
+    // many clients on one loop
+    {
+        EventLoop loop;
+        loop.start();
+
+        std::vector<std::unique_ptr<TcpClientTransporter> > many;
+        for (int i = 0; i < 200; i++)
+        {
+            many.emplace_back(new TcpClientTransporter(loop));
+            many.back()->connect("127.0.0.1", port);
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 202; }));
+
+        for (auto& t : many)
+        {
+            t->disconnect();
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 2; }));
+        assert(waitFor([&]() { return counter.disconnected == 200; }));
+
+        loop.stop();
+    }
+
+    // stopped from a task on the loop, joined by the owner
+    {
+        EventLoop loop;
+        loop.start();
+        loop.post([&loop]() { loop.stop(); });
+        assert(waitFor([&]() { return !loop.running(); }));
+
+        // restarts after the stopped thread is collected
+        loop.start();
+        assert(loop.running());
+        std::atomic<bool> ran{false};
+        loop.invoke([&ran]() { ran = true; });
+        assert(ran);
+    }
+
+    // server closes
+    server_transporter.unbind();
+    assert(waitFor([&]() { return !transporter_a.isConnected() && !transporter_b.isConnected(); }));
+    assert(counter.disconnected == 202);
+
+    // let the loop threads finish notifying the clients
+    transporter_a.loop().invoke([]() {});
+    transporter_b.loop().invoke([]() {});
+
+    server_transporter.removeReceivedCb(&counter);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+void testWebSocketFrames()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    // rfc 6455 sample
+    assert(WebSocket::acceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=");
+    assert(WebSocket::headerValue("GET / HTTP/1.1\r\nupgrade:  WebSocket \r\n\r\n", "Upgrade") == "WebSocket");
+
+    const uint8_t mask[4] = { 0x11, 0x22, 0x33, 0x44 };
+
+    // masked frames: fragment, ping, last fragment, then a 300 byte message
+    std::vector<char> stream;
+    auto append = [&](WebSocket::opcode_t opcode, const std::string& payload, bool fin) {
+        char header[WebSocket::MAX_HEADER_SIZE];
+        size_t header_size = WebSocket::writeHeader(header, opcode, payload.size(), fin, mask);
+        std::string masked = payload;
+        WebSocket::applyMask(&masked[0], masked.size(), mask);
+        stream.insert(stream.end(), header, header + header_size);
+        stream.insert(stream.end(), masked.begin(), masked.end());
+    };
+    append(WebSocket::OPCODE_BINARY, "ab", false);
+    append(WebSocket::OPCODE_PING, "p", true);
+    append(WebSocket::OPCODE_CONTINUATION, "cd", true);
+    append(WebSocket::OPCODE_BINARY, std::string(300, 'z'), true);
+
+    std::vector<std::string> messages;
+    std::vector<std::string> controls;
+    WebSocketParser::Handler on_message = [&](WebSocket::opcode_t, const char* data, size_t size) {
+        messages.push_back(std::string(data, size));
+    };
+    WebSocketParser::Handler on_control = [&](WebSocket::opcode_t, const char* data, size_t size) {
+        controls.push_back(std::string(data, size));
+    };
+
+    WebSocketParser parser(true, 1024);
+
+    // incomplete frame needs more data
+    assert(parser.parse(stream.data(), 1, on_message, on_control) == 0);
+
+    size_t pos = 0;
+    while (pos < stream.size())
+    {
+        size_t used = parser.parse(stream.data() + pos, stream.size() - pos, on_message, on_control);
+        assert(used != WebSocketParser::PARSE_ERROR && used > 0);
+        pos += used;
+    }
+
+    assert(messages.size() == 2);
+    assert(messages[0] == "abcd");
+    assert(messages[1] == std::string(300, 'z'));
+    assert(controls.size() == 1 && controls[0] == "p");
+
+    // clients must mask
+    char header[WebSocket::MAX_HEADER_SIZE];
+    size_t header_size = WebSocket::writeHeader(header, WebSocket::OPCODE_BINARY, 0, true, nullptr);
+    assert(parser.parse(header, header_size, on_message, on_control) == WebSocketParser::PARSE_ERROR);
+
+    // too big
+    WebSocketParser client_parser(false, 16);
+    header_size = WebSocket::writeHeader(header, WebSocket::OPCODE_BINARY, 17, true, nullptr);
+    assert(client_parser.parse(header, header_size, on_message, on_control) == WebSocketParser::PARSE_ERROR);
+
+    std::cout << "\n\n";
+}
+
+#ifdef __linux__
+void testWebSocket()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    WebSocketServerTransporter server_transporter;
+    server_transporter.setBindAddress("127.0.0.1");
+
+    ConnectionCounter counter;
+    server_transporter.addReceivedCb(&counter, &ServerTransporterReceiver::received);
+
+    ParameterServer server(server_transporter);
+    server_transporter.bind(0);
+    assert(server_transporter.isBound());
+    int port = server_transporter.getPort();
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    WebSocketClientTransporter transporter_a;
+    WebSocketClientTransporter transporter_b;
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+    client_a.connect("127.0.0.1", port);
+    client_b.connect("127.0.0.1", port);
+
+    // websocket handshake, version handshake and init
+    assert(waitFor([&]() { return client_a.getParameter(text->getId()) && client_b.getParameter(text->getId()); }));
+    assert(counter.connected == 2);
+    assert(server_transporter.getConnectionCount() == 2);
+
+    Float32ParameterPtr value_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(value->getId()));
+    Float32ParameterPtr value_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(value->getId()));
+    assert(value_a && value_b);
+
+    // server to clients
+    value->setValue(2.f);
+    server.update();
+    assert(waitFor([&]() { return value_a->getValue() == 2.f && value_b->getValue() == 2.f; }));
+
+    // client to server (masked), forwarded to the other client
+    value_a->setValue(3.f);
+    client_a.update();
+    assert(waitFor([&]() { return value->getValue() == 3.f && value_b->getValue() == 3.f; }));
+
+    // 64 bit length frames
+    text->setValue(std::string(1024 * 1024, 'x'));
+    server.update();
+    StringParameterPtr text_b = std::dynamic_pointer_cast<StringParameter>(client_b.getParameter(text->getId()));
+    assert(text_b);
+    assert(waitFor([&]() { return text_b->getValue().size() == 1024 * 1024; }));
+
+    // plain tcp client without handshake does not count as connection
+    {
+        TcpClientTransporter tcp;
+        tcp.connect("127.0.0.1", port);
+        assert(waitFor([&]() { return tcp.isConnected(); }));
+        tcp.send(SharedBuffer("hello", 5));
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assert(server_transporter.getConnectionCount() == 2);
+    }
+
+    // many clients on one loop
+    {
+        EventLoop loop;
+        loop.start();
+
+        std::vector<std::unique_ptr<WebSocketClientTransporter> > many;
+        for (int i = 0; i < 50; i++)
+        {
+            many.emplace_back(new WebSocketClientTransporter(loop));
+            many.back()->connect("127.0.0.1", port);
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 52; }));
+
+        for (auto& t : many)
+        {
+            t->disconnect();
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 2; }));
+        assert(waitFor([&]() { return counter.disconnected == 50; }));
+
+        loop.stop();
+    }
+
+    // client closes with a close frame
+    transporter_b.disconnect();
+    assert(waitFor([&]() { return server_transporter.getConnectionCount() == 1; }));
+
+    // server closes
+    server_transporter.unbind();
+    assert(waitFor([&]() { return !transporter_a.isConnected(); }));
+    assert(counter.disconnected == 52);
+
+    transporter_a.loop().invoke([]() {});
+    transporter_b.loop().invoke([]() {});
+
+    server_transporter.removeReceivedCb(&counter);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+void testShmRing()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    ShmRingControl control;
+    std::vector<char> data(256);
+    ShmRing ring(&control, data.data(), data.size());
+    ring.reset();
+
+    assert(ring.empty());
+    assert(ring.maxMessageSize() == 124);
+    assert(ring.reserve(125) == nullptr);
+
+    const char* message = nullptr;
+    size_t size = 0;
+    assert(!ring.peek(message, size));
+
+    // sizes that do not divide the capacity, so messages wrap
+    for (int round = 0; round < 100; round++)
+    {
+        std::string text(static_cast<size_t>(round % 50), static_cast<char>('a' + round % 26));
+
+        char* target = ring.reserve(text.size());
+        assert(target != nullptr);
+        std::memcpy(target, text.data(), text.size());
+        ring.commit(text.size());
+        assert(ring.write("x", 1));
+
+        assert(ring.peek(message, size));
+        assert(std::string(message, size) == text);
+        ring.release(size);
+
+        assert(ring.peek(message, size));
+        assert(size == 1 && message[0] == 'x');
+        ring.release(size);
+
+        assert(ring.empty());
+    }
+
+    // full
+    size_t count = 0;
+    while (ring.write("0123456789", 10))
+    {
+        count++;
+    }
+    assert(count == 256 / ShmRing::messageSpace(10));
+
+    // sizes written by a broken peer are not trusted
+    ring.reset();
+    assert(ring.write("abc", 3));
+    uint32_t bogus = 100;
+    std::memcpy(data.data(), &bogus, sizeof(bogus));
+    assert(!ring.peek(message, size));
+    assert(ring.corrupt());
+
+    ring.reset();
+    assert(ring.write("abc", 3));
+    bogus = 1000;
+    std::memcpy(data.data(), &bogus, sizeof(bogus));
+    control.tail.store(200);
+    assert(!ring.peek(message, size));
+    assert(ring.corrupt());
+
+    ring.reset();
+    assert(!ring.corrupt());
+    assert(ring.write("abc", 3));
+    assert(ring.peek(message, size) && size == 3);
+
+    std::cout << "\n\n";
+}
+
+#ifdef __linux__
+void testShm()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    // unique per process, tests might run in parallel
+    int port = 40000 + static_cast<int>(getpid() % 20000);
+
+    ShmServerTransporter server_transporter(4, 64 * 1024);
+
+    ConnectionCounter counter;
+    server_transporter.addReceivedCb(&counter, &ServerTransporterReceiver::received);
+
+    ParameterServer server(server_transporter);
+    server_transporter.bind(port);
+    assert(server_transporter.isBound());
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    ShmClientTransporter transporter_a;
+    ShmClientTransporter transporter_b;
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+    client_a.connect("localhost", port);
+    client_b.connect("localhost", port);
+
+    // version handshake and init
+    assert(waitFor([&]() { return client_a.getParameter(text->getId()) && client_b.getParameter(text->getId()); }));
+    assert(server_transporter.getConnectionCount() == 2);
+    assert(counter.connected == 2);
+
+    Float32ParameterPtr value_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(value->getId()));
+    Float32ParameterPtr value_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(value->getId()));
+    assert(value_a && value_b);
+
+    // server to clients
+    value->setValue(2.f);
+    server.update();
+    assert(waitFor([&]() { return value_a->getValue() == 2.f && value_b->getValue() == 2.f; }));
+
+    // client to server, forwarded to the other client
+    value_a->setValue(3.f);
+    client_a.update();
+    assert(waitFor([&]() { return value->getValue() == 3.f && value_b->getValue() == 3.f; }));
+
+    // many updates, the rings wrap
+    for (int i = 0; i < 5000; i++)
+    {
+        text->setValue(std::string(static_cast<size_t>(i % 1000), 't'));
+        server.update();
+    }
+    StringParameterPtr text_b = std::dynamic_pointer_cast<StringParameter>(client_b.getParameter(text->getId()));
+    assert(text_b);
+    assert(waitFor([&]() { return text_b->getValue().size() == 4999 % 1000; }));
+    assert(server_transporter.droppedCount() == 0);
+
+    // too big for the ring
+    text->setValue(std::string(64 * 1024, 'x'));
+    server.update();
+    assert(server_transporter.droppedCount() == 2);
+
+    // all slots taken
+    {
+        ShmClientTransporter c;
+        ShmClientTransporter d;
+        ShmClientTransporter e;
+        c.connect("localhost", port);
+        d.connect("localhost", port);
+        e.connect("localhost", port);
+        assert(waitFor([&]() { return c.isConnected() && d.isConnected(); }));
+        assert(!e.isConnected());
+        assert(server_transporter.getConnectionCount() == 4);
+    }
+    assert(waitFor([&]() { return server_transporter.getConnectionCount() == 2; }));
+
+    // client disconnects
+    transporter_b.disconnect();
+    assert(!transporter_b.isConnected());
+    assert(waitFor([&]() { return server_transporter.getConnectionCount() == 1; }));
+
+    // server closes
+    server_transporter.unbind();
+    assert(waitFor([&]() { return !transporter_a.isConnected(); }));
+    assert(counter.disconnected == counter.connected);
+
+    // let the client thread finish notifying
+    transporter_a.disconnect();
+
+    server_transporter.removeReceivedCb(&counter);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+#ifdef __linux__
+void testUnix()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    int port = 40000 + static_cast<int>(getpid() % 20000);
+
+    UnixServerTransporter server_transporter;
+
+    ConnectionCounter counter;
+    server_transporter.addReceivedCb(&counter, &ServerTransporterReceiver::received);
+
+    ParameterServer server(server_transporter);
+    server_transporter.bind(port);
+    assert(server_transporter.isBound());
+    assert(server_transporter.getPath() == UnixServerTransporter::defaultPath(port));
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    UnixClientTransporter transporter_a;
+    UnixClientTransporter transporter_b;
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+    client_a.connect("localhost", port);
+    client_b.connect(server_transporter.getPath(), 0);
+
+    // version handshake and init
+    assert(waitFor([&]() { return client_a.getParameter(text->getId()) && client_b.getParameter(text->getId()); }));
+    assert(counter.connected == 2);
+
+    Float32ParameterPtr value_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(value->getId()));
+    Float32ParameterPtr value_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(value->getId()));
+    assert(value_a && value_b);
+
+    // server to clients
+    value->setValue(2.f);
+    server.update();
+    assert(waitFor([&]() { return value_a->getValue() == 2.f && value_b->getValue() == 2.f; }));
+
+    // client to server, forwarded to the other client
+    value_a->setValue(3.f);
+    client_a.update();
+    assert(waitFor([&]() { return value->getValue() == 3.f && value_b->getValue() == 3.f; }));
+
+    // burst of packets, more than one batch
+    StringParameterPtr text_b = std::dynamic_pointer_cast<StringParameter>(client_b.getParameter(text->getId()));
+    assert(text_b);
+    for (int i = 0; i < 2000; i++)
+    {
+        text->setValue(std::string(static_cast<size_t>(i % 500), 'u'));
+        server.update();
+    }
+    assert(waitFor([&]() { return text_b->getValue().size() == 1999 % 500; }));
+
+    // packet close to the limit
+    text->setValue(std::string(100 * 1024, 'x'));
+    server.update();
+    assert(waitFor([&]() { return text_b->getValue().size() == 100 * 1024; }));
+
+    // many clients on one loop
+    {
+        EventLoop loop;
+        loop.start();
+
+        std::vector<std::unique_ptr<UnixClientTransporter> > many;
+        for (int i = 0; i < 50; i++)
+        {
+            many.emplace_back(new UnixClientTransporter(loop));
+            many.back()->connect("localhost", port);
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 52; }));
+
+        for (auto& t : many)
+        {
+            t->disconnect();
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 2; }));
+        assert(waitFor([&]() { return counter.disconnected == 50; }));
+
+        loop.stop();
+    }
+
+    // server closes
+    server_transporter.unbind();
+    assert(waitFor([&]() { return !transporter_a.isConnected() && !transporter_b.isConnected(); }));
+    assert(counter.disconnected == 52);
+
+    // let the loop threads finish notifying the clients
+    transporter_a.loop().invoke([]() {});
+    transporter_b.loop().invoke([]() {});
+
+    server_transporter.removeReceivedCb(&counter);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+#ifdef __linux__
+static void runIoUring(bool forceEpoll)
+{
+    IoUringServerTransporter server_transporter;
+    server_transporter.setBindAddress("127.0.0.1");
+    server_transporter.setForceEpoll(forceEpoll);
+
+    ConnectionCounter counter;
+    server_transporter.addReceivedCb(&counter, &ServerTransporterReceiver::received);
+
+    ParameterServer server(server_transporter);
+    server_transporter.bind(0);
+    assert(server_transporter.isBound());
+    assert(server_transporter.usingIoUring() == (!forceEpoll && IoUringServerTransporter::isSupported()));
+    int port = server_transporter.getPort();
+    assert(port > 0);
+
+    std::cout << (server_transporter.usingIoUring() ? "io_uring" : "epoll") << "\n";
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    TcpClientTransporter transporter_a;
+    TcpClientTransporter transporter_b;
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+    client_a.connect("127.0.0.1", port);
+    client_b.connect("127.0.0.1", port);
+
+    // version handshake and init
+    assert(waitFor([&]() { return client_a.getParameter(text->getId()) && client_b.getParameter(text->getId()); }));
+    assert(counter.connected == 2);
+
+    Float32ParameterPtr value_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(value->getId()));
+    Float32ParameterPtr value_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(value->getId()));
+    assert(value_a && value_b);
+    assert(value_a->getValue() == 1.f);
+
+    // server to clients
+    value->setValue(2.f);
+    server.update();
+    assert(waitFor([&]() { return value_a->getValue() == 2.f && value_b->getValue() == 2.f; }));
+
+    // client to server, forwarded to the other client
+    value_a->setValue(3.f);
+    client_a.update();
+    assert(waitFor([&]() { return value->getValue() == 3.f && value_b->getValue() == 3.f; }));
+
+    // burst of packets, more than one gathered send
+    StringParameterPtr text_b = std::dynamic_pointer_cast<StringParameter>(client_b.getParameter(text->getId()));
+    assert(text_b);
+    for (int i = 0; i < 2000; i++)
+    {
+        text->setValue(std::string(static_cast<size_t>(i % 500), 'u'));
+        server.update();
+    }
+    assert(waitFor([&]() { return text_b->getValue().size() == 1999 % 500; }));
+
+    // message bigger than socket buffers
+    text->setValue(std::string(1024 * 1024, 'x'));
+    server.update();
+    assert(waitFor([&]() { return text_b->getValue().size() == 1024 * 1024; }));
+
+    // many clients on one loop
+    {
+        EventLoop loop;
+        loop.start();
+
+        std::vector<std::unique_ptr<TcpClientTransporter> > many;
+        for (int i = 0; i < 100; i++)
+        {
+            many.emplace_back(new TcpClientTransporter(loop));
+            many.back()->connect("127.0.0.1", port);
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 102; }));
+
+        for (auto& t : many)
+        {
+            t->disconnect();
+        }
+        assert(waitFor([&]() { return server_transporter.getConnectionCount() == 2; }));
+        assert(waitFor([&]() { return counter.disconnected == 100; }));
+
+        loop.stop();
+    }
+
+    // server closes
+    server_transporter.unbind();
+    assert(!server_transporter.isBound());
+    assert(waitFor([&]() { return !transporter_a.isConnected() && !transporter_b.isConnected(); }));
+    assert(counter.disconnected == 102);
+
+    // let the loop threads finish notifying the clients
+    transporter_a.loop().invoke([]() {});
+    transporter_b.loop().invoke([]() {});
+
+    server_transporter.removeReceivedCb(&counter);
+}
+
+void testIoUring()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    runIoUring(false);
+    runIoUring(true);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+void testMulticastHeader()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    char header[Multicast::HEADER_SIZE];
+    Multicast::writeHeader(header, 0xA1B2C3D4, 0xFFFFFFFE);
+
+    uint32_t session = 0;
+    uint32_t sequence = 0;
+    assert(Multicast::readHeader(header, sizeof(header), session, sequence));
+    assert(session == 0xA1B2C3D4);
+    assert(sequence == 0xFFFFFFFE);
+    assert(!Multicast::readHeader(header, sizeof(header) - 1, session, sequence));
+
+    char nack[Multicast::NACK_SIZE];
+    Multicast::writeNack(nack, 7, 100, 3);
+
+    uint32_t first = 0;
+    uint32_t count = 0;
+    assert(Multicast::readNack(nack, sizeof(nack), session, first, count));
+    assert(session == 7 && first == 100 && count == 3);
+
+    char heartbeat[Multicast::HEARTBEAT_SIZE];
+    Multicast::writeHeartbeat(heartbeat, 9, 42);
+    assert(Multicast::readHeartbeat(heartbeat, sizeof(heartbeat), session, sequence));
+    assert(session == 9 && sequence == 42);
+
+    // one format is not mistaken for the other
+    assert(!Multicast::readHeader(nack, sizeof(nack), session, sequence));
+    assert(!Multicast::readNack(header, sizeof(header), session, first, count));
+    assert(!Multicast::readHeader(heartbeat, sizeof(heartbeat), session, sequence));
+    assert(!Multicast::readHeartbeat(header, sizeof(header), session, sequence));
+
+    std::cout << "\n\n";
+}
+
+
+#ifdef __linux__
+void testMulticast()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    std::string group = "239.255.82.67";
+    int group_port = 40000 + static_cast<int>(getpid() % 20000);
+
+    MulticastSender sender;
+    if (!sender.open(group, group_port, "127.0.0.1"))
+    {
+        std::cout << "multicast not available, skipped\n\n";
+        return;
+    }
+
+    TcpServerTransporter server_transporter;
+    server_transporter.setBindAddress("127.0.0.1");
+    ParameterServer server(server_transporter);
+    server.setValueChannel(&sender);
+    server_transporter.bind(0);
+    assert(server_transporter.isBound());
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    Int32ParameterPtr other = server.createInt32Parameter("other");
+    StringParameterPtr big = server.createStringParameter("big");
+    server.update();
+
+    TcpClientTransporter transporter;
+    ParameterClient client(transporter);
+
+    // same loop as the transporter, the client is used from one thread
+    MulticastReceiver receiver(transporter.loop());
+    receiver.setListener(&client);
+    assert(receiver.open(group, group_port, "127.0.0.1"));
+
+    client.connect("127.0.0.1", server_transporter.getPort());
+    assert(waitFor([&]() { return client.getParameter(big->getId()) != nullptr; }));
+
+    Float32ParameterPtr value_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(value->getId()));
+    Int32ParameterPtr other_c = std::dynamic_pointer_cast<Int32Parameter>(client.getParameter(other->getId()));
+    StringParameterPtr big_c = std::dynamic_pointer_cast<StringParameter>(client.getParameter(big->getId()));
+    assert(value_c && other_c && big_c);
+    assert(value_c->getValue() == 1.f);
+
+    // values on the group
+    size_t sent = sender.datagramsSent();
+    value->setValue(2.f);
+    other->setValue(20);
+    server.update();
+    assert(sender.datagramsSent() == sent + 1);
+    assert(waitFor([&]() { return value_c->getValue() == 2.f && other_c->getValue() == 20; }));
+    assert(receiver.receivedCount() == 1);
+
+    // too big for a datagram, sent reliable
+    big->setValue(std::string(4000, 'b'));
+    server.update();
+    assert(waitFor([&]() { return big_c->getValue().size() == 4000; }));
+    assert(sender.datagramsSent() == sent + 1);
+
+    // structure stays on the transporter
+    value->setLabel("renamed");
+    server.update();
+    assert(waitFor([&]() { return value_c->getLabel() == "renamed"; }));
+    assert(sender.datagramsSent() == sent + 1);
+
+    // lose a datagram while the receiver is closed
+    receiver.close();
+    other->setValue(30);
+    server.update();
+    assert(sender.datagramsSent() == sent + 2);
+
+    assert(receiver.open(group, group_port, "127.0.0.1"));
+    value->setValue(3.f);
+    server.update();
+    assert(waitFor([&]() { return value_c->getValue() == 3.f; }));
+    assert(receiver.lostCount() == 1);
+    assert(other_c->getValue() == 20);
+
+    // the loss report makes the next update resend the lost value
+    assert(waitFor([&]() {
+        server.update();
+        return other_c->getValue() == 30;
+    }));
+    assert(sender.resyncRequests() == 1);
+
+    // lose the last datagram, the heartbeat of the idle sender reveals it
+    sender.setHeartbeatInterval(10);
+    receiver.close();
+    sent = sender.datagramsSent();
+    other->setValue(40);
+    server.update();
+    assert(sender.datagramsSent() == sent + 1);
+
+    assert(receiver.open(group, group_port, "127.0.0.1"));
+    assert(waitFor([&]() {
+        server.update();
+        return other_c->getValue() == 40;
+    }));
+    assert(sender.heartbeatsSent() > 0);
+    assert(receiver.heartbeatCount() > 0);
+    assert(receiver.lostCount() == 2);
+    assert(sender.resyncRequests() == 2);
+
+    receiver.close();
+    client.disconnect();
+    assert(waitFor([&]() { return !transporter.isConnected(); }));
+    transporter.loop().invoke([]() {});
+
+    server_transporter.unbind();
+    server.setValueChannel(nullptr);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+// packets of all supported kinds back to back
+static std::vector<size_t> writeScannerPackets(BufferWriter& writer)
+{
+    std::vector<size_t> sizes;
+
+    auto add = [&](Packet& packet) {
+        size_t start = writer.size();
+        packet.write(writer, true);
+        sizes.push_back(writer.size() - start);
+    };
+
+    auto update = [&](const WriteablePtr& param) {
+        Packet packet(COMMAND_UPDATE);
+        packet.setData(param);
+        add(packet);
+    };
+
+    auto updateValue = [&](const WriteablePtr& param) {
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(param);
+        add(packet);
+    };
+
+    {
+        Packet packet(COMMAND_INFO);
+        packet.setTimestamp(1234);
+        packet.setData(InfoData::create("0.0.0", "scanner"));
+        add(packet);
+    }
+    {
+        Packet packet(COMMAND_INITIALIZE);
+        add(packet);
+    }
+    {
+        Packet packet(COMMAND_REMOVE);
+        packet.setData(IdData::create(7));
+        add(packet);
+    }
+
+    Float32ParameterPtr f = Float32Parameter::create(1);
+    f->setValue(1.5f);
+    f->setLabel("float");
+    f->setLanguageLabel("deu", "fliess");
+    f->setDescription("a float");
+    f->setDescriptionLanguage("deu", "eine zahl");
+    f->setTags("a b");
+    f->setOrder(3);
+    f->setUserdata(std::vector<char>(300, 'u'));
+    f->setUserid("user");
+    f->setReadonly(true);
+    f->setMinimum(-1.f);
+    f->setMaximum(10.f);
+    f->setUnit("m");
+    f->setScale(NUMBER_SCALE_LOGARITHMIC);
+    update(f);
+    updateValue(f);
+
+    Int64ParameterPtr i64 = Int64Parameter::create(2);
+    i64->setValue(-5);
+    i64->setMultipleof(5);
+    update(i64);
+    updateValue(i64);
+
+    StringParameterPtr s = StringParameter::create(3);
+    s->setValue(std::string(1000, 's'));
+    s->getDefaultTypeDefinition().setDefault("default");
+    s->getDefaultTypeDefinition().setRegex(".*");
+    update(s);
+    updateValue(s);
+
+    EnumParameterPtr e = EnumParameter::create(4);
+    e->getDefaultTypeDefinition().setOptions({"one", "two", "three"});
+    e->getDefaultTypeDefinition().setMultiselect(false);
+    e->setValue("two");
+    update(e);
+    updateValue(e);
+
+    URIParameterPtr u = URIParameter::create(5);
+    u->getDefaultTypeDefinition().setFilter("*.txt");
+    u->getDefaultTypeDefinition().setSchemas({"file", "http"});
+    u->setValue("file:///tmp");
+    update(u);
+    updateValue(u);
+
+    RGBAParameterPtr rgba = RGBAParameter::create(6);
+    rgba->setValue(Color(0x11223344));
+    update(rgba);
+    updateValue(rgba);
+
+    BooleanParameterPtr b = BooleanParameter::create(7);
+    b->setValue(true);
+    update(b);
+    updateValue(b);
+
+    IPv4ParameterPtr ip4 = IPv4Parameter::create(8);
+    ip4->setValue(IPv4(0x7F000001));
+    update(ip4);
+
+    IPv6ParameterPtr ip6 = IPv6Parameter::create(9);
+    ip6->setValue(IPv6(1, 2, 3, 4));
+    update(ip6);
+    updateValue(ip6);
+
+    Vector3F32ParameterPtr v3 = Vector3F32Parameter::create(10);
+    v3->setValue(Vector3<float>(1.f, 2.f, 3.f));
+    update(v3);
+    updateValue(v3);
+
+    std::shared_ptr<RangeParameter<float> > range = std::make_shared<RangeParameter<float> >(11);
+    range->setValue(Range<float>(1.f, 2.f));
+    range->setDefault(Range<float>(0.f, 1.f));
+    range->setElementDefault(0.5f);
+    range->setMinimum(0.f);
+    update(range);
+    updateValue(range);
+
+    char uuid[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f'};
+    CustomParameterPtr custom = CustomParameter::create(12, 6);
+    custom->getDefaultTypeDefinition().setUuid(uuid, 16);
+    custom->setConfig(std::vector<char>(3, 'c'));
+    custom->setDefault(std::vector<char>(6, 'd'));
+    custom->setValue(std::vector<char>(6, 'v'));
+    update(custom);
+    updateValue(custom);
+
+    update(std::make_shared<GroupParameter>(13));
+    update(std::make_shared<BangParameter>(14));
+
+    return sizes;
+}
+
+void testPacketScanner()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    BufferWriter writer;
+    std::vector<size_t> sizes = writeScannerPackets(writer);
+    const char* data = writer.data();
+    size_t total = writer.size();
+
+    // every packet is found and parses to its end
+    {
+        size_t offset = 0;
+        for (size_t size : sizes)
+        {
+            PacketScanner scanner;
+            assert(scanner.scan(data + offset, total - offset) == size);
+            assert(scanner.isComplete());
+            assert(!scanner.hasError());
+            assert(scanner.packetSize() == size);
+
+            // the parser does not read range update values yet
+            if (data[offset] != COMMAND_UPDATEVALUE ||
+                data[offset + 3] != DATATYPE_RANGE)
+            {
+                ByteReader reader(data + offset, size);
+                Option<Packet> packet = Packet::parse(reader);
+                assert(packet.hasValue());
+                assert(reader.position() == size);
+            }
+
+            offset += size;
+        }
+        assert(offset == total);
+    }
+
+    // same packets for any chunking
+    auto check = [&](const std::vector<size_t>& chunks) {
+        PacketScanner scanner;
+        size_t offset = 0;
+        size_t index = 0;
+        size_t checked = 0;
+
+        for (size_t chunk : chunks)
+        {
+            assert(scanner.feed(data + offset, chunk, [&](const char* packet, size_t size) {
+                assert(index < sizes.size());
+                assert(size == sizes[index]);
+                assert(std::memcmp(packet, data + checked, size) == 0);
+                checked += size;
+                index++;
+            }));
+            offset += chunk;
+        }
+
+        assert(offset == total);
+        assert(index == sizes.size());
+        assert(scanner.pending() == 0);
+    };
+
+    check({total});
+
+    for (size_t chunk = 1; chunk <= 7; chunk++)
+    {
+        std::vector<size_t> chunks(total / chunk, chunk);
+        if (total % chunk)
+        {
+            chunks.push_back(total % chunk);
+        }
+        check(chunks);
+    }
+
+    for (size_t split = 0; split <= total; split++)
+    {
+        check({split, total - split});
+    }
+
+    // in place, growing data as in a socket read buffer
+    {
+        PacketScanner scanner;
+        size_t start = 0;
+        size_t index = 0;
+
+        for (size_t available = 1; available <= total; available++)
+        {
+            size_t scanned = scanner.packetSize();
+            scanner.scan(data + start + scanned, available - start - scanned);
+
+            if (scanner.isComplete())
+            {
+                assert(scanner.packetSize() == sizes[index]);
+                start += scanner.packetSize();
+                index++;
+                scanner.reset();
+            }
+        }
+
+        assert(index == sizes.size());
+    }
+
+    // malformed
+    {
+        PacketScanner scanner;
+        char invalid[] = {COMMAND_MAX_, TERMINATOR};
+        assert(!scanner.feed(invalid, sizeof(invalid), [](const char*, size_t) { assert(false); }));
+        assert(scanner.hasError());
+
+        scanner.reset();
+        char option[] = {COMMAND_INITIALIZE, 99, TERMINATOR};
+        assert(!scanner.feed(option, sizeof(option), [](const char*, size_t) { assert(false); }));
+    }
+
+    // size limit
+    {
+        PacketScanner scanner;
+        scanner.setMaxPacketSize(sizes[0] - 1);
+        assert(!scanner.feed(data, sizes[0], [](const char*, size_t) { assert(false); }));
+    }
+
+    std::cout << "\n\n";
+}
+
+
+#ifdef __linux__
+void testTcpUnframed()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    TcpServerTransporter server_transporter;
+    server_transporter.setBindAddress("127.0.0.1");
+    server_transporter.setLengthPrefix(false);
+
+    ParameterServer server(server_transporter);
+    server_transporter.bind(0);
+    assert(server_transporter.isBound());
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    TcpClientTransporter transporter;
+    transporter.setLengthPrefix(false);
+    ParameterClient client(transporter);
+    client.connect("127.0.0.1", server_transporter.getPort());
+
+    assert(waitFor([&]() { return client.getParameter(text->getId()) != nullptr; }));
+
+    Float32ParameterPtr value_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(value->getId()));
+    StringParameterPtr text_c = std::dynamic_pointer_cast<StringParameter>(client.getParameter(text->getId()));
+    assert(value_c && text_c);
+    assert(value_c->getValue() == 1.f);
+
+    // many packets per read
+    for (int i = 0; i < 100; i++)
+    {
+        value->setValue(float(i));
+        server.update();
+    }
+    assert(waitFor([&]() { return value_c->getValue() == 99.f; }));
+
+    // one packet over many reads
+    text->setValue(std::string(1024 * 1024, 'x'));
+    server.update();
+    assert(waitFor([&]() { return text_c->getValue().size() == 1024 * 1024; }));
+
+    // client to server
+    value_c->setValue(-1.f);
+    client.update();
+    assert(waitFor([&]() { return value->getValue() == -1.f; }));
+
+    transporter.disconnect();
+    assert(waitFor([&]() { return server_transporter.getConnectionCount() == 0; }));
+
+    server_transporter.unbind();
+    transporter.loop().invoke([]() {});
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+class PacketErrorCounter : public ParsingErrorListener
+{
+public:
+    void parsingError() override { count++; }
+    void packetError(const PacketError& error) override { errors.push_back(error); }
+
+    int count{0};
+    std::vector<PacketError> errors;
+};
+
+void testReceivePackets()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    auto write = [](BufferWriter& writer, command_t command, const WriteablePtr& data) {
+        Packet packet(command);
+        packet.setData(data);
+        size_t start = writer.size();
+        packet.write(writer, true);
+        return writer.size() - start;
+    };
+
+    // not supported by the parser, but its end can be found
+    std::shared_ptr<RangeParameter<float> > range = std::make_shared<RangeParameter<float> >(100);
+    range->setValue(Range<float>(1.f, 2.f));
+
+    // server
+    {
+        ParameterServer server;
+        DummyServerTransporter transporter;
+        server.addTransporter(transporter);
+
+        PacketErrorCounter counter;
+        server.addParsingErrorCb(&counter, &ParsingErrorListener::parsingError);
+
+        auto fp = server.createFloat32Parameter("f32");
+        auto sp = server.createStringParameter("str");
+
+        Float32ParameterPtr f = Float32Parameter::create(fp->getId());
+        f->setValue(2.5f);
+        StringParameterPtr s = StringParameter::create(sp->getId());
+        s->setValue("after");
+
+        BufferWriter writer;
+        size_t first = write(writer, COMMAND_UPDATEVALUE, f);
+        size_t broken = write(writer, COMMAND_UPDATEVALUE, range);
+        write(writer, COMMAND_UPDATEVALUE, s);
+        size_t truncated_offset = writer.size();
+        writer.write(static_cast<char>(COMMAND_UPDATEVALUE));
+        writer.write(static_cast<char>(0));
+
+        size_t applied = server.receivePackets(writer.data(), writer.size(), transporter, nullptr);
+        assert(applied == 2);
+        assert(fp->getValue() == 2.5f);
+        assert(sp->getValue() == "after");
+
+        assert(counter.count == 2);
+        assert(counter.errors.size() == 2);
+        assert(counter.errors[0].index == 1);
+        assert(counter.errors[0].offset == first);
+        assert(counter.errors[0].size == broken);
+        assert(counter.errors[0].command == COMMAND_UPDATEVALUE);
+        assert(counter.errors[1].index == 3);
+        assert(counter.errors[1].offset == truncated_offset);
+        assert(counter.errors[1].size == 0);
+
+        server.removeParsingErrorCb(&counter);
+    }
+
+    // client
+    {
+        DummyClientTransporter transporter;
+        ParameterClient client(transporter);
+
+        PacketErrorCounter counter;
+        client.addParsingErrorCb(&counter, &ParsingErrorListener::parsingError);
+
+        Float32ParameterPtr f = Float32Parameter::create(1);
+        f->setLabel("f32");
+        f->setValue(1.f);
+
+        Float32ParameterPtr v = Float32Parameter::create(1);
+        v->setValue(3.f);
+
+        BufferWriter writer;
+        write(writer, COMMAND_UPDATE, f);
+        write(writer, COMMAND_UPDATEVALUE, range);
+        write(writer, COMMAND_UPDATEVALUE, v);
+
+        assert(client.receivePackets(writer.data(), writer.size()) == 2);
+
+        Float32ParameterPtr cached = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(1));
+        assert(cached);
+        assert(cached->getValue() == 3.f);
+        assert(counter.errors.size() == 1);
+        assert(counter.errors[0].index == 1);
+
+        client.removeParsingErrorCb(&counter);
+    }
+
+    std::cout << "\n\n";
+}
+
+
+void testOutboundQueue()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    auto keyed = [](char c, size_t size, int32_t key) {
+        SharedBuffer buffer(std::vector<char>(size, c));
+        buffer.setKey(key);
+        return buffer;
+    };
+
+    auto contents = [](const OutboundQueue& queue) {
+        std::string out;
+        queue.forEachSegment([&out](const char* data, size_t size) {
+            out.append(data, size);
+            return true;
+        });
+        return out;
+    };
+
+    // unlimited
+    {
+        OutboundQueue queue;
+        assert(queue.push("h", 1, keyed('a', 3, 1)));
+        assert(queue.push(nullptr, 0, keyed('b', 2, 1)));
+        assert(queue.messages() == 2);
+        assert(queue.bytes() == 6);
+        assert(contents(queue) == "haaabb");
+
+        // partly written
+        queue.consume(2);
+        assert(contents(queue) == "aabb");
+        queue.consume(2);
+        assert(queue.messages() == 1);
+        assert(contents(queue) == "bb");
+        queue.consume(2);
+        assert(queue.empty());
+        assert(queue.bytes() == 0);
+
+        // stops when asked to
+        queue.push(nullptr, 0, keyed('a', 1, 1));
+        queue.push(nullptr, 0, keyed('b', 1, 1));
+        int segments = 0;
+        queue.forEachSegment([&segments](const char*, size_t) { segments++; return false; });
+        assert(segments == 1);
+        assert(queue.stats().collapsed == 0);
+    }
+
+    // collapsing
+    {
+        OutboundQueue queue;
+        queue.setBudget(10);
+
+        assert(queue.push(nullptr, 0, keyed('a', 4, 1)));
+        assert(queue.push(nullptr, 0, keyed('x', 2, SharedBuffer::NO_KEY)));
+        assert(queue.push(nullptr, 0, keyed('b', 4, 2)));
+        // over budget: first value of 1 is outdated
+        assert(queue.push(nullptr, 0, keyed('c', 4, 1)));
+        assert(contents(queue) == "xxbbbbcccc");
+        assert(queue.stats().collapsed == 1);
+
+        // the front message is partly written and stays
+        queue.consume(1);
+        assert(queue.push(nullptr, 0, keyed('d', 4, 2)));
+        assert(contents(queue) == "xccccdddd");
+        assert(queue.stats().collapsed == 2);
+
+        // nothing to collapse, accepted while the queue was within budget
+        assert(queue.push(nullptr, 0, keyed('y', 4, SharedBuffer::NO_KEY)));
+        assert(!queue.push(nullptr, 0, keyed('z', 4, SharedBuffer::NO_KEY)));
+        assert(contents(queue) == "xccccddddyyyy");
+
+        OutboundQueue::Stats stats = queue.stats();
+        assert(stats.bytes == 13);
+        assert(stats.messages == 4);
+        assert(stats.overflows == 1);
+        assert(stats.peakBytes == 13);
+    }
+
+    // a single message bigger than the budget
+    {
+        OutboundQueue queue;
+        queue.setBudget(4);
+        assert(queue.push(nullptr, 0, keyed('a', 8, SharedBuffer::NO_KEY)));
+        assert(!queue.push(nullptr, 0, keyed('b', 1, SharedBuffer::NO_KEY)));
+        queue.clear();
+        assert(queue.empty());
+        assert(queue.push(nullptr, 0, keyed('b', 1, SharedBuffer::NO_KEY)));
+    }
+
+    // copies keep the key
+    {
+        SharedBuffer buffer = keyed('a', 1, 42);
+        SharedBuffer copy = buffer;
+        assert(copy.key() == 42);
+        assert(SharedBuffer().key() == SharedBuffer::NO_KEY);
+    }
+
+    std::cout << "\n\n";
+}
+
+#ifdef __linux__
+void testTcpSlowConsumer()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    const size_t budget = 1024 * 1024;
+    const size_t message_size = 16 * 1024;
+
+    TcpServerTransporter server_transporter;
+    server_transporter.setBindAddress("127.0.0.1");
+    server_transporter.setQueueBudget(budget);
+
+    ConnectionCounter counter;
+    server_transporter.addReceivedCb(&counter, &ServerTransporterReceiver::received);
+
+    server_transporter.bind(0);
+    assert(server_transporter.isBound());
+
+    // connects, never reads
+    int fd = TcpSocket::connect("127.0.0.1", server_transporter.getPort());
+    assert(fd >= 0);
+    assert(waitFor([&]() { return counter.connected == 1; }));
+    void* id = counter.last;
+
+    SharedBuffer filler(std::vector<char>(message_size, 'x'));
+    OutboundQueue::Stats stats;
+
+    // fill the socket buffers until messages stay queued
+    for (int i = 0; i < 10000; i++)
+    {
+        server_transporter.sendToAll(filler, nullptr);
+        assert(server_transporter.getQueueStats(id, stats));
+        if (stats.bytes > 0)
+        {
+            break;
+        }
+    }
+    assert(stats.bytes > 0);
+
+    // values of one parameter replace each other
+    for (int i = 0; i < 200; i++)
+    {
+        SharedBuffer value(std::vector<char>(message_size, 'v'));
+        value.setKey(7);
+        server_transporter.sendToAll(value, nullptr);
+    }
+
+    assert(server_transporter.getQueueStats(id, stats));
+    assert(stats.collapsed > 0);
+    assert(stats.bytes <= budget + message_size);
+    assert(server_transporter.slowConsumerCount() == 0);
+
+    // other messages can not be collapsed, the connection is closed
+    for (int i = 0; i < 200; i++)
+    {
+        server_transporter.sendToAll(filler, nullptr);
+    }
+
+    assert(waitFor([&]() { return server_transporter.slowConsumerCount() == 1; }));
+    assert(server_transporter.getConnectionCount() == 0);
+    assert(counter.disconnected == 1);
+    assert(!server_transporter.getQueueStats(id, stats));
+
+    TcpSocket::close(fd);
+    server_transporter.unbind();
+    server_transporter.removeReceivedCb(&counter);
+
+    std::cout << "\n\n";
+}
+#endif
+
+
+void testSender()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setValue(1.f);
+    StringParameterPtr text = server.createStringParameter("text");
+    server.update();
+
+    LoopbackClientTransporter transporter(server_transporter);
+    ParameterClient client(transporter);
+    client.connect("localhost", 10000);
+    pumpLoopback(server_transporter, { &transporter });
+
+    Float32ParameterPtr value_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(value->getId()));
+    StringParameterPtr text_c = std::dynamic_pointer_cast<StringParameter>(client.getParameter(text->getId()));
+    assert(value_c && text_c);
+
+    // sent from the sender thread, delivered by pumping here
+    auto pumpUntil = [&](std::function<bool()> condition) {
+        for (int i = 0; i < 5000; i++)
+        {
+            pumpLoopback(server_transporter, { &transporter });
+            if (condition())
+            {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    };
+
+    server.startSender();
+    assert(server.isSenderRunning());
+
+    // every update() hands off, the last value arrives
+    for (int i = 0; i < 1000; i++)
+    {
+        value->setValue(float(i));
+        server.update();
+    }
+    assert(pumpUntil([&]() { return value_c->getValue() == 999.f; }));
+
+    text->setValue("pipelined");
+    server.update();
+    assert(pumpUntil([&]() { return text_c->getValue() == "pipelined"; }));
+
+    // removes go through the sender as well
+    server.removeParameter(text);
+    server.update();
+    assert(pumpUntil([&]() { return client.getParameter(text->getId()) == nullptr; }));
+
+    ParameterServer::SenderStats stats = server.getSenderStats();
+    assert(stats.batches > 0);
+    assert(stats.batches + stats.queueFull <= 1002);
+    assert(stats.handOffMaxNs <= stats.handOffNs);
+    assert(stats.serializeMaxNs <= stats.serializeNs);
+    assert(stats.sendMaxNs <= stats.sendNs);
+
+    // changes handed off before stopping are sent
+    value->setValue(-1.f);
+    server.update();
+    server.stopSender();
+    assert(!server.isSenderRunning());
+    assert(pumpUntil([&]() { return value_c->getValue() == -1.f; }));
+
+    // synchronous again
+    value->setValue(-2.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(value_c->getValue() == -2.f);
+
+    // sender collects on its own tick
+    server.startSender(5);
+    value->setValue(-3.f);
+    assert(pumpUntil([&]() { return value_c->getValue() == -3.f; }));
+    server.stopSender();
+
+    // update() from several threads
+    server.startSender();
+    {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+        {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < 200; i++)
+                {
+                    value->setValue(float(i));
+                    server.update();
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+    // a full queue leaves the change for the next update()
+    value->setValue(-4.f);
+    assert(pumpUntil([&]() { server.update(); return value_c->getValue() == -4.f; }));
+    server.stopSender();
+
+    std::cout << "\n\n";
+}
+
+
+void testRateLimit()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    Float32ParameterPtr limited = server.createFloat32Parameter("limited");
+    Float32ParameterPtr unlimited = server.createFloat32Parameter("unlimited");
+    GroupParameterPtr group = server.createGroupParameter("group");
+    Float32ParameterPtr member = server.createFloat32Parameter("member", group);
+    Float32ParameterPtr member2 = server.createFloat32Parameter("member2", group);
+    server.update();
+
+    LoopbackClientTransporter transporter(server_transporter);
+    ParameterClient client(transporter);
+    client.connect("localhost", 10000);
+    pumpLoopback(server_transporter, { &transporter });
+
+    Float32ParameterPtr limited_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(limited->getId()));
+    Float32ParameterPtr unlimited_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(unlimited->getId()));
+    Float32ParameterPtr member_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(member->getId()));
+    Float32ParameterPtr member2_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(member2->getId()));
+    assert(limited_c && unlimited_c && member_c && member2_c);
+
+    // 5 updates per second: 200ms interval
+    server.setMaxUpdateRate(limited->getId(), 5.f);
+    server.setMaxUpdateRate(group->getId(), 5.f);
+    assert(server.getMaxUpdateRate(limited->getId()) == 5.f);
+    assert(server.getMaxUpdateRate(unlimited->getId()) == 0.f);
+
+    auto set = [&](float value) {
+        limited->setValue(value);
+        unlimited->setValue(value);
+        member->setValue(value);
+        member2->setValue(value);
+        server.update();
+        pumpLoopback(server_transporter, { &transporter });
+    };
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    // first change goes out, the group limit is per parameter
+    set(1.f);
+    assert(limited_c->getValue() == 1.f);
+    assert(member_c->getValue() == 1.f);
+    assert(member2_c->getValue() == 1.f);
+
+    // changes within the interval are held back, the last one wins
+    set(2.f);
+    set(3.f);
+    if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(150))
+    {
+        assert(limited_c->getValue() == 1.f);
+        assert(member_c->getValue() == 1.f);
+        assert(member2_c->getValue() == 1.f);
+    }
+    assert(unlimited_c->getValue() == 3.f);
+
+    // final value after the interval
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(limited_c->getValue() == 3.f);
+    assert(member_c->getValue() == 3.f);
+    assert(member2_c->getValue() == 3.f);
+
+    // parameters added later inherit the group limit
+    start = std::chrono::steady_clock::now();
+    Float32ParameterPtr late = server.createFloat32Parameter("late", group);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    Float32ParameterPtr late_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(late->getId()));
+    assert(late_c);
+
+    late->setValue(1.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(150))
+    {
+        assert(late_c->getValue() == 0.f);
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(late_c->getValue() == 1.f);
+
+    // own limit wins over the group one
+    server.setMaxUpdateRate(late->getId(), 1000.f);
+    assert(server.getMaxUpdateRate(late->getId()) == 1000.f);
+    late->setValue(2.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    late->setValue(3.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(late_c->getValue() == 3.f);
+
+    // no limit
+    server.setMaxUpdateRate(limited->getId(), 0.f);
+    server.setMaxUpdateRate(group->getId(), 0.f);
+    set(4.f);
+    set(5.f);
+    assert(limited_c->getValue() == 5.f);
+    assert(member_c->getValue() == 5.f);
+
+    // removed parameters take their limits with them
+    server.setMaxUpdateRate(group->getId(), 5.f);
+    server.setMaxUpdateRate(member->getId(), 5.f);
+    set(6.f);
+
+    int16_t group_id = group->getId();
+    int16_t member_id = member->getId();
+    server.removeParameter(group);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+
+    // lowest free ids are reused
+    Float32ParameterPtr reused_a = server.createFloat32Parameter("reused_a");
+    Float32ParameterPtr reused_b = server.createFloat32Parameter("reused_b");
+    assert((reused_a->getId() == group_id && reused_b->getId() == member_id) ||
+           (reused_a->getId() == member_id && reused_b->getId() == group_id));
+    assert(server.getMaxUpdateRate(group_id) == 0.f);
+    assert(server.getMaxUpdateRate(member_id) == 0.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+
+    Float32ParameterPtr reused_a_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(reused_a->getId()));
+    Float32ParameterPtr reused_b_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(reused_b->getId()));
+    assert(reused_a_c && reused_b_c);
+
+    // no stale last update: changes go out right away
+    reused_a->setValue(7.f);
+    reused_b->setValue(7.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    reused_a->setValue(8.f);
+    reused_b->setValue(8.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(reused_a_c->getValue() == 8.f);
+    assert(reused_b_c->getValue() == 8.f);
+
+    std::cout << "\n\n";
+}
+
+
+void testDeadband()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    static_assert(Deadband<float>::supported, "float deadband");
+    static_assert(Deadband<Vector4<int> >::supported, "vector deadband");
+    static_assert(!Deadband<bool>::supported, "no bool deadband");
+    static_assert(!Deadband<std::string>::supported, "no string deadband");
+
+    // numbers
+    assert(!Deadband<float>::exceeds(1.05f, 1.f, 0.1, false));
+    assert(Deadband<float>::exceeds(1.1f, 1.f, 0.1, false));
+    assert(Deadband<int32_t>::exceeds(-10, 10, 5, false));
+    assert(!Deadband<int32_t>::exceeds(104, 100, 0.05, true));
+    assert(Deadband<int32_t>::exceeds(105, 100, 0.05, true));
+    // relative to 0: any change
+    assert(Deadband<float>::exceeds(0.0001f, 0.f, 0.5, true));
+
+    // vectors: biggest component difference
+    assert(!Deadband<Vector3<float> >::exceeds(Vector3f(1.f, 2.05f, 3.f), Vector3f(1.f, 2.f, 3.f), 0.1, false));
+    assert(Deadband<Vector3<float> >::exceeds(Vector3f(1.f, 2.f, 3.2f), Vector3f(1.f, 2.f, 3.f), 0.1, false));
+    assert(!Deadband<Vector2<float> >::exceeds(Vector2f(10.f, 0.5f), Vector2f(10.f, 0.f), 0.1, true));
+    assert(Deadband<Vector2<float> >::exceeds(Vector2f(10.f, 1.5f), Vector2f(10.f, 0.f), 0.1, true));
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    Float32ParameterPtr value = server.createFloat32Parameter("value");
+    value->setDeadband(0.1);
+    assert(value->getDeadband() == 0.1);
+    assert(!value->isDeadbandRelative());
+    value->setValue(1.f);
+    server.update();
+
+    LoopbackClientTransporter transporter(server_transporter);
+    ParameterClient client(transporter);
+    client.connect("localhost", 10000);
+    pumpLoopback(server_transporter, { &transporter });
+
+    Float32ParameterPtr value_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(value->getId()));
+    assert(value_c);
+    assert(value_c->getValue() == 1.f);
+
+    auto set = [&](float v) {
+        value->setValue(v);
+        server.update();
+        pumpLoopback(server_transporter, { &transporter });
+    };
+
+    // jitter stays on the server
+    set(1.05f);
+    set(0.95f);
+    assert(value->getValue() == 0.95f);
+    assert(value_c->getValue() == 1.f);
+
+    // measured from the last sent value, not the last set one
+    set(1.08f);
+    set(1.12f);
+    assert(value_c->getValue() == 1.12f);
+    set(1.2f);
+    assert(value_c->getValue() == 1.12f);
+    set(1.25f);
+    assert(value_c->getValue() == 1.25f);
+
+    // relative
+    value->setDeadband(0.5, true);
+    set(2.f);
+    assert(value_c->getValue() == 2.f);
+    set(2.9f);
+    assert(value_c->getValue() == 2.f);
+    set(3.f);
+    assert(value_c->getValue() == 3.f);
+
+    // off
+    value->setDeadband(0.0);
+    set(3.01f);
+    assert(value_c->getValue() == 3.01f);
+
+    std::cout << "\n\n";
+}
+
+
+void testSubscription()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    // data
+    {
+        WriteablePtr subscription = SubscriptionData::create({ 3, 7 }, { "fx" });
+        Packet packet(COMMAND_SUBSCRIBE, subscription);
+        BufferWriter writer;
+        packet.write(writer, false);
+
+        assert(PacketScanner::findPacket(writer.data(), writer.size()) == writer.size());
+
+        Option<Packet> parsed = Packet::parse(writer.data(), writer.size());
+        assert(parsed.hasValue());
+        SubscriptionDataPtr data = std::dynamic_pointer_cast<SubscriptionData>(parsed.value().getData());
+        assert(data);
+        assert(data->getGroups().size() == 2 && data->getGroups()[1] == 7);
+        assert(data->getTags().size() == 1 && data->getTags()[0] == "fx");
+    }
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    GroupParameterPtr lights = server.createGroupParameter("lights");
+    Float32ParameterPtr dimmer = server.createFloat32Parameter("dimmer", lights);
+    GroupParameterPtr sound = server.createGroupParameter("sound");
+    Float32ParameterPtr volume = server.createFloat32Parameter("volume", sound);
+    Float32ParameterPtr master = server.createFloat32Parameter("master");
+    master->setTags("main fx");
+    server.update();
+
+    LoopbackClientTransporter transporter_a(server_transporter);
+    LoopbackClientTransporter transporter_b(server_transporter);
+    LoopbackClientTransporter transporter_c(server_transporter);
+    ParameterClient client_a(transporter_a);
+    ParameterClient client_b(transporter_b);
+    ParameterClient client_c(transporter_c);
+    std::vector<LoopbackClientTransporter*> clients = { &transporter_a, &transporter_b, &transporter_c };
+
+    // a: subtree, b: tag, c: everything
+    client_a.subscribe({ lights->getId() });
+    client_b.subscribe({}, { "fx" });
+
+    client_a.connect("localhost", 10000);
+    client_b.connect("localhost", 10000);
+    client_c.connect("localhost", 10000);
+    pumpLoopback(server_transporter, clients);
+    assert(server.getSubscriptionCount() == 2);
+
+    // groups are always sent
+    assert(client_a.getParameter(lights->getId()) && client_a.getParameter(sound->getId()));
+    assert(client_a.getParameter(dimmer->getId()));
+    assert(!client_a.getParameter(volume->getId()));
+    assert(!client_a.getParameter(master->getId()));
+
+    assert(!client_b.getParameter(dimmer->getId()));
+    assert(client_b.getParameter(master->getId()));
+
+    assert(client_c.getParameter(dimmer->getId()));
+    assert(client_c.getParameter(volume->getId()));
+    assert(client_c.getParameter(master->getId()));
+
+    // changes go to interested clients only
+    Float32ParameterPtr dimmer_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(dimmer->getId()));
+    Float32ParameterPtr volume_c = std::dynamic_pointer_cast<Float32Parameter>(client_c.getParameter(volume->getId()));
+
+    dimmer->setValue(1.f);
+    volume->setValue(2.f);
+    server.update();
+    pumpLoopback(server_transporter, clients);
+    assert(dimmer_a->getValue() == 1.f);
+    assert(volume_c->getValue() == 2.f);
+    assert(!client_a.getParameter(volume->getId()));
+    assert(!client_b.getParameter(volume->getId()));
+
+    // nobody subscribed: nothing is sent
+    transporter_c.disconnect();
+    pumpLoopback(server_transporter, clients);
+    volume->setValue(3.f);
+    server.update();
+    assert(transporter_a.process() == 0);
+    assert(transporter_b.process() == 0);
+
+    // a moves to sound
+    client_a.subscribe({ sound->getId() });
+    pumpLoopback(server_transporter, clients);
+    assert(!client_a.getParameter(dimmer->getId()));
+    Float32ParameterPtr volume_a = std::dynamic_pointer_cast<Float32Parameter>(client_a.getParameter(volume->getId()));
+    assert(volume_a && volume_a->getValue() == 3.f);
+
+    // b gets everything again
+    client_b.unsubscribe();
+    pumpLoopback(server_transporter, clients);
+    assert(server.getSubscriptionCount() == 1);
+    assert(client_b.getParameter(dimmer->getId()));
+    assert(client_b.getParameter(volume->getId()));
+
+    // with the sender thread and frames
+    server.setMaxFrameSize(1024);
+    server.startSender();
+    dimmer->setValue(4.f);
+    volume->setValue(5.f);
+    server.update();
+    server.stopSender();
+    pumpLoopback(server_transporter, clients);
+    Float32ParameterPtr dimmer_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(dimmer->getId()));
+    Float32ParameterPtr volume_b = std::dynamic_pointer_cast<Float32Parameter>(client_b.getParameter(volume->getId()));
+    assert(dimmer_b->getValue() == 4.f);
+    assert(volume_b->getValue() == 5.f);
+    assert(volume_a->getValue() == 5.f);
+    assert(!client_a.getParameter(dimmer->getId()));
+
+    // changes of clients are forwarded by the same rules
+    dimmer_b->setValue(6.f);
+    client_b.update();
+    assert(server_transporter.process() > 0);
+    assert(dimmer->getValue() == 6.f);
+    assert(transporter_a.process() == 0);
+
+    volume_b->setValue(7.f);
+    client_b.update();
+    assert(server_transporter.process() > 0);
+    assert(transporter_a.process() > 0);
+    assert(volume_a->getValue() == 7.f);
+
+    // disconnected clients are forgotten
+    transporter_a.disconnect();
+    assert(server.getSubscriptionCount() == 0);
+
+    std::cout << "\n\n";
+}
+
+
+void testDiscover()
+{
+    std::cout << "**** " << __FUNCTION__ << " ****\n\n";
+
+    struct DiscoverListener : public ParameterClientListener
+    {
+        void initializeDone() override { initialized++; }
+        void discoverDone(int16_t groupId) override { discovered.push_back(groupId); }
+
+        int initialized{0};
+        std::vector<int16_t> discovered;
+    };
+
+    // data
+    {
+        WriteablePtr id_data = IdData::create(12);
+        Packet packet(COMMAND_DISCOVER, id_data);
+        BufferWriter writer;
+        packet.write(writer, false);
+
+        assert(PacketScanner::findPacket(writer.data(), writer.size()) == writer.size());
+
+        Option<Packet> parsed = Packet::parse(writer.data(), writer.size());
+        assert(parsed.hasValue());
+        IdDataPtr data = std::dynamic_pointer_cast<IdData>(parsed.value().getData());
+        assert(data && data->getId() == 12);
+    }
+
+    LoopbackServerTransporter server_transporter;
+    ParameterServer server(server_transporter);
+    server_transporter.bind(10000);
+
+    GroupParameterPtr a = server.createGroupParameter("a");
+    GroupParameterPtr a1 = server.createGroupParameter("a1", a);
+    Float32ParameterPtr x = server.createFloat32Parameter("x", a1);
+    GroupParameterPtr b = server.createGroupParameter("b");
+    Float32ParameterPtr y = server.createFloat32Parameter("y", b);
+    Float32ParameterPtr master = server.createFloat32Parameter("master");
+    server.update();
+
+    LoopbackClientTransporter transporter(server_transporter);
+    ParameterClient client(transporter);
+    DiscoverListener listener;
+    client.addListener(&listener);
+    client.setLazyDiscovery(true);
+
+    client.connect("localhost", 10000);
+    pumpLoopback(server_transporter, { &transporter });
+
+    // top level only
+    assert(listener.initialized == 1);
+    assert(client.getParameter(a->getId()));
+    assert(client.getParameter(b->getId()));
+    assert(client.getParameter(master->getId()));
+    assert(!client.getParameter(a1->getId()));
+    assert(!client.getParameter(y->getId()));
+    assert(server.getSubscriptionCount() == 1);
+
+    // one group
+    client.discover(b->getId());
+    pumpLoopback(server_transporter, { &transporter });
+    assert(listener.discovered.size() == 1 && listener.discovered[0] == b->getId());
+    Float32ParameterPtr y_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(y->getId()));
+    assert(y_c);
+    assert(!client.getParameter(a1->getId()));
+
+    // changes of discovered parts only
+    y->setValue(1.f);
+    x->setValue(2.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(y_c->getValue() == 1.f);
+    assert(!client.getParameter(x->getId()));
+
+    // nested group, parents come first
+    client.discover(a1->getId());
+    pumpLoopback(server_transporter, { &transporter });
+    assert(listener.discovered.size() == 2);
+    Float32ParameterPtr x_c = std::dynamic_pointer_cast<Float32Parameter>(client.getParameter(x->getId()));
+    assert(x_c && x_c->getValue() == 2.f);
+    assert(client.getParameter(a1->getId())->getParent().lock() == client.getParameter(a->getId()));
+
+    x->setValue(3.f);
+    server.update();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(x_c->getValue() == 3.f);
+
+    // unknown id
+    client.discover(999);
+    pumpLoopback(server_transporter, { &transporter });
+    assert(listener.discovered.size() == 3 && listener.discovered[2] == 999);
+
+    // full init replaces discovery
+    client.initialize();
+    pumpLoopback(server_transporter, { &transporter });
+    assert(server.getSubscriptionCount() == 0);
+
+    client.removeListener(&listener);
+
+    std::cout << "\n\n";
+}
+
+
 // test threading
 static inline std::string nowString()
 {
@@ -1042,6 +3806,36 @@ void testThreading()
 //-------------------------------
 int main(int /*argc*/, char const */*argv*/[])
 {
+    testBufferWriter();
+    testByteReader();
+    testUpdateValue();
+    testIdAllocator();
+    testParameterTable();
+    testAtomicIdSet();
+    testFrames();
+    testInitCache();
+    testLoopback();
+    testWebSocketFrames();
+    testShmRing();
+    testMulticastHeader();
+    testPacketScanner();
+    testReceivePackets();
+    testOutboundQueue();
+    testSender();
+    testRateLimit();
+    testDeadband();
+    testSubscription();
+    testDiscover();
+#ifdef __linux__
+    testTcp();
+    testWebSocket();
+    testShm();
+    testUnix();
+    testIoUring();
+    testMulticast();
+    testTcpUnframed();
+    testTcpSlowConsumer();
+#endif
     testInit();
     return 0;
 
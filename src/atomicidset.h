@@ -0,0 +1,154 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_ATOMICIDSET_H
+#define RCP_ATOMICIDSET_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "bitutils.h"
+
+namespace rcp {
+
+/*
+* AtomicIdSet - lock-free set of parameter ids
+*
+* one bit per id plus a summary bit per 64-bit word.
+* set() and reset() are a single atomic operation on the id word,
+* drain() collects and clears all ids word by word.
+*
+* a set() concurrent to drain() is either reported by this drain()
+* or by the next one - it is never lost.
+*/
+class AtomicIdSet
+{
+public:
+    static const size_t WORD_COUNT = 65536 / 64;
+    static const size_t SUMMARY_COUNT = WORD_COUNT / 64;
+
+public:
+    AtomicIdSet()
+    {
+        clear();
+    }
+
+    AtomicIdSet(const AtomicIdSet&) = delete;
+    AtomicIdSet& operator=(const AtomicIdSet&) = delete;
+
+    // returns true if id was not set before
+    bool set(int16_t id)
+    {
+        uint16_t uid = static_cast<uint16_t>(id);
+        size_t w = uid / 64;
+        uint64_t bit = uint64_t(1) << (uid % 64);
+
+        uint64_t old = m_words[w].fetch_or(bit, std::memory_order_acq_rel);
+
+        // summary after word, so drain() can not miss it
+        m_summary[w / 64].fetch_or(uint64_t(1) << (w % 64), std::memory_order_release);
+
+        return (old & bit) == 0;
+    }
+
+    // returns true if id was set
+    bool reset(int16_t id)
+    {
+        uint16_t uid = static_cast<uint16_t>(id);
+        uint64_t bit = uint64_t(1) << (uid % 64);
+
+        // summary bit is left as it is, drain() skips empty words
+        uint64_t old = m_words[uid / 64].fetch_and(~bit, std::memory_order_acq_rel);
+        return (old & bit) != 0;
+    }
+
+    bool test(int16_t id) const
+    {
+        uint16_t uid = static_cast<uint16_t>(id);
+        return (m_words[uid / 64].load(std::memory_order_acquire) & (uint64_t(1) << (uid % 64))) != 0;
+    }
+
+    bool empty() const
+    {
+        for (size_t s = 0; s < SUMMARY_COUNT; s++)
+        {
+            uint64_t summary = m_summary[s].load(std::memory_order_acquire);
+            while (summary != 0)
+            {
+                size_t w = s * 64 + lowestBit(summary);
+                summary &= summary - 1;
+
+                if (m_words[w].load(std::memory_order_acquire) != 0)
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // clears all ids and calls func(int16_t id) for each
+    // ids are reported in signed order (same as std::map<int16_t, ...>)
+    template<typename F>
+    void drain(F func)
+    {
+        for (size_t i = 0; i < SUMMARY_COUNT; i++)
+        {
+            // negative ids first
+            size_t s = (i + SUMMARY_COUNT / 2) % SUMMARY_COUNT;
+
+            uint64_t summary = m_summary[s].exchange(0, std::memory_order_acq_rel);
+            while (summary != 0)
+            {
+                size_t w = s * 64 + lowestBit(summary);
+                summary &= summary - 1;
+
+                uint64_t bits = m_words[w].exchange(0, std::memory_order_acq_rel);
+                while (bits != 0)
+                {
+                    unsigned int bit = lowestBit(bits);
+                    bits &= bits - 1;
+
+                    func(static_cast<int16_t>(w * 64 + bit));
+                }
+            }
+        }
+    }
+
+    void clear()
+    {
+        for (auto& w : m_words)
+        {
+            w.store(0, std::memory_order_relaxed);
+        }
+        for (auto& s : m_summary)
+        {
+            s.store(0, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint64_t> m_words[WORD_COUNT];
+    std::atomic<uint64_t> m_summary[SUMMARY_COUNT];
+};
+
+}
+
+#endif // RCP_ATOMICIDSET_H
@@ -0,0 +1,51 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_BITUTILS_H
+#define RCP_BITUTILS_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace rcp {
+
+// index of lowest set bit, v must not be 0
+inline unsigned int lowestBit(uint64_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned int>(__builtin_ctzll(v));
+#elif defined(_MSC_VER) && defined(_WIN64)
+    unsigned long index;
+    _BitScanForward64(&index, v);
+    return static_cast<unsigned int>(index);
+#else
+    unsigned int index = 0;
+    while ((v & 1) == 0)
+    {
+        v >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+}
+
+#endif // RCP_BITUTILS_H
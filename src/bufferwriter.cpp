@@ -0,0 +1,197 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#include <iostream>
+#include <cstring>
+
+#include "bufferwriter.h"
+#include "stream_tools.h"
+
+namespace rcp {
+
+BufferWriter::BufferWriter(size_t capacity)
+{
+    m_buffer.resize(capacity);
+}
+
+void BufferWriter::reserve(size_t capacity)
+{
+    if (capacity > m_buffer.size())
+    {
+        m_buffer.resize(capacity);
+    }
+}
+
+void BufferWriter::clear()
+{
+    // keep capacity
+    m_size = 0;
+}
+
+SharedBuffer BufferWriter::share()
+{
+    m_buffer.resize(m_size);
+    SharedBuffer buffer(std::move(m_buffer));
+
+    m_buffer = std::vector<char>();
+    m_size = 0;
+
+    return buffer;
+}
+
+void BufferWriter::dump() const
+{
+    std::cout << value_to_string(std::vector<char>(m_buffer.begin(), m_buffer.begin() + m_size)) << "\n";
+}
+
+char* BufferWriter::grow(size_t length)
+{
+    if (m_size + length > m_buffer.size())
+    {
+        size_t capacity = m_buffer.size() * 2;
+        if (capacity < m_size + length)
+        {
+            capacity = m_size + length;
+        }
+        m_buffer.resize(capacity);
+    }
+
+    char* p = m_buffer.data() + m_size;
+    m_size += length;
+    return p;
+}
+
+
+void BufferWriter::write(const bool& c)
+{
+    *grow(1) = c ? 1 : 0;
+}
+
+void BufferWriter::write(const char& c)
+{
+    *grow(1) = c;
+}
+
+void BufferWriter::write(const uint8_t& c)
+{
+    *grow(1) = static_cast<char>(c);
+}
+
+void BufferWriter::write(const int8_t& c)
+{
+    *grow(1) = static_cast<char>(c);
+}
+
+
+void BufferWriter::write(const uint16_t& v)
+{
+    char* p = grow(sizeof(uint16_t));
+    p[0] = static_cast<char>(v >> 8);
+    p[1] = static_cast<char>(v);
+}
+
+void BufferWriter::write(const int16_t& v)
+{
+    write(static_cast<uint16_t>(v));
+}
+
+
+void BufferWriter::write(const uint32_t& v)
+{
+    char* p = grow(sizeof(uint32_t));
+    p[0] = static_cast<char>(v >> 24);
+    p[1] = static_cast<char>(v >> 16);
+    p[2] = static_cast<char>(v >> 8);
+    p[3] = static_cast<char>(v);
+}
+
+void BufferWriter::write(const int32_t& v)
+{
+    write(static_cast<uint32_t>(v));
+}
+
+
+void BufferWriter::write(const uint64_t& v)
+{
+    char* p = grow(sizeof(uint64_t));
+    p[0] = static_cast<char>(v >> 56);
+    p[1] = static_cast<char>(v >> 48);
+    p[2] = static_cast<char>(v >> 40);
+    p[3] = static_cast<char>(v >> 32);
+    p[4] = static_cast<char>(v >> 24);
+    p[5] = static_cast<char>(v >> 16);
+    p[6] = static_cast<char>(v >> 8);
+    p[7] = static_cast<char>(v);
+}
+
+void BufferWriter::write(const int64_t& v)
+{
+    write(static_cast<uint64_t>(v));
+}
+
+
+void BufferWriter::write(const float& value)
+{
+    uint32_t v;
+    std::memcpy(&v, &value, sizeof(uint32_t));
+    write(v);
+}
+
+void BufferWriter::write(const double& value)
+{
+    uint64_t v;
+    std::memcpy(&v, &value, sizeof(uint64_t));
+    write(v);
+}
+
+
+void BufferWriter::write(const std::string& s, bool prefix)
+{
+    if (prefix)
+    {
+        write(static_cast<uint32_t>(s.length()));
+    }
+    write(s.data(), s.length());
+}
+
+void BufferWriter::write(const rcp::Color& s)
+{
+    write(s.getValue());
+}
+
+void BufferWriter::write(const rcp::IPv4& s)
+{
+    write(s.getAddress());
+}
+
+void BufferWriter::write(const rcp::IPv6& s)
+{
+    for (int i=0; i<4; i++)
+    {
+        write(static_cast<uint32_t>(s.getAddress(i)));
+    }
+}
+
+void BufferWriter::write(const char* data, size_t length)
+{
+    if (length > 0)
+    {
+        std::memcpy(grow(length), data, length);
+    }
+}
+
+}
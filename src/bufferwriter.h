@@ -0,0 +1,81 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_BUFFERWRITER_H
+#define RCP_BUFFERWRITER_H
+
+#include <vector>
+
+#include "writer.h"
+#include "sharedbuffer.h"
+
+namespace rcp {
+
+/*
+* BufferWriter writes big-endian into a growable contiguous byte buffer
+* the result is available as pointer+length via data() and size()
+*/
+class BufferWriter
+    : public Writer
+{
+public:
+    BufferWriter(size_t capacity = 256);
+
+    char* data() { return m_buffer.data(); }
+    const char* data() const { return m_buffer.data(); }
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    void reserve(size_t capacity);
+    void clear();
+    void dump() const;
+
+    // moves the written bytes into a SharedBuffer without copying
+    // the writer is empty afterwards
+    SharedBuffer share();
+
+public:
+    // Writer
+    virtual void write(const bool& c) override;
+    virtual void write(const char& c) override;
+    virtual void write(const uint8_t& c) override;
+    virtual void write(const int8_t& c) override;
+    virtual void write(const uint16_t& c) override;
+    virtual void write(const int16_t& c) override;
+    virtual void write(const uint32_t& c) override;
+    virtual void write(const int32_t& c) override;
+    virtual void write(const uint64_t& c) override;
+    virtual void write(const int64_t& c) override;
+    virtual void write(const float& c) override;
+    virtual void write(const double& c) override;
+    virtual void write(const std::string& s, bool prefix = true) override;
+    virtual void write(const rcp::Color& s) override;
+    virtual void write(const rcp::IPv4& s) override;
+    virtual void write(const rcp::IPv6& s) override;
+    virtual void write(const char* data, size_t length) override;
+
+private:
+    // returns a pointer to length writable bytes at the end of the buffer
+    char* grow(size_t length);
+
+    std::vector<char> m_buffer;
+    size_t m_size{0};
+};
+
+}
+
+#endif // RCP_BUFFERWRITER_H
@@ -0,0 +1,191 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_BYTEREADER_H
+#define RCP_BYTEREADER_H
+
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <istream>
+
+namespace rcp {
+
+/*
+* ByteReader - bounds-checked cursor over a block of memory
+*
+* mirrors the small part of std::istream used by the parsers:
+* get(), peek() and read() set eof when reading past the end,
+* a short read() additionally sets fail.
+* the memory is not copied and must outlive the reader.
+*
+* a reader over a std::istream takes every byte from the stream,
+* exactly the bytes read are consumed. used by the stream wrappers
+* of the parsers, position(), current() and remaining() are 0 then.
+*/
+class ByteReader
+{
+public:
+    ByteReader(const char* data, size_t size)
+        : m_begin(data)
+        , m_pos(data)
+        , m_end(data + size)
+    {}
+
+    explicit ByteReader(std::istream& stream)
+        : m_begin(nullptr)
+        , m_pos(nullptr)
+        , m_end(nullptr)
+        , m_stream(&stream)
+    {
+        _syncStream();
+    }
+
+    int get()
+    {
+        if (m_pos < m_end)
+        {
+            return static_cast<unsigned char>(*m_pos++);
+        }
+
+        if (m_stream)
+        {
+            int c = m_stream->get();
+            _syncStream();
+            return c;
+        }
+
+        m_eof = true;
+        m_fail = true;
+        return EOF;
+    }
+
+    int peek()
+    {
+        if (m_pos < m_end)
+        {
+            return static_cast<unsigned char>(*m_pos);
+        }
+
+        if (m_stream)
+        {
+            int c = m_stream->peek();
+            _syncStream();
+            return c;
+        }
+
+        m_eof = true;
+        return EOF;
+    }
+
+    ByteReader& read(char* dest, size_t size)
+    {
+        if (size == 0)
+        {
+            return *this;
+        }
+
+        size_t available = remaining();
+
+        if (m_stream &&
+            size > available)
+        {
+            if (available > 0)
+            {
+                std::memcpy(dest, m_pos, available);
+            }
+            m_pos = m_end;
+            m_stream->read(dest + available, static_cast<std::streamsize>(size - available));
+            _syncStream();
+            return *this;
+        }
+
+        if (size > available)
+        {
+            // copy what is there, like std::istream
+            if (available > 0)
+            {
+                std::memcpy(dest, m_pos, available);
+            }
+            m_pos = m_end;
+            m_eof = true;
+            m_fail = true;
+            return *this;
+        }
+
+        std::memcpy(dest, m_pos, size);
+        m_pos += size;
+        return *this;
+    }
+
+    bool skip(size_t size)
+    {
+        if (m_stream &&
+            size > remaining())
+        {
+            std::streamsize wanted = static_cast<std::streamsize>(size - remaining());
+            m_pos = m_end;
+            m_stream->ignore(wanted);
+            _syncStream();
+
+            if (m_stream->gcount() != wanted)
+            {
+                m_fail = true;
+                return false;
+            }
+            return true;
+        }
+
+        if (size > remaining())
+        {
+            m_pos = m_end;
+            m_eof = true;
+            m_fail = true;
+            return false;
+        }
+
+        m_pos += size;
+        return true;
+    }
+
+    bool eof() const { return m_eof; }
+    bool fail() const { return m_fail; }
+    bool good() const { return !(m_eof || m_fail); }
+
+    const char* current() const { return m_pos; }
+    size_t position() const { return static_cast<size_t>(m_pos - m_begin); }
+    size_t remaining() const { return static_cast<size_t>(m_end - m_pos); }
+    size_t size() const { return static_cast<size_t>(m_end - m_begin); }
+
+private:
+    void _syncStream()
+    {
+        m_eof = m_stream->eof();
+        m_fail = m_stream->fail();
+    }
+
+    const char* m_begin;
+    const char* m_pos;
+    const char* m_end;
+    std::istream* m_stream{nullptr};
+    bool m_eof{false};
+    bool m_fail{false};
+};
+
+}
+
+#endif // RCP_BYTEREADER_H
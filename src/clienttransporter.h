@@ -19,6 +19,13 @@
 #define CLIENTTRANSPORTER_H
 
 #include <map>
+#include <istream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "memorystream.h"
+#include "sharedbuffer.h"
 
 namespace rcp {
 
@@ -28,6 +35,14 @@ public:
     virtual void connected() = 0;
     virtual void disconnected() = 0;
     virtual void received(std::istream& data) = 0;
+
+    // receive a block of memory
+    // default: wrap the memory into a stream without copying
+    virtual void received(const char* data, size_t size)
+    {
+        MemoryInputStream stream(data, size);
+        received(stream);
+    }
 };
 
 
@@ -39,8 +54,22 @@ public:
     virtual void disconnect() = 0;
     virtual bool isConnected() = 0;
 
-    virtual void send(std::istream& data) = 0;
-    virtual void send(char* data, size_t size) = 0;
+    virtual void send(const char* data, size_t size) = 0;
+
+    // refcounted buffer
+    // transporters queueing data can keep a reference instead of copying
+    virtual void send(const SharedBuffer& buffer)
+    {
+        send(buffer.data(), buffer.size());
+    }
+
+    // stream adapter
+    virtual void send(std::istream& data)
+    {
+        std::vector<char> buffer(std::istreambuf_iterator<char>(data),
+                                 (std::istreambuf_iterator<char>()));
+        send(buffer.data(), buffer.size());
+    }
 
     void addConnectedCb(ClientTransporterListener* c, void(ClientTransporterListener::* func)()) {
         connected_cb[c] = func;
@@ -79,6 +108,11 @@ protected:
             (kv.first->*kv.second)(in);
         }
     }
+    void _received(const char* data, size_t size) {
+        for (const auto& kv : receive_cb) {
+            kv.first->received(data, size);
+        }
+    }
 
 
     std::map<ClientTransporterListener*, void(ClientTransporterListener::*)()> connected_cb;
@@ -26,7 +26,7 @@ Color& swap_endian(Color& u)
     return u;
 }
 
-Color readFromStream(std::istream& is, const Color& /*i*/)
+Color readFromStream(ByteReader& is, const Color& /*i*/)
 {
     uint32_t value;
     is.read(reinterpret_cast<char *>(&value), sizeof(uint32_t));
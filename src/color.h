@@ -21,6 +21,8 @@
 #include <stdint.h>
 #include <ostream>
 
+#include "bytereader.h"
+
 namespace rcp {
 
 class Color
@@ -64,7 +66,7 @@ private:
 };
 
 Color& swap_endian(Color& u);
-Color readFromStream(std::istream& is, const Color& i);
+Color readFromStream(ByteReader& is, const Color& i);
 
 std::ostream& operator<<(std::ostream& out, const Color& v);
 
@@ -0,0 +1,129 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_DEADBAND_H
+#define RCP_DEADBAND_H
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include "vector2.h"
+#include "vector3.h"
+#include "vector4.h"
+
+namespace rcp {
+
+/*
+* Deadband - distance of a value to the last sent value
+*
+* numbers compare their difference, vectors the biggest
+* difference of their components.
+* a relative threshold is a fraction of the magnitude of the sent value
+* (biggest component for vectors), a sent 0 passes any change.
+*
+* supported is false for all other types.
+*/
+template<typename T, typename = void>
+struct Deadband
+{
+    static const bool supported = false;
+
+    static bool exceeds(const T& /*value*/, const T& /*sent*/, double /*threshold*/, bool /*relative*/)
+    {
+        return true;
+    }
+};
+
+template<typename T>
+struct Deadband<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type>
+{
+    static const bool supported = true;
+
+    static double distance(T value, T sent)
+    {
+        return std::fabs(static_cast<double>(value) - static_cast<double>(sent));
+    }
+
+    static double magnitude(T sent)
+    {
+        return std::fabs(static_cast<double>(sent));
+    }
+
+    static bool exceeds(T value, T sent, double threshold, bool relative)
+    {
+        return distance(value, sent) >= (relative ? threshold * magnitude(sent) : threshold);
+    }
+};
+
+template<typename T>
+struct Deadband<Vector2<T> >
+{
+    static const bool supported = true;
+
+    static bool exceeds(const Vector2<T>& value, const Vector2<T>& sent, double threshold, bool relative)
+    {
+        double distance = std::max(Deadband<T>::distance(value.x(), sent.x()),
+                                   Deadband<T>::distance(value.y(), sent.y()));
+        double magnitude = std::max(Deadband<T>::magnitude(sent.x()),
+                                    Deadband<T>::magnitude(sent.y()));
+
+        return distance >= (relative ? threshold * magnitude : threshold);
+    }
+};
+
+template<typename T>
+struct Deadband<Vector3<T> >
+{
+    static const bool supported = true;
+
+    static bool exceeds(const Vector3<T>& value, const Vector3<T>& sent, double threshold, bool relative)
+    {
+        double distance = std::max(std::max(Deadband<T>::distance(value.x(), sent.x()),
+                                            Deadband<T>::distance(value.y(), sent.y())),
+                                   Deadband<T>::distance(value.z(), sent.z()));
+        double magnitude = std::max(std::max(Deadband<T>::magnitude(sent.x()),
+                                             Deadband<T>::magnitude(sent.y())),
+                                    Deadband<T>::magnitude(sent.z()));
+
+        return distance >= (relative ? threshold * magnitude : threshold);
+    }
+};
+
+template<typename T>
+struct Deadband<Vector4<T> >
+{
+    static const bool supported = true;
+
+    static bool exceeds(const Vector4<T>& value, const Vector4<T>& sent, double threshold, bool relative)
+    {
+        double distance = std::max(std::max(Deadband<T>::distance(value.x(), sent.x()),
+                                            Deadband<T>::distance(value.y(), sent.y())),
+                                   std::max(Deadband<T>::distance(value.z(), sent.z()),
+                                            Deadband<T>::distance(value.w(), sent.w())));
+        double magnitude = std::max(std::max(Deadband<T>::magnitude(sent.x()),
+                                             Deadband<T>::magnitude(sent.y())),
+                                    std::max(Deadband<T>::magnitude(sent.z()),
+                                             Deadband<T>::magnitude(sent.w())));
+
+        return distance >= (relative ? threshold * magnitude : threshold);
+    }
+};
+
+}
+
+#endif // RCP_DEADBAND_H
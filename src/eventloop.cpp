@@ -0,0 +1,283 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "eventloop.h"
+
+#include <future>
+#include <iostream>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+static const size_t MAX_EVENTS = 256;
+
+EventLoop::EventLoop()
+    : m_loopThread(std::thread::id())
+{
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll < 0)
+    {
+        std::cerr << "EventLoop: epoll_create1 failed: " << errno << "\n";
+        return;
+    }
+
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0)
+    {
+        std::cerr << "EventLoop: eventfd failed: " << errno << "\n";
+        return;
+    }
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = static_cast<uint64_t>(static_cast<uint32_t>(m_wakeFd));
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &ev);
+}
+
+EventLoop::~EventLoop()
+{
+    stop();
+
+    if (m_wakeFd >= 0)
+    {
+        ::close(m_wakeFd);
+    }
+    if (m_epoll >= 0)
+    {
+        ::close(m_epoll);
+    }
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::shared_ptr<Registration> registration = std::make_shared<Registration>();
+    registration->generation = ++m_generation;
+    registration->handler = std::move(handler);
+
+    // generation in the upper bits, so events of a reused fd are not misrouted
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = (static_cast<uint64_t>(registration->generation) << 32) | static_cast<uint32_t>(fd);
+
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &ev) != 0)
+    {
+        return false;
+    }
+
+    m_handlers[fd] = registration;
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_handlers.find(fd);
+    if (it == m_handlers.end())
+    {
+        return false;
+    }
+
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.u64 = (static_cast<uint64_t>(it->second->generation) << 32) | static_cast<uint32_t>(fd);
+
+    return epoll_ctl(m_epoll, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_handlers.erase(fd) > 0)
+    {
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+void EventLoop::post(Task task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_taskMutex);
+        m_tasks.push_back(std::move(task));
+    }
+
+    _wakeup();
+}
+
+void EventLoop::invoke(Task task)
+{
+    if (inLoopThread() || !running())
+    {
+        task();
+        return;
+    }
+
+    std::shared_ptr<std::promise<void> > done = std::make_shared<std::promise<void> >();
+    std::future<void> future = done->get_future();
+
+    post([&task, done]() {
+        task();
+        done->set_value();
+    });
+
+    future.wait();
+}
+
+size_t EventLoop::runOnce(int timeoutMs)
+{
+    epoll_event events[MAX_EVENTS];
+
+    int n = epoll_wait(m_epoll, events, MAX_EVENTS, timeoutMs);
+    if (n < 0)
+    {
+        return _runTasks();
+    }
+
+    size_t handled = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        int fd = static_cast<int>(events[i].data.u64 & 0xFFFFFFFF);
+        uint32_t generation = static_cast<uint32_t>(events[i].data.u64 >> 32);
+
+        if (fd == m_wakeFd)
+        {
+            uint64_t value;
+            while (::read(m_wakeFd, &value, sizeof(value)) > 0) {}
+            continue;
+        }
+
+        std::shared_ptr<Registration> registration;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            auto it = m_handlers.find(fd);
+            if (it != m_handlers.end() &&
+                it->second->generation == generation)
+            {
+                registration = it->second;
+            }
+        }
+
+        if (registration)
+        {
+            registration->handler(events[i].events);
+            handled++;
+        }
+    }
+
+    return handled + _runTasks();
+}
+
+void EventLoop::start()
+{
+    if (m_thread.joinable())
+    {
+        if (m_running.load(std::memory_order_acquire) ||
+            inLoopThread())
+        {
+            return;
+        }
+
+        // stopped from a handler, collect the finished thread
+        m_thread.join();
+    }
+
+    m_running.store(true, std::memory_order_release);
+
+    m_thread = std::thread([this]() {
+
+        m_loopThread.store(std::this_thread::get_id());
+
+        while (m_running.load(std::memory_order_acquire))
+        {
+            runOnce(-1);
+        }
+
+        m_loopThread.store(std::thread::id());
+    });
+}
+
+void EventLoop::stop()
+{
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    m_running.store(false, std::memory_order_release);
+
+    if (inLoopThread())
+    {
+        // stopped from a handler: the loop ends after this iteration,
+        // the thread is joined by stop() from another thread or the destructor
+        return;
+    }
+
+    _wakeup();
+
+    m_thread.join();
+
+    // run what was posted after the last iteration
+    _runTasks();
+}
+
+bool EventLoop::inLoopThread() const
+{
+    return m_loopThread.load() == std::this_thread::get_id();
+}
+
+void EventLoop::_wakeup()
+{
+    uint64_t one = 1;
+    ssize_t r = ::write(m_wakeFd, &one, sizeof(one));
+    (void)r;
+}
+
+size_t EventLoop::_runTasks()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_taskMutex);
+        if (m_tasks.empty())
+        {
+            return 0;
+        }
+        m_runningTasks.swap(m_tasks);
+    }
+
+    size_t count = m_runningTasks.size();
+    for (Task& task : m_runningTasks)
+    {
+        task();
+    }
+    m_runningTasks.clear();
+
+    return count;
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,114 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_EVENTLOOP_H
+#define RCP_EVENTLOOP_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace rcp {
+
+/*
+* EventLoop - epoll based io loop
+*
+* file descriptors are registered with a handler called with the
+* epoll events. the loop runs either on its own thread (start)
+* or is driven by the application (runOnce).
+*
+* add, modify, remove and post are thread safe.
+*/
+class EventLoop
+{
+public:
+    typedef std::function<void(uint32_t events)> Handler;
+    typedef std::function<void()> Task;
+
+public:
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool isValid() const { return m_epoll >= 0; }
+
+    // events: EPOLLIN, EPOLLOUT, ...
+    bool add(int fd, uint32_t events, Handler handler);
+    bool modify(int fd, uint32_t events);
+    // the handler is not called after remove returns
+    // (unless remove is called from another handler of the same batch on the loop thread)
+    void remove(int fd);
+
+    // run task on the loop thread
+    void post(Task task);
+    // run task on the loop thread and wait for it
+    // runs task directly if called on the loop thread or if no loop thread is running
+    void invoke(Task task);
+
+    // wait for events at most timeoutMs (-1: forever)
+    // returns number of handled events and tasks
+    size_t runOnce(int timeoutMs);
+
+    // run loop on own thread
+    // stop() from a handler only ends the loop, the thread is joined by
+    // the next stop() from another thread or the destructor.
+    // do not destroy the loop from a handler.
+    void start();
+    void stop();
+    bool running() const { return m_running.load(std::memory_order_acquire); }
+    bool inLoopThread() const;
+
+private:
+    struct Registration
+    {
+        uint32_t generation;
+        Handler handler;
+    };
+
+    void _wakeup();
+    size_t _runTasks();
+
+    int m_epoll{-1};
+    int m_wakeFd{-1};
+
+    std::mutex m_mutex;
+    std::unordered_map<int, std::shared_ptr<Registration> > m_handlers;
+    uint32_t m_generation{0};
+
+    std::mutex m_taskMutex;
+    std::vector<Task> m_tasks;
+    std::vector<Task> m_runningTasks;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<std::thread::id> m_loopThread;
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_EVENTLOOP_H
@@ -0,0 +1,87 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_FRAMEBUILDER_H
+#define RCP_FRAMEBUILDER_H
+
+#include "bufferwriter.h"
+#include "sharedbuffer.h"
+
+namespace rcp {
+
+/*
+* FrameBuilder - collects serialized packets into frames
+*
+* a frame is a sequence of complete packets written back to back.
+* packets are self-delimiting, receivers parse them one after another.
+* a frame is flushed when the next packet would exceed the max frame size,
+* a packet bigger than the max frame size is sent as its own frame.
+*/
+class FrameBuilder
+{
+public:
+    FrameBuilder(size_t maxFrameSize = 0)
+        : m_maxFrameSize(maxFrameSize)
+    {}
+
+    void setMaxFrameSize(size_t size) { m_maxFrameSize = size; }
+    size_t getMaxFrameSize() const { return m_maxFrameSize; }
+    bool enabled() const { return m_maxFrameSize > 0; }
+
+    size_t packetCount() const { return m_packetCount; }
+    bool empty() const { return m_packetCount == 0; }
+
+    // add one serialized packet
+    // send(const SharedBuffer&) is called for a full frame
+    template<typename F>
+    void add(const char* data, size_t size, F send)
+    {
+        if (!m_frame.empty() &&
+                m_frame.size() + size > m_maxFrameSize)
+        {
+            flush(send);
+        }
+
+        m_frame.write(data, size);
+        m_packetCount++;
+    }
+
+    // send what is collected
+    template<typename F>
+    void flush(F send)
+    {
+        if (m_frame.empty())
+        {
+            return;
+        }
+
+        SharedBuffer frame = m_frame.share();
+        m_frame.reserve(m_maxFrameSize);
+        m_packetCount = 0;
+
+        send(frame);
+    }
+
+private:
+    size_t m_maxFrameSize;
+    BufferWriter m_frame;
+    size_t m_packetCount{0};
+};
+
+}
+
+#endif // RCP_FRAMEBUILDER_H
@@ -0,0 +1,153 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#include "idallocator.h"
+
+#include <cstring>
+
+#include "bitutils.h"
+
+namespace rcp {
+
+IdAllocator::IdAllocator()
+{
+    clear();
+}
+
+void IdAllocator::clear()
+{
+    std::memset(m_words, 0, sizeof(m_words));
+    std::memset(m_summary, 0, sizeof(m_summary));
+
+    // 0 is root, 0xFFFF is -1
+    setBit(0);
+    setBit(0xFFFF);
+
+    m_used = 0;
+}
+
+int16_t IdAllocator::allocate()
+{
+    for (size_t s = 0; s < SUMMARY_COUNT; s++)
+    {
+        if (m_summary[s] == ~uint64_t(0))
+        {
+            // all words full
+            continue;
+        }
+
+        size_t w = s * 64 + lowestBit(~m_summary[s]);
+        uint16_t id = static_cast<uint16_t>(w * 64 + lowestBit(~m_words[w]));
+
+        setBit(id);
+        m_used++;
+
+        return static_cast<int16_t>(id);
+    }
+
+    // return invalid id 0
+    return 0;
+}
+
+size_t IdAllocator::allocate(size_t count, std::vector<int16_t>& ids)
+{
+    size_t allocated = 0;
+
+    for (size_t s = 0; s < SUMMARY_COUNT && allocated < count; s++)
+    {
+        while (m_summary[s] != ~uint64_t(0) && allocated < count)
+        {
+            size_t w = s * 64 + lowestBit(~m_summary[s]);
+
+            // take free bits of this word
+            uint64_t free_bits = ~m_words[w];
+            while (free_bits != 0 && allocated < count)
+            {
+                unsigned int bit = lowestBit(free_bits);
+                free_bits &= free_bits - 1;
+
+                ids.push_back(static_cast<int16_t>(w * 64 + bit));
+                m_words[w] |= uint64_t(1) << bit;
+                allocated++;
+            }
+
+            if (m_words[w] == ~uint64_t(0))
+            {
+                m_summary[s] |= uint64_t(1) << (w % 64);
+            }
+        }
+    }
+
+    m_used += allocated;
+    return allocated;
+}
+
+bool IdAllocator::reserve(int16_t id)
+{
+    if (isUsed(id))
+    {
+        return false;
+    }
+
+    setBit(static_cast<uint16_t>(id));
+    m_used++;
+
+    return true;
+}
+
+bool IdAllocator::release(int16_t id)
+{
+    uint16_t uid = static_cast<uint16_t>(id);
+
+    if (uid == 0 ||
+        uid == 0xFFFF ||
+        !isUsed(id))
+    {
+        return false;
+    }
+
+    clearBit(uid);
+    m_used--;
+
+    return true;
+}
+
+bool IdAllocator::isUsed(int16_t id) const
+{
+    uint16_t uid = static_cast<uint16_t>(id);
+    return (m_words[uid / 64] & (uint64_t(1) << (uid % 64))) != 0;
+}
+
+void IdAllocator::setBit(uint16_t id)
+{
+    size_t w = id / 64;
+    m_words[w] |= uint64_t(1) << (id % 64);
+
+    if (m_words[w] == ~uint64_t(0))
+    {
+        m_summary[w / 64] |= uint64_t(1) << (w % 64);
+    }
+}
+
+void IdAllocator::clearBit(uint16_t id)
+{
+    size_t w = id / 64;
+    m_words[w] &= ~(uint64_t(1) << (id % 64));
+    m_summary[w / 64] &= ~(uint64_t(1) << (w % 64));
+}
+
+}
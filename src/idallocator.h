@@ -0,0 +1,76 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_IDALLOCATOR_H
+#define RCP_IDALLOCATOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace rcp {
+
+/*
+* IdAllocator - parameter id allocation with a two level bitmap
+*
+* one bit per id, one summary bit per full 64-bit word.
+* allocate() finds the lowest free id with two find-first-zero steps,
+* release() clears the bits. both are O(1).
+*
+* id 0 (root group) and id 0xFFFF (-1) are never handed out.
+*/
+class IdAllocator
+{
+public:
+    static const size_t ID_COUNT = 65536;
+    static const size_t WORD_COUNT = ID_COUNT / 64;
+    static const size_t SUMMARY_COUNT = WORD_COUNT / 64;
+
+public:
+    IdAllocator();
+
+    // returns the lowest free id or 0 if all ids are in use
+    int16_t allocate();
+
+    // allocate up to count ids, appended to ids
+    // returns number of allocated ids
+    size_t allocate(size_t count, std::vector<int16_t>& ids);
+
+    // mark a specific id as used
+    // returns false if id was already in use or is reserved
+    bool reserve(int16_t id);
+
+    // returns false if id was not in use
+    bool release(int16_t id);
+
+    bool isUsed(int16_t id) const;
+    size_t usedCount() const { return m_used; }
+
+    void clear();
+
+private:
+    void setBit(uint16_t id);
+    void clearBit(uint16_t id);
+
+    uint64_t m_words[WORD_COUNT];
+    uint64_t m_summary[SUMMARY_COUNT];
+    size_t m_used{0};
+};
+
+}
+
+#endif // RCP_IDALLOCATOR_H
@@ -32,13 +32,18 @@ class IdData
 public:
     //----------------------------------------
     // parser
-    static IdDataPtr parse(std::istream& is) {
+    static IdDataPtr parse(ByteReader& is) {
 
         // read mandatory
-        const int16_t parameter_id = readFromStream(is, parameter_id);
+        const int16_t parameter_id = readFromStream(is, int16_t());
         return std::make_shared<IdData>(parameter_id);
     }
 
+    static IdDataPtr parse(std::istream& is) {
+        ByteReader reader(is);
+        return parse(reader);
+    }
+
     static inline IdDataPtr create(const int16_t id) {
         return std::make_shared<IdData>(id);
     }
@@ -34,7 +34,7 @@ class InfoData
 public:
     //----------------------------------------
     // parser
-    static InfoDataPtr parse(std::istream& is) {
+    static InfoDataPtr parse(ByteReader& is) {
 
         // read mandatory
         InfoDataPtr info_data = std::make_shared<InfoData>(readTinyString(is));
@@ -64,6 +64,11 @@ public:
         return info_data;
     }
 
+    static InfoDataPtr parse(std::istream& is) {
+        ByteReader reader(is);
+        return parse(reader);
+    }
+
     static inline InfoDataPtr create(const std::string& version, const std::string& applicationId) {
         return std::make_shared<InfoData>(version, applicationId);
     }
@@ -0,0 +1,220 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "iouring.h"
+
+#include <cstring>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+static int ioUringSetup(unsigned entries, io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+
+//------------------------------------------------------------------
+// IoUring
+bool IoUring::isSupported()
+{
+    // disabled kernels or seccomp filters fail on setup
+    static const bool supported = []() {
+        IoUring ring;
+        return ring.init(2);
+    }();
+
+    return supported;
+}
+
+IoUring::~IoUring()
+{
+    close();
+}
+
+bool IoUring::init(unsigned entries)
+{
+    close();
+
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    int fd = ioUringSetup(entries, &params);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        // kernels before 5.4 lack accept, send and recv as well
+        ::close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (m_cqRingSize > m_sqRingSize)
+    {
+        m_sqRingSize = m_cqRingSize;
+    }
+    m_cqRingSize = m_sqRingSize;
+
+    void* ring = ::mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    // one mapping for both rings
+    m_sqRing = ring;
+    m_cqRing = ring;
+
+    m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = ::mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        close();
+        return false;
+    }
+    m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(m_sqRing);
+    m_sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sqEntries = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+    m_sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq = static_cast<char*>(m_cqRing);
+    m_cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    m_queued = 0;
+
+    return true;
+}
+
+void IoUring::close()
+{
+    if (m_sqes)
+    {
+        ::munmap(m_sqes, m_sqesSize);
+        m_sqes = nullptr;
+    }
+
+    if (m_sqRing)
+    {
+        ::munmap(m_sqRing, m_sqRingSize);
+        m_sqRing = nullptr;
+        m_cqRing = nullptr;
+    }
+
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+io_uring_sqe* IoUring::getSqe()
+{
+    unsigned tail = *m_sqTail;
+    unsigned head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+
+    if (tail - head >= *m_sqEntries)
+    {
+        // full, hand queued entries to the kernel
+        submit();
+        head = __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+        if (tail - head >= *m_sqEntries)
+        {
+            return nullptr;
+        }
+    }
+
+    unsigned index = tail & *m_sqMask;
+    io_uring_sqe* sqe = &m_sqes[index];
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+
+    m_sqArray[index] = index;
+    __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+    m_queued++;
+
+    return sqe;
+}
+
+int IoUring::submit(unsigned waitCount)
+{
+    unsigned flags = waitCount > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    while (true)
+    {
+        int result = ioUringEnter(m_fd, m_queued, waitCount, flags);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -errno;
+        }
+
+        m_queued -= static_cast<unsigned>(result) < m_queued ? static_cast<unsigned>(result) : m_queued;
+        return result;
+    }
+}
+
+bool IoUring::registerFiles(const int* fds, unsigned count)
+{
+    return ioUringRegister(m_fd, IORING_REGISTER_FILES, fds, count) == 0;
+}
+
+bool IoUring::updateFile(unsigned index, int fd)
+{
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = index;
+    update.fds = reinterpret_cast<uint64_t>(&fd);
+
+    return ioUringRegister(m_fd, IORING_REGISTER_FILES_UPDATE, &update, 1) == 1;
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,114 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_IOURING_H
+#define RCP_IOURING_H
+
+#ifdef __linux__
+
+#include <cstddef>
+#include <cstdint>
+
+#include <linux/io_uring.h>
+
+namespace rcp {
+
+/*
+* IoUring - minimal io_uring instance on raw system calls
+*
+* one submitting thread. submission entries are collected with getSqe()
+* and handed to the kernel with the next submit().
+*/
+class IoUring
+{
+public:
+    // io_uring can be set up in this process
+    static bool isSupported();
+
+public:
+    IoUring() {}
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // returns false if io_uring is not available
+    bool init(unsigned entries);
+    void close();
+
+    bool isOpen() const { return m_fd >= 0; }
+
+    // cleared submission entry, submits queued entries if the queue is full
+    io_uring_sqe* getSqe();
+
+    // submit queued entries and wait for waitCount completions
+    // returns number of submitted entries or -errno
+    int submit(unsigned waitCount = 0);
+
+    // call f(const io_uring_cqe&) for all available completions
+    template<typename F>
+    unsigned forEachCompletion(F f)
+    {
+        unsigned head = *m_cqHead;
+        unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+
+        while (head != tail)
+        {
+            f(m_cqes[head & *m_cqMask]);
+            head++;
+            count++;
+        }
+
+        __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    // fixed files, -1 entries are empty
+    bool registerFiles(const int* fds, unsigned count);
+    bool updateFile(unsigned index, int fd);
+
+private:
+    int m_fd{-1};
+
+    void* m_sqRing{nullptr};
+    size_t m_sqRingSize{0};
+    void* m_cqRing{nullptr};
+    size_t m_cqRingSize{0};
+    io_uring_sqe* m_sqes{nullptr};
+    size_t m_sqesSize{0};
+
+    unsigned* m_sqHead{nullptr};
+    unsigned* m_sqTail{nullptr};
+    unsigned* m_sqMask{nullptr};
+    unsigned* m_sqEntries{nullptr};
+    unsigned* m_sqArray{nullptr};
+
+    unsigned* m_cqHead{nullptr};
+    unsigned* m_cqTail{nullptr};
+    unsigned* m_cqMask{nullptr};
+    io_uring_cqe* m_cqes{nullptr};
+
+    // entries prepared but not submitted
+    unsigned m_queued{0};
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_IOURING_H
@@ -0,0 +1,877 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "iouringtransporter.h"
+
+#include <cstring>
+#include <deque>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+static const size_t RECV_SIZE = 64 * 1024;
+static const size_t MAX_IOV = 64;
+
+// user data of operations without connection
+// connection operations use the connection address plus an op tag
+static const uint64_t ACCEPT_TAG = 1;
+static const uint64_t WAKE_TAG = 2;
+static const uint64_t CANCEL_TAG = 3;
+
+static const uint64_t OP_RECV = 1;
+static const uint64_t OP_SEND = 2;
+static const uint64_t OP_MASK = 7;
+
+struct IoUringConnection
+{
+    struct OutMessage
+    {
+        char header[TcpStream::HEADER_SIZE];
+        SharedBuffer buffer;
+    };
+
+    int fd{-1};
+    // fixed file slot or -1
+    int file{-1};
+
+    std::vector<char> in;
+    size_t inStart{0};
+    size_t inEnd{0};
+
+    // deque keeps headers in place while a send is in flight
+    std::deque<OutMessage> out;
+    size_t outOffset{0};
+    iovec iov[MAX_IOV];
+    msghdr msg;
+
+    bool receiving{false};
+    bool sending{false};
+    bool dirty{false};
+    bool closed{false};
+};
+
+static void prepareFd(io_uring_sqe* sqe, IoUringConnection* connection)
+{
+    if (connection->file >= 0)
+    {
+        sqe->fd = connection->file;
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    else
+    {
+        sqe->fd = connection->fd;
+    }
+}
+
+
+//------------------------------------------------------------------
+// FallbackReceiver
+void IoUringServerTransporter::FallbackReceiver::received(std::istream& data, ServerTransporter& /*transporter*/, void* id)
+{
+    m_owner._received(data, id);
+}
+
+void IoUringServerTransporter::FallbackReceiver::received(const char* data, size_t size, ServerTransporter& /*transporter*/, void* id)
+{
+    m_owner._received(data, size, id);
+}
+
+void IoUringServerTransporter::FallbackReceiver::clientConnected(ServerTransporter& /*transporter*/, void* id)
+{
+    m_owner._clientConnected(id);
+}
+
+void IoUringServerTransporter::FallbackReceiver::clientDisconnected(ServerTransporter& /*transporter*/, void* id)
+{
+    m_owner._clientDisconnected(id);
+}
+
+
+//------------------------------------------------------------------
+// IoUringServerTransporter
+IoUringServerTransporter::IoUringServerTransporter()
+    : m_fallbackReceiver(*this)
+{
+}
+
+IoUringServerTransporter::~IoUringServerTransporter()
+{
+    unbind();
+}
+
+void IoUringServerTransporter::bind(int port)
+{
+    if (isBound())
+    {
+        unbind();
+    }
+
+    if (!m_forceEpoll &&
+        m_ring.init(DEFAULT_RING_ENTRIES))
+    {
+        _bindRing(port);
+        return;
+    }
+
+    _bindFallback(port);
+}
+
+void IoUringServerTransporter::unbind()
+{
+    if (m_fallback)
+    {
+        m_fallback->unbind();
+        m_fallback.reset();
+        return;
+    }
+
+    if (!m_thread.joinable())
+    {
+        return;
+    }
+
+    m_running = false;
+
+    uint64_t one = 1;
+    if (::write(m_wakeFd, &one, sizeof(one)) < 0)
+    {
+        std::cerr << "IoUringServerTransporter: could not wake ring thread: " << errno << "\n";
+    }
+
+    m_thread.join();
+
+    m_connections.clear();
+    m_dirty.clear();
+    m_freeFiles.clear();
+    m_connectionCount = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pending.clear();
+        m_wakeSignaled = false;
+    }
+
+    TcpSocket::close(m_listenFd);
+    m_listenFd = -1;
+    ::close(m_wakeFd);
+    m_wakeFd = -1;
+
+    m_ring.close();
+}
+
+void IoUringServerTransporter::sendToOne(const char* data, size_t size, void* id)
+{
+    sendToOne(SharedBuffer(data, size), id);
+}
+
+void IoUringServerTransporter::sendToAll(const char* data, size_t size, void* excludeId)
+{
+    sendToAll(SharedBuffer(data, size), excludeId);
+}
+
+void IoUringServerTransporter::sendToOne(const SharedBuffer& buffer, void* id)
+{
+    if (m_fallback)
+    {
+        m_fallback->sendToOne(buffer, id);
+        return;
+    }
+
+    _queue(buffer, id, false);
+}
+
+void IoUringServerTransporter::sendToAll(const SharedBuffer& buffer, void* excludeId)
+{
+    if (m_fallback)
+    {
+        m_fallback->sendToAll(buffer, excludeId);
+        return;
+    }
+
+    _queue(buffer, excludeId, true);
+}
+
+void IoUringServerTransporter::sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter)
+{
+    if (m_fallback)
+    {
+        m_fallback->sendToSome(buffer, filter);
+        return;
+    }
+
+    // connections are only known to the ring thread,
+    // the filter can not run there after the call
+    ServerTransporter::sendToSome(buffer, filter);
+}
+
+int IoUringServerTransporter::getConnectionCount()
+{
+    if (m_fallback)
+    {
+        return m_fallback->getConnectionCount();
+    }
+
+    return m_connectionCount;
+}
+
+bool IoUringServerTransporter::_bindRing(int port)
+{
+    int fd = TcpSocket::listen(m_bindAddress, port, m_port);
+    if (fd < 0)
+    {
+        m_ring.close();
+        return false;
+    }
+
+    // io_uring does not wait for readiness on non-blocking files
+    int flags = ::fcntl(fd, F_GETFL);
+    ::fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+
+    m_wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeFd < 0)
+    {
+        std::cerr << "IoUringServerTransporter: eventfd failed: " << errno << "\n";
+        TcpSocket::close(fd);
+        m_ring.close();
+        return false;
+    }
+
+    m_listenFd = fd;
+
+    // sparse table, slots are filled on accept
+    std::vector<int> files(DEFAULT_MAX_FIXED_FILES, -1);
+    if (m_ring.registerFiles(files.data(), static_cast<unsigned>(files.size())))
+    {
+        for (unsigned i = DEFAULT_MAX_FIXED_FILES; i > 0; i--)
+        {
+            m_freeFiles.push_back(i - 1);
+        }
+    }
+
+    m_inflight = 0;
+    _submitAccept();
+    _submitWakeRead();
+
+    m_running = true;
+    m_thread = std::thread([this]() { _run(); });
+    m_threadId = m_thread.get_id();
+
+    return true;
+}
+
+void IoUringServerTransporter::_bindFallback(int port)
+{
+    m_fallback.reset(new TcpServerTransporter());
+    m_fallback->setBindAddress(m_bindAddress);
+    m_fallback->setNoDelay(m_noDelay);
+    m_fallback->setMaxMessageSize(m_maxMessageSize);
+    m_fallback->addReceivedCb(&m_fallbackReceiver, &ServerTransporterReceiver::received);
+
+    m_fallback->bind(port);
+}
+
+void IoUringServerTransporter::_queue(const SharedBuffer& buffer, void* id, bool all)
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    bool wake = false;
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+        m_pending.push_back(PendingSend{buffer, id, all});
+
+        // the ring thread drains before waiting again
+        if (!m_wakeSignaled &&
+            std::this_thread::get_id() != m_threadId)
+        {
+            m_wakeSignaled = true;
+            wake = true;
+        }
+    }
+
+    if (wake)
+    {
+        uint64_t one = 1;
+        if (::write(m_wakeFd, &one, sizeof(one)) < 0)
+        {
+            std::cerr << "IoUringServerTransporter: could not wake ring thread: " << errno << "\n";
+        }
+    }
+}
+
+void IoUringServerTransporter::_run()
+{
+    while (m_running)
+    {
+        _drainPending();
+
+        // submit everything queued and wait for one completion
+        int result = m_ring.submit(1);
+        if (result < 0 &&
+            result != -EBUSY &&
+            result != -EAGAIN)
+        {
+            std::cerr << "IoUringServerTransporter: io_uring_enter failed: " << -result << "\n";
+            break;
+        }
+
+        m_ring.forEachCompletion([this](const io_uring_cqe& cqe) {
+            _handleCompletion(cqe.user_data, cqe.res);
+        });
+    }
+
+    _shutdown();
+}
+
+void IoUringServerTransporter::_drainPending()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_pendingMutex);
+        m_pendingSwap.swap(m_pending);
+        m_wakeSignaled = false;
+    }
+
+    for (auto& pending : m_pendingSwap)
+    {
+        if (pending.all)
+        {
+            for (auto& kv : m_connections)
+            {
+                if (kv.first != pending.id)
+                {
+                    _queueSend(kv.second.get(), pending.buffer);
+                }
+            }
+        }
+        else
+        {
+            auto it = m_connections.find(pending.id);
+            if (it != m_connections.end())
+            {
+                _queueSend(it->second.get(), pending.buffer);
+            }
+        }
+    }
+
+    m_pendingSwap.clear();
+
+    // one gathered send per connection
+    for (IoUringConnection* connection : m_dirty)
+    {
+        connection->dirty = false;
+
+        if (!connection->closed &&
+            !connection->sending)
+        {
+            _submitSend(connection);
+        }
+    }
+
+    m_dirty.clear();
+}
+
+void IoUringServerTransporter::_handleCompletion(uint64_t userData, int result)
+{
+    m_inflight--;
+
+    if (userData == ACCEPT_TAG)
+    {
+        if (result >= 0)
+        {
+            _accepted(result);
+        }
+
+        if (!m_running)
+        {
+            return;
+        }
+
+        if (result == -EBADF ||
+            result == -EINVAL ||
+            result == -ENOTSOCK)
+        {
+            std::cerr << "IoUringServerTransporter: accept failed: " << -result << "\n";
+            return;
+        }
+
+        _submitAccept();
+    }
+    else if (userData == WAKE_TAG)
+    {
+        // reset the counter, senders signal again after the next drain
+        if (::read(m_wakeFd, &m_wakeValue, sizeof(m_wakeValue)) < 0 &&
+            errno != EAGAIN)
+        {
+            std::cerr << "IoUringServerTransporter: could not read wake event: " << errno << "\n";
+        }
+
+        if (m_running)
+        {
+            _submitWakeRead();
+        }
+    }
+    else if (userData == CANCEL_TAG)
+    {
+    }
+    else
+    {
+        IoUringConnection* connection = reinterpret_cast<IoUringConnection*>(userData & ~OP_MASK);
+
+        if ((userData & OP_MASK) == OP_RECV)
+        {
+            _recvCompleted(connection, result);
+        }
+        else
+        {
+            _sendCompleted(connection, result);
+        }
+    }
+}
+
+void IoUringServerTransporter::_accepted(int fd)
+{
+    if (!m_running)
+    {
+        ::close(fd);
+        return;
+    }
+
+    TcpSocket::setNoDelay(fd, m_noDelay);
+
+    std::unique_ptr<IoUringConnection> connection(new IoUringConnection());
+    connection->fd = fd;
+
+    if (!m_freeFiles.empty() &&
+        m_ring.updateFile(m_freeFiles.back(), fd))
+    {
+        connection->file = static_cast<int>(m_freeFiles.back());
+        m_freeFiles.pop_back();
+    }
+
+    IoUringConnection* c = connection.get();
+    m_connections[c] = std::move(connection);
+    m_connectionCount++;
+
+    _clientConnected(c);
+
+    if (!_submitRecv(c))
+    {
+        _close(c);
+    }
+}
+
+void IoUringServerTransporter::_queueSend(IoUringConnection* connection, const SharedBuffer& buffer)
+{
+    if (connection->closed)
+    {
+        return;
+    }
+
+    uint32_t size = static_cast<uint32_t>(buffer.size());
+
+    connection->out.emplace_back();
+    IoUringConnection::OutMessage& message = connection->out.back();
+    message.header[0] = static_cast<char>((size >> 24) & 0xFF);
+    message.header[1] = static_cast<char>((size >> 16) & 0xFF);
+    message.header[2] = static_cast<char>((size >> 8) & 0xFF);
+    message.header[3] = static_cast<char>(size & 0xFF);
+    message.buffer = buffer;
+
+    if (!connection->dirty)
+    {
+        connection->dirty = true;
+        m_dirty.push_back(connection);
+    }
+}
+
+void IoUringServerTransporter::_recvCompleted(IoUringConnection* connection, int result)
+{
+    connection->receiving = false;
+
+    if (connection->closed)
+    {
+        _release(connection);
+        return;
+    }
+
+    if (result == -EINTR ||
+        result == -EAGAIN)
+    {
+        _submitRecv(connection);
+        return;
+    }
+
+    if (result <= 0)
+    {
+        // closed by peer or broken
+        _close(connection);
+        return;
+    }
+
+    connection->inEnd += static_cast<size_t>(result);
+
+    while (connection->inEnd - connection->inStart >= TcpStream::HEADER_SIZE)
+    {
+        const unsigned char* h = reinterpret_cast<const unsigned char*>(connection->in.data() + connection->inStart);
+        size_t size = (size_t(h[0]) << 24) | (size_t(h[1]) << 16) | (size_t(h[2]) << 8) | size_t(h[3]);
+
+        if (size > m_maxMessageSize)
+        {
+            std::cerr << "IoUringServerTransporter: message too big: " << size << "\n";
+            _close(connection);
+            return;
+        }
+
+        size_t message_size = TcpStream::HEADER_SIZE + size;
+
+        if (connection->inEnd - connection->inStart < message_size)
+        {
+            // make sure the whole message fits
+            if (connection->in.size() - connection->inStart < message_size)
+            {
+                std::memmove(connection->in.data(),
+                             connection->in.data() + connection->inStart,
+                             connection->inEnd - connection->inStart);
+                connection->inEnd -= connection->inStart;
+                connection->inStart = 0;
+
+                if (connection->in.size() < message_size)
+                {
+                    connection->in.resize(message_size);
+                }
+            }
+            break;
+        }
+
+        _received(connection->in.data() + connection->inStart + TcpStream::HEADER_SIZE, size, connection);
+        connection->inStart += message_size;
+    }
+
+    if (connection->inStart == connection->inEnd)
+    {
+        connection->inStart = 0;
+        connection->inEnd = 0;
+    }
+
+    if (!_submitRecv(connection))
+    {
+        _close(connection);
+    }
+}
+
+void IoUringServerTransporter::_sendCompleted(IoUringConnection* connection, int result)
+{
+    connection->sending = false;
+
+    if (connection->closed)
+    {
+        _release(connection);
+        return;
+    }
+
+    if (result == -EINTR ||
+        result == -EAGAIN)
+    {
+        _submitSend(connection);
+        return;
+    }
+
+    if (result < 0)
+    {
+        _close(connection);
+        return;
+    }
+
+    // drop what was written
+    size_t written = static_cast<size_t>(result);
+
+    while (written > 0 &&
+           !connection->out.empty())
+    {
+        size_t message_size = TcpStream::HEADER_SIZE + connection->out.front().buffer.size();
+        size_t left = message_size - connection->outOffset;
+
+        if (written >= left)
+        {
+            written -= left;
+            connection->out.pop_front();
+            connection->outOffset = 0;
+        }
+        else
+        {
+            connection->outOffset += written;
+            written = 0;
+        }
+    }
+
+    if (!connection->out.empty())
+    {
+        _submitSend(connection);
+    }
+}
+
+void IoUringServerTransporter::_close(IoUringConnection* connection)
+{
+    if (connection->closed)
+    {
+        return;
+    }
+
+    connection->closed = true;
+    m_connectionCount--;
+
+    // completes operations in flight
+    ::shutdown(connection->fd, SHUT_RDWR);
+
+    _clientDisconnected(connection);
+    _release(connection);
+}
+
+void IoUringServerTransporter::_release(IoUringConnection* connection)
+{
+    if (connection->receiving ||
+        connection->sending)
+    {
+        return;
+    }
+
+    if (connection->file >= 0)
+    {
+        m_ring.updateFile(static_cast<unsigned>(connection->file), -1);
+        m_freeFiles.push_back(static_cast<unsigned>(connection->file));
+    }
+
+    ::close(connection->fd);
+
+    // removed from dirty list on next drain
+    if (connection->dirty)
+    {
+        for (auto it = m_dirty.begin(); it != m_dirty.end(); ++it)
+        {
+            if (*it == connection)
+            {
+                m_dirty.erase(it);
+                break;
+            }
+        }
+    }
+
+    m_connections.erase(connection);
+}
+
+void IoUringServerTransporter::_shutdown()
+{
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (sqe)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = ACCEPT_TAG;
+        sqe->user_data = CANCEL_TAG;
+        m_inflight++;
+    }
+
+    sqe = m_ring.getSqe();
+    if (sqe)
+    {
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = WAKE_TAG;
+        sqe->user_data = CANCEL_TAG;
+        m_inflight++;
+    }
+
+    std::vector<IoUringConnection*> connections;
+    for (auto& kv : m_connections)
+    {
+        connections.push_back(kv.second.get());
+    }
+
+    for (IoUringConnection* connection : connections)
+    {
+        _close(connection);
+    }
+
+    // buffers have to outlive operations in flight
+    while (m_inflight > 0)
+    {
+        int result = m_ring.submit(1);
+        if (result < 0 &&
+            result != -EBUSY &&
+            result != -EAGAIN)
+        {
+            std::cerr << "IoUringServerTransporter: io_uring_enter failed: " << -result << "\n";
+            break;
+        }
+
+        m_ring.forEachCompletion([this](const io_uring_cqe& cqe) {
+            _handleCompletion(cqe.user_data, cqe.res);
+        });
+    }
+}
+
+bool IoUringServerTransporter::_submitAccept()
+{
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (!sqe)
+    {
+        std::cerr << "IoUringServerTransporter: submission queue full\n";
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = m_listenFd;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = ACCEPT_TAG;
+    m_inflight++;
+
+    return true;
+}
+
+bool IoUringServerTransporter::_submitWakeRead()
+{
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (!sqe)
+    {
+        std::cerr << "IoUringServerTransporter: submission queue full\n";
+        return false;
+    }
+
+    // poll and read on completion, reading an eventfd would block a worker
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = m_wakeFd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = WAKE_TAG;
+    m_inflight++;
+
+    return true;
+}
+
+bool IoUringServerTransporter::_submitRecv(IoUringConnection* connection)
+{
+    if (connection->in.size() - connection->inEnd < RECV_SIZE / 4)
+    {
+        // make room: move unconsumed data to the front, then grow
+        if (connection->inStart > 0)
+        {
+            std::memmove(connection->in.data(),
+                         connection->in.data() + connection->inStart,
+                         connection->inEnd - connection->inStart);
+            connection->inEnd -= connection->inStart;
+            connection->inStart = 0;
+        }
+
+        if (connection->in.size() - connection->inEnd < RECV_SIZE / 4)
+        {
+            connection->in.resize(connection->in.size() + RECV_SIZE);
+        }
+    }
+
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (!sqe)
+    {
+        std::cerr << "IoUringServerTransporter: submission queue full\n";
+        return false;
+    }
+
+    sqe->opcode = IORING_OP_RECV;
+    prepareFd(sqe, connection);
+    sqe->addr = reinterpret_cast<uint64_t>(connection->in.data() + connection->inEnd);
+    sqe->len = static_cast<uint32_t>(connection->in.size() - connection->inEnd);
+    sqe->user_data = reinterpret_cast<uint64_t>(connection) | OP_RECV;
+
+    connection->receiving = true;
+    m_inflight++;
+
+    return true;
+}
+
+bool IoUringServerTransporter::_submitSend(IoUringConnection* connection)
+{
+    // gather as many queued messages as fit
+    size_t count = 0;
+    size_t offset = connection->outOffset;
+
+    for (auto it = connection->out.begin(); it != connection->out.end() && count + 2 <= MAX_IOV; ++it)
+    {
+        if (offset < TcpStream::HEADER_SIZE)
+        {
+            connection->iov[count].iov_base = it->header + offset;
+            connection->iov[count].iov_len = TcpStream::HEADER_SIZE - offset;
+            count++;
+            offset = 0;
+        }
+        else
+        {
+            offset -= TcpStream::HEADER_SIZE;
+        }
+
+        if (it->buffer.size() > offset)
+        {
+            connection->iov[count].iov_base = const_cast<char*>(it->buffer.data()) + offset;
+            connection->iov[count].iov_len = it->buffer.size() - offset;
+            count++;
+        }
+
+        offset = 0;
+    }
+
+    if (count == 0)
+    {
+        return true;
+    }
+
+    io_uring_sqe* sqe = m_ring.getSqe();
+    if (!sqe)
+    {
+        std::cerr << "IoUringServerTransporter: submission queue full\n";
+        return false;
+    }
+
+    std::memset(&connection->msg, 0, sizeof(connection->msg));
+    connection->msg.msg_iov = connection->iov;
+    connection->msg.msg_iovlen = count;
+
+    sqe->opcode = IORING_OP_SENDMSG;
+    prepareFd(sqe, connection);
+    sqe->addr = reinterpret_cast<uint64_t>(&connection->msg);
+    sqe->len = 1;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = reinterpret_cast<uint64_t>(connection) | OP_SEND;
+
+    connection->sending = true;
+    m_inflight++;
+
+    return true;
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,186 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_IOURINGTRANSPORTER_H
+#define RCP_IOURINGTRANSPORTER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "servertransporter.h"
+#include "sharedbuffer.h"
+#include "iouring.h"
+#include "tcptransporter.h"
+
+namespace rcp {
+
+struct IoUringConnection;
+
+/*
+* IoUringServerTransporter - io_uring based tcp server
+*
+* same wire format as TcpServerTransporter, clients connect with
+* TcpClientTransporter.
+*
+* accept, receive and send run as io_uring operations on one thread.
+* sends from other threads are queued and handed to the ring thread,
+* which gathers the queued packet buffers of a connection into one
+* sendmsg and submits the sends of all connections with one system call.
+* the packet buffers are referenced, not copied.
+* connection sockets are registered with the ring (fixed files).
+*
+* if io_uring is not available bind() falls back to an epoll based
+* TcpServerTransporter, usingIoUring() tells which one is active.
+*/
+class IoUringServerTransporter : public ServerTransporter
+{
+public:
+    static const unsigned DEFAULT_RING_ENTRIES = 256;
+    static const unsigned DEFAULT_MAX_FIXED_FILES = 1024;
+
+    static bool isSupported() { return IoUring::isSupported(); }
+
+public:
+    IoUringServerTransporter();
+    ~IoUringServerTransporter();
+
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    // ServerTransporter
+    void bind(int port) override;
+    void unbind() override;
+
+    void sendToOne(const char* data, size_t size, void* id) override;
+    void sendToAll(const char* data, size_t size, void* excludeId) override;
+    void sendToOne(const SharedBuffer& buffer, void* id) override;
+    void sendToAll(const SharedBuffer& buffer, void* excludeId) override;
+    void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter) override;
+
+    int getConnectionCount() override;
+
+public:
+    // address to bind to, default: all interfaces
+    // call before bind()
+    void setBindAddress(const std::string& address) { m_bindAddress = address; }
+
+    // disable nagle, default: true
+    void setNoDelay(bool noDelay) { m_noDelay = noDelay; }
+    bool getNoDelay() const { return m_noDelay; }
+
+    // connections sending bigger messages are closed, call before bind()
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    // use the epoll transporter even if io_uring is available
+    // call before bind()
+    void setForceEpoll(bool force) { m_forceEpoll = force; }
+
+    bool usingIoUring() const { return m_ring.isOpen(); }
+    bool isBound() const { return m_listenFd >= 0 || (m_fallback && m_fallback->isBound()); }
+    // bound port, useful after bind(0)
+    int getPort() const { return m_fallback ? m_fallback->getPort() : m_port; }
+
+private:
+    // forwards callbacks of the fallback transporter
+    class FallbackReceiver : public ServerTransporterReceiver
+    {
+    public:
+        FallbackReceiver(IoUringServerTransporter& owner)
+            : m_owner(owner)
+        {}
+
+        void received(std::istream& data, ServerTransporter& transporter, void* id) override;
+        void received(const char* data, size_t size, ServerTransporter& transporter, void* id) override;
+        void clientConnected(ServerTransporter& transporter, void* id) override;
+        void clientDisconnected(ServerTransporter& transporter, void* id) override;
+
+    private:
+        IoUringServerTransporter& m_owner;
+    };
+
+    struct PendingSend
+    {
+        SharedBuffer buffer;
+        void* id;
+        bool all;
+    };
+
+    bool _bindRing(int port);
+    void _bindFallback(int port);
+    void _queue(const SharedBuffer& buffer, void* id, bool all);
+
+    // ring thread
+    void _run();
+    void _drainPending();
+    void _handleCompletion(uint64_t userData, int result);
+    void _accepted(int fd);
+    void _queueSend(IoUringConnection* connection, const SharedBuffer& buffer);
+    void _recvCompleted(IoUringConnection* connection, int result);
+    void _sendCompleted(IoUringConnection* connection, int result);
+    void _close(IoUringConnection* connection);
+    void _release(IoUringConnection* connection);
+    void _shutdown();
+
+    bool _submitAccept();
+    bool _submitWakeRead();
+    bool _submitRecv(IoUringConnection* connection);
+    bool _submitSend(IoUringConnection* connection);
+
+    std::string m_bindAddress;
+    bool m_noDelay{true};
+    size_t m_maxMessageSize{TcpStream::DEFAULT_MAX_MESSAGE_SIZE};
+    bool m_forceEpoll{false};
+
+    std::unique_ptr<TcpServerTransporter> m_fallback;
+    FallbackReceiver m_fallbackReceiver;
+
+    IoUring m_ring;
+    std::thread m_thread;
+    std::thread::id m_threadId;
+    std::atomic<bool> m_running{false};
+    int m_listenFd{-1};
+    int m_port{0};
+    int m_wakeFd{-1};
+    uint64_t m_wakeValue{0};
+    unsigned m_inflight{0};
+
+    // fixed file slots, connections without slot use the plain fd
+    std::vector<unsigned> m_freeFiles;
+
+    // ring thread only
+    std::unordered_map<void*, std::unique_ptr<IoUringConnection>> m_connections;
+    std::vector<IoUringConnection*> m_dirty;
+    std::atomic<int> m_connectionCount{0};
+
+    std::mutex m_pendingMutex;
+    std::vector<PendingSend> m_pending;
+    std::vector<PendingSend> m_pendingSwap;
+    bool m_wakeSignaled{false};
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_IOURINGTRANSPORTER_H
@@ -51,7 +51,7 @@ IPv6& swap_endian(IPv6 &u)
     return u;
 }
 
-IPv4 readFromStream(std::istream& is, const IPv4& /*i*/)
+IPv4 readFromStream(ByteReader& is, const IPv4& /*i*/)
 {
     uint32_t value;
     is.read(reinterpret_cast<char *>(&value), sizeof(uint32_t));
@@ -63,7 +63,7 @@ IPv4 readFromStream(std::istream& is, const IPv4& /*i*/)
     return IPv4(value);
 }
 
-IPv6 readFromStream(std::istream& is, const IPv6& /*i*/)
+IPv6 readFromStream(ByteReader& is, const IPv6& /*i*/)
 {
     uint32_t val1;
     uint32_t val2;
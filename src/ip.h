@@ -21,6 +21,8 @@
 #include <ostream>
 #include <inttypes.h>
 
+#include "bytereader.h"
+
 namespace rcp {
 
 class IPv4
@@ -111,8 +113,8 @@ std::ostream& operator<<(std::ostream& out, const IPv6& v);
 IPv4& swap_endian(const IPv4 &u);
 IPv6& swap_endian(const IPv6 &u);
 
-IPv4 readFromStream(std::istream& is, const IPv4& i);
-IPv6 readFromStream(std::istream& is, const IPv6& i);
+IPv4 readFromStream(ByteReader& is, const IPv4& i);
+IPv6 readFromStream(ByteReader& is, const IPv6& i);
 
 }
 
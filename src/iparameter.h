@@ -53,6 +53,9 @@ public:
     virtual datatype_t getDatatype() const = 0;
 
     virtual void writeUpdateValue(Writer& out) const = 0;
+    // read the value of an update-value packet into this parameter
+    // id and datatype are already consumed
+    virtual bool readUpdateValue(ByteReader& is) = 0;
 
     //--------------------------------
     // optional
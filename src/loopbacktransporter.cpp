@@ -0,0 +1,499 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#include "loopbacktransporter.h"
+
+#include <algorithm>
+
+namespace rcp {
+
+//------------------------------------------------------------------
+// LoopbackWorker
+LoopbackWorker::~LoopbackWorker()
+{
+    stop();
+}
+
+void LoopbackWorker::start(std::function<size_t()> process)
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+
+    m_running.store(true, std::memory_order_release);
+
+    m_thread = std::thread([this, process]() {
+
+        size_t idle = 0;
+
+        while (m_running.load(std::memory_order_acquire))
+        {
+            if (process() > 0)
+            {
+                idle = 0;
+            }
+            else if (++idle < 64)
+            {
+                std::this_thread::yield();
+            }
+            else
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        }
+    });
+}
+
+void LoopbackWorker::stop()
+{
+    m_running.store(false, std::memory_order_release);
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+}
+
+
+//------------------------------------------------------------------
+// LoopbackConnection
+const int LoopbackConnection::Direction::PUSH_TIMEOUT_MS;
+
+bool LoopbackConnection::Direction::push(const SharedBuffer& buffer, clock::duration latency)
+{
+    Message message;
+    message.buffer = buffer;
+    if (latency > clock::duration::zero())
+    {
+        message.due = clock::now() + latency;
+    }
+
+    std::lock_guard<std::mutex> lock(producerMutex);
+
+    clock::time_point deadline;
+
+    while (!queue.push(message))
+    {
+        if (!consumerWorker.load(std::memory_order_acquire))
+        {
+            // nobody will make room
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // the consumer may itself wait for a queue we hold up,
+        // e.g. a server forwarding from its receive callback
+        clock::time_point now = clock::now();
+        if (deadline == clock::time_point())
+        {
+            deadline = now + std::chrono::milliseconds(PUSH_TIMEOUT_MS);
+        }
+        else if (now >= deadline)
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------
+// LoopbackServerTransporter
+LoopbackServerTransporter::LoopbackServerTransporter(size_t queueCapacity)
+    : m_capacity(queueCapacity)
+{
+}
+
+LoopbackServerTransporter::~LoopbackServerTransporter()
+{
+    stopWorker();
+    unbind();
+}
+
+void LoopbackServerTransporter::bind(int port)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_port = port;
+    m_bound.store(true, std::memory_order_release);
+}
+
+void LoopbackServerTransporter::unbind()
+{
+    std::vector<LoopbackConnectionPtr> closed;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_bound.store(false, std::memory_order_release);
+
+        // clients see the closed connection in their next process()
+        for (auto& connection : m_connections)
+        {
+            connection->open.store(false, std::memory_order_release);
+        }
+        closed.swap(m_connections);
+    }
+
+    for (auto& connection : closed)
+    {
+        _clientDisconnected(connection.get());
+    }
+}
+
+void LoopbackServerTransporter::sendToOne(const char* data, size_t size, void* id)
+{
+    sendToOne(SharedBuffer(data, size), id);
+}
+
+void LoopbackServerTransporter::sendToAll(const char* data, size_t size, void* excludeId)
+{
+    sendToAll(SharedBuffer(data, size), excludeId);
+}
+
+void LoopbackServerTransporter::sendToOne(const SharedBuffer& buffer, void* id)
+{
+    LoopbackConnectionPtr connection = _find(id);
+
+    if (connection &&
+        connection->open.load(std::memory_order_acquire))
+    {
+        connection->toClient.push(buffer, m_latency);
+    }
+}
+
+void LoopbackServerTransporter::sendToAll(const SharedBuffer& buffer, void* excludeId)
+{
+    sendToSome(buffer, [excludeId](void* id) { return id != excludeId; });
+}
+
+void LoopbackServerTransporter::sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter)
+{
+    std::lock_guard<std::mutex> send_lock(m_sendMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sendList = m_connections;
+    }
+
+    for (auto& connection : m_sendList)
+    {
+        if (connection->open.load(std::memory_order_acquire) &&
+            filter(connection.get()))
+        {
+            connection->toClient.push(buffer, m_latency);
+        }
+    }
+
+    m_sendList.clear();
+}
+
+int LoopbackServerTransporter::getConnectionCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_connections.size());
+}
+
+size_t LoopbackServerTransporter::process()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_processList = m_connections;
+    }
+
+    size_t count = 0;
+
+    for (auto& connection : m_processList)
+    {
+        if (!connection->open.load(std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        LoopbackConnection* id = connection.get();
+        count += connection->toServer.pop([this, id](const SharedBuffer& buffer) {
+            _received(buffer.data(), buffer.size(), id);
+        });
+    }
+
+    m_processList.clear();
+
+    return count;
+}
+
+void LoopbackServerTransporter::startWorker()
+{
+    m_worker.start([this]() { return process(); });
+    _setConsumerWorker(true);
+}
+
+void LoopbackServerTransporter::stopWorker()
+{
+    _setConsumerWorker(false);
+    m_worker.stop();
+}
+
+size_t LoopbackServerTransporter::droppedCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t dropped = 0;
+    for (auto& connection : m_connections)
+    {
+        dropped += connection->toClient.dropped.load(std::memory_order_relaxed);
+    }
+
+    return dropped;
+}
+
+bool LoopbackServerTransporter::_attach(const LoopbackConnectionPtr& connection, int port)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_bound.load(std::memory_order_acquire) ||
+            port != m_port)
+        {
+            return false;
+        }
+
+        connection->toServer.consumerWorker.store(m_worker.running(), std::memory_order_release);
+        m_connections.push_back(connection);
+    }
+
+    _clientConnected(connection.get());
+
+    return true;
+}
+
+void LoopbackServerTransporter::_detach(LoopbackConnection* connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = std::find_if(m_connections.begin(), m_connections.end(),
+                               [connection](const LoopbackConnectionPtr& c) { return c.get() == connection; });
+
+        if (it == m_connections.end())
+        {
+            return;
+        }
+
+        m_connections.erase(it);
+    }
+
+    _clientDisconnected(connection);
+}
+
+void LoopbackServerTransporter::_setConsumerWorker(bool worker)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& connection : m_connections)
+    {
+        connection->toServer.consumerWorker.store(worker, std::memory_order_release);
+    }
+}
+
+LoopbackConnectionPtr LoopbackServerTransporter::_find(void* id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& connection : m_connections)
+    {
+        if (connection.get() == id)
+        {
+            return connection;
+        }
+    }
+
+    return nullptr;
+}
+
+
+//------------------------------------------------------------------
+// LoopbackClientTransporter
+LoopbackClientTransporter::LoopbackClientTransporter(LoopbackServerTransporter& server)
+    : m_server(server)
+{
+}
+
+LoopbackClientTransporter::~LoopbackClientTransporter()
+{
+    stopWorker();
+
+    LoopbackConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection.swap(m_connection);
+    }
+
+    if (connection)
+    {
+        connection->open.store(false, std::memory_order_release);
+        m_server._detach(connection.get());
+    }
+}
+
+void LoopbackClientTransporter::connect(std::string /*host*/, int port, bool /*secure*/)
+{
+    LoopbackConnectionPtr connection = std::make_shared<LoopbackConnection>(m_server.m_capacity);
+    connection->toClient.consumerWorker.store(m_worker.running(), std::memory_order_release);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (m_connection)
+        {
+            // already connected
+            return;
+        }
+
+        if (!m_server._attach(connection, port))
+        {
+            return;
+        }
+
+        m_connection = connection;
+    }
+
+    _connected();
+}
+
+void LoopbackClientTransporter::disconnect()
+{
+    LoopbackConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection.swap(m_connection);
+    }
+
+    if (!connection)
+    {
+        return;
+    }
+
+    connection->open.store(false, std::memory_order_release);
+    m_server._detach(connection.get());
+
+    _disconnected();
+}
+
+bool LoopbackClientTransporter::isConnected()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_connection && m_connection->open.load(std::memory_order_acquire);
+}
+
+void LoopbackClientTransporter::send(const char* data, size_t size)
+{
+    send(SharedBuffer(data, size));
+}
+
+void LoopbackClientTransporter::send(const SharedBuffer& buffer)
+{
+    LoopbackConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection = m_connection;
+    }
+
+    if (connection &&
+        connection->open.load(std::memory_order_acquire))
+    {
+        connection->toServer.push(buffer, m_latency);
+    }
+}
+
+size_t LoopbackClientTransporter::process()
+{
+    LoopbackConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection = m_connection;
+    }
+
+    if (!connection)
+    {
+        return 0;
+    }
+
+    size_t count = connection->toClient.pop([this](const SharedBuffer& buffer) {
+        _received(buffer.data(), buffer.size());
+    });
+
+    if (!connection->open.load(std::memory_order_acquire))
+    {
+        // closed by the server
+        bool closed = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_connection == connection)
+            {
+                m_connection.reset();
+                closed = true;
+            }
+        }
+
+        if (closed)
+        {
+            _disconnected();
+        }
+    }
+
+    return count;
+}
+
+void LoopbackClientTransporter::startWorker()
+{
+    m_worker.start([this]() { return process(); });
+    _setConsumerWorker(true);
+}
+
+void LoopbackClientTransporter::stopWorker()
+{
+    _setConsumerWorker(false);
+    m_worker.stop();
+}
+
+void LoopbackClientTransporter::_setConsumerWorker(bool worker)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_connection)
+    {
+        m_connection->toClient.consumerWorker.store(worker, std::memory_order_release);
+    }
+}
+
+size_t LoopbackClientTransporter::droppedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_connection)
+    {
+        return 0;
+    }
+
+    return m_connection->toServer.dropped.load(std::memory_order_relaxed);
+}
+
+}
@@ -0,0 +1,274 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_LOOPBACKTRANSPORTER_H
+#define RCP_LOOPBACKTRANSPORTER_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "servertransporter.h"
+#include "clienttransporter.h"
+#include "sharedbuffer.h"
+#include "spscqueue.h"
+
+namespace rcp {
+
+/*
+* LoopbackWorker - thread calling a process function until stopped
+*/
+class LoopbackWorker
+{
+public:
+    LoopbackWorker() {}
+    ~LoopbackWorker();
+
+    LoopbackWorker(const LoopbackWorker&) = delete;
+    LoopbackWorker& operator=(const LoopbackWorker&) = delete;
+
+    // process() returns the number of handled items, 0 when idle
+    void start(std::function<size_t()> process);
+    void stop();
+    bool running() const { return m_running.load(std::memory_order_acquire); }
+
+private:
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+};
+
+
+/*
+* LoopbackConnection - queues between one server and one client
+*
+* each direction is a lock-free spsc queue of refcounted buffers.
+* producers are serialized by a mutex, so a transporter may send from
+* more than one thread. the consumer side does not lock.
+*/
+class LoopbackConnection
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    struct Message
+    {
+        SharedBuffer buffer;
+        // delivery time, default: immediately
+        clock::time_point due;
+    };
+
+    class Direction
+    {
+    public:
+        Direction(size_t capacity)
+            : queue(capacity)
+        {}
+
+        // max time push waits for room
+        static const int PUSH_TIMEOUT_MS = 100;
+
+        // waits while full if the consumer runs a worker, drops otherwise.
+        // the wait is bounded by PUSH_TIMEOUT_MS, then the message is dropped.
+        bool push(const SharedBuffer& buffer, clock::duration latency);
+
+        // deliver all messages that are due
+        template<typename F>
+        size_t pop(F deliver)
+        {
+            size_t count = 0;
+            clock::time_point now;
+
+            Message* message;
+            while ((message = queue.front()) != nullptr)
+            {
+                if (message->due != clock::time_point())
+                {
+                    if (now == clock::time_point())
+                    {
+                        now = clock::now();
+                    }
+
+                    if (message->due > now)
+                    {
+                        break;
+                    }
+                }
+
+                deliver(message->buffer);
+                queue.pop();
+                count++;
+            }
+
+            return count;
+        }
+
+        SpscQueue<Message> queue;
+        std::mutex producerMutex;
+        std::atomic<size_t> dropped{0};
+        // consumer is a worker thread
+        std::atomic<bool> consumerWorker{false};
+    };
+
+public:
+    LoopbackConnection(size_t capacity)
+        : toServer(capacity)
+        , toClient(capacity)
+    {}
+
+    Direction toServer;
+    Direction toClient;
+
+    std::atomic<bool> open{true};
+};
+
+typedef std::shared_ptr<LoopbackConnection> LoopbackConnectionPtr;
+
+
+/*
+* LoopbackServerTransporter - in-process server transporter
+*
+* clients connect with LoopbackClientTransporter.
+* buffers are passed by reference, sendToAll() queues the same
+* buffer to all clients without copying.
+*
+* received data is delivered by process(), either called by the
+* application (deterministic) or by a worker thread (startWorker).
+* the connection id passed to receivers is the LoopbackConnection.
+*
+* the server has to outlive its clients.
+*/
+class LoopbackServerTransporter : public ServerTransporter
+{
+    friend class LoopbackClientTransporter;
+
+public:
+    // queueCapacity: messages per connection and direction
+    LoopbackServerTransporter(size_t queueCapacity = 8192);
+    ~LoopbackServerTransporter();
+
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    // ServerTransporter
+    void bind(int port) override;
+    void unbind() override;
+
+    void sendToOne(const char* data, size_t size, void* id) override;
+    void sendToAll(const char* data, size_t size, void* excludeId) override;
+    void sendToOne(const SharedBuffer& buffer, void* id) override;
+    void sendToAll(const SharedBuffer& buffer, void* excludeId) override;
+    void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter) override;
+
+    int getConnectionCount() override;
+
+public:
+    bool isBound() const { return m_bound.load(std::memory_order_acquire); }
+    int getPort() const { return m_port; }
+
+    // artificial latency for data sent to clients
+    void setLatency(std::chrono::microseconds latency) { m_latency = latency; }
+    std::chrono::microseconds getLatency() const { return m_latency; }
+
+    // deliver received data that is due
+    // returns number of delivered buffers
+    size_t process();
+
+    void startWorker();
+    void stopWorker();
+
+    // messages dropped because a queue was full
+    size_t droppedCount();
+
+private:
+    bool _attach(const LoopbackConnectionPtr& connection, int port);
+    void _detach(LoopbackConnection* connection);
+    void _setConsumerWorker(bool worker);
+    LoopbackConnectionPtr _find(void* id);
+
+    size_t m_capacity;
+    std::atomic<bool> m_bound{false};
+    int m_port{0};
+    std::chrono::microseconds m_latency{0};
+
+    std::mutex m_mutex;
+    std::vector<LoopbackConnectionPtr> m_connections;
+    // copies of m_connections, queues are not pushed or popped under m_mutex
+    std::mutex m_sendMutex;
+    std::vector<LoopbackConnectionPtr> m_sendList;
+    std::vector<LoopbackConnectionPtr> m_processList;
+
+    LoopbackWorker m_worker;
+};
+
+
+/*
+* LoopbackClientTransporter - in-process client transporter
+*
+* connect() attaches to the server if it is bound to the given port,
+* the host is ignored.
+* received data is delivered by process() or a worker thread.
+*/
+class LoopbackClientTransporter : public ClientTransporter
+{
+public:
+    LoopbackClientTransporter(LoopbackServerTransporter& server);
+    ~LoopbackClientTransporter();
+
+    using ClientTransporter::send;
+
+    // ClientTransporter
+    void connect(std::string host, int port, bool secure = false) override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    void send(const char* data, size_t size) override;
+    void send(const SharedBuffer& buffer) override;
+
+public:
+    // artificial latency for data sent to the server
+    void setLatency(std::chrono::microseconds latency) { m_latency = latency; }
+    std::chrono::microseconds getLatency() const { return m_latency; }
+
+    // deliver received data that is due
+    // returns number of delivered buffers
+    size_t process();
+
+    void startWorker();
+    void stopWorker();
+
+    // messages dropped because a queue was full
+    size_t droppedCount() const;
+
+private:
+    void _setConsumerWorker(bool worker);
+
+    LoopbackServerTransporter& m_server;
+    std::chrono::microseconds m_latency{0};
+
+    LoopbackConnectionPtr m_connection;
+    mutable std::mutex m_mutex;
+
+    LoopbackWorker m_worker;
+};
+
+}
+
+#endif // RCP_LOOPBACKTRANSPORTER_H
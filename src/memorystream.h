@@ -0,0 +1,101 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_MEMORYSTREAM_H
+#define RCP_MEMORYSTREAM_H
+
+#include <istream>
+#include <streambuf>
+
+namespace rcp {
+
+/*
+* MemoryStreamBuffer exposes an existing block of memory as a read-only streambuf.
+* the memory is not copied and must outlive the buffer.
+*/
+class MemoryStreamBuffer
+    : public std::streambuf
+{
+public:
+    MemoryStreamBuffer(const char* data, size_t size)
+    {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    pos_type seekoff(off_type off,
+                     std::ios_base::seekdir dir,
+                     std::ios_base::openmode which = std::ios_base::in) override
+    {
+        if (!(which & std::ios_base::in))
+        {
+            return pos_type(off_type(-1));
+        }
+
+        char* target = nullptr;
+
+        if (dir == std::ios_base::beg)
+        {
+            target = eback() + off;
+        }
+        else if (dir == std::ios_base::cur)
+        {
+            target = gptr() + off;
+        }
+        else
+        {
+            target = egptr() + off;
+        }
+
+        if (target < eback() || target > egptr())
+        {
+            return pos_type(off_type(-1));
+        }
+
+        setg(eback(), target, egptr());
+        return pos_type(off_type(target - eback()));
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, which);
+    }
+};
+
+
+/*
+* MemoryInputStream - std::istream reading directly from memory without a copy
+*/
+class MemoryInputStream
+    : public std::istream
+{
+public:
+    MemoryInputStream(const char* data, size_t size)
+        : std::istream(nullptr)
+        , m_buffer(data, size)
+    {
+        rdbuf(&m_buffer);
+    }
+
+private:
+    MemoryStreamBuffer m_buffer;
+};
+
+}
+
+#endif // RCP_MEMORYSTREAM_H
@@ -0,0 +1,507 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "multicast.h"
+
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+static bool parseAddress(const std::string& address, in_addr& out)
+{
+    if (address.empty())
+    {
+        out.s_addr = htonl(INADDR_ANY);
+        return true;
+    }
+
+    return inet_pton(AF_INET, address.c_str(), &out) == 1;
+}
+
+static const size_t MAX_DATAGRAM_SIZE = 64 * 1024;
+
+
+//------------------------------------------------------------------
+// MulticastSender
+const uint32_t MulticastSender::DEFAULT_HEARTBEAT_MS;
+
+MulticastSender::MulticastSender()
+    : m_history(HISTORY_SIZE)
+{
+    std::memset(&m_group, 0, sizeof(m_group));
+}
+
+MulticastSender::~MulticastSender()
+{
+    close();
+}
+
+bool MulticastSender::open(const std::string& group, int port, const std::string& interfaceAddress, int ttl)
+{
+    close();
+
+    if (m_maxDatagramSize <= Multicast::HEADER_SIZE ||
+        m_maxDatagramSize > MAX_DATAGRAM_SIZE)
+    {
+        std::cerr << "MulticastSender: invalid datagram size: " << m_maxDatagramSize << "\n";
+        return false;
+    }
+
+    in_addr group_addr;
+    in_addr interface_addr;
+    if (!parseAddress(group, group_addr) ||
+        !IN_MULTICAST(ntohl(group_addr.s_addr)))
+    {
+        std::cerr << "MulticastSender: invalid group: " << group << "\n";
+        return false;
+    }
+
+    if (!parseAddress(interfaceAddress, interface_addr))
+    {
+        std::cerr << "MulticastSender: invalid interface address: " << interfaceAddress << "\n";
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        std::cerr << "MulticastSender: socket failed: " << errno << "\n";
+        return false;
+    }
+
+    unsigned char ttl_value = static_cast<unsigned char>(ttl);
+    unsigned char loop = 1;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl_value, sizeof(ttl_value));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    if (!interfaceAddress.empty() &&
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interface_addr, sizeof(interface_addr)) != 0)
+    {
+        std::cerr << "MulticastSender: could not use interface " << interfaceAddress << ": " << errno << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    // bound to an ephemeral port, loss reports come back here
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_addr = interface_addr;
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        std::cerr << "MulticastSender: bind failed: " << errno << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    m_group.sin_family = AF_INET;
+    m_group.sin_port = htons(static_cast<uint16_t>(port));
+    m_group.sin_addr = group_addr;
+
+    std::random_device random;
+    m_session = random();
+    m_sequence = 0;
+
+    m_datagram.clear();
+    m_datagram.reserve(m_maxDatagramSize);
+    m_datagram.resize(Multicast::HEADER_SIZE);
+    m_ids.clear();
+    m_lastSend = std::chrono::steady_clock::time_point();
+
+    for (HistoryEntry& entry : m_history)
+    {
+        entry.valid = false;
+        entry.ids.clear();
+    }
+
+    m_fd = fd;
+
+    return true;
+}
+
+void MulticastSender::close()
+{
+    if (m_fd >= 0)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool MulticastSender::add(int16_t id, const char* data, size_t size)
+{
+    if (m_fd < 0 ||
+        Multicast::HEADER_SIZE + size > m_maxDatagramSize)
+    {
+        return false;
+    }
+
+    if (m_datagram.size() + size > m_maxDatagramSize)
+    {
+        _send();
+    }
+
+    m_datagram.insert(m_datagram.end(), data, data + size);
+    m_ids.push_back(id);
+
+    return true;
+}
+
+void MulticastSender::flush()
+{
+    if (!m_ids.empty())
+    {
+        _send();
+    }
+    else if (m_fd >= 0 &&
+             m_heartbeatInterval > std::chrono::steady_clock::duration::zero() &&
+             std::chrono::steady_clock::now() - m_lastSend >= m_heartbeatInterval)
+    {
+        _heartbeat();
+    }
+}
+
+void MulticastSender::takeResync(std::vector<int16_t>& ids, bool& all)
+{
+    if (m_fd < 0)
+    {
+        return;
+    }
+
+    char nack[Multicast::NACK_SIZE];
+
+    while (true)
+    {
+        ssize_t n = ::recv(m_fd, nack, sizeof(nack), 0);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // EAGAIN: no more reports
+            return;
+        }
+
+        uint32_t session;
+        uint32_t first;
+        uint32_t count;
+        if (!Multicast::readNack(nack, static_cast<size_t>(n), session, first, count) ||
+            session != m_session)
+        {
+            continue;
+        }
+
+        m_resyncRequests++;
+
+        if (count > HISTORY_SIZE)
+        {
+            all = true;
+            continue;
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            uint32_t sequence = first + i;
+            const HistoryEntry& entry = m_history[sequence % HISTORY_SIZE];
+
+            if (!entry.valid ||
+                entry.sequence != sequence)
+            {
+                // too old or never sent
+                all = true;
+                break;
+            }
+
+            ids.insert(ids.end(), entry.ids.begin(), entry.ids.end());
+        }
+    }
+}
+
+void MulticastSender::_send()
+{
+    Multicast::writeHeader(m_datagram.data(), m_session, m_sequence);
+
+    ssize_t n = ::sendto(m_fd, m_datagram.data(), m_datagram.size(), 0,
+                         reinterpret_cast<const sockaddr*>(&m_group), sizeof(m_group));
+
+    // a datagram lost here is reported by the receivers like any other loss
+    if (n >= 0)
+    {
+        m_datagramsSent++;
+    }
+
+    HistoryEntry& entry = m_history[m_sequence % HISTORY_SIZE];
+    entry.sequence = m_sequence;
+    entry.valid = true;
+    entry.ids.swap(m_ids);
+    m_ids.clear();
+
+    m_sequence++;
+    m_datagram.resize(Multicast::HEADER_SIZE);
+    m_lastSend = std::chrono::steady_clock::now();
+}
+
+void MulticastSender::_heartbeat()
+{
+    char heartbeat[Multicast::HEARTBEAT_SIZE];
+    Multicast::writeHeartbeat(heartbeat, m_session, m_sequence);
+
+    ssize_t n = ::sendto(m_fd, heartbeat, sizeof(heartbeat), 0,
+                         reinterpret_cast<const sockaddr*>(&m_group), sizeof(m_group));
+
+    if (n >= 0)
+    {
+        m_heartbeatsSent++;
+    }
+
+    m_lastSend = std::chrono::steady_clock::now();
+}
+
+
+//------------------------------------------------------------------
+// MulticastReceiver
+MulticastReceiver::MulticastReceiver()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+MulticastReceiver::MulticastReceiver(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+MulticastReceiver::~MulticastReceiver()
+{
+    close();
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+}
+
+bool MulticastReceiver::open(const std::string& group, int port, const std::string& interfaceAddress)
+{
+    close();
+
+    in_addr group_addr;
+    in_addr interface_addr;
+    if (!parseAddress(group, group_addr) ||
+        !IN_MULTICAST(ntohl(group_addr.s_addr)))
+    {
+        std::cerr << "MulticastReceiver: invalid group: " << group << "\n";
+        return false;
+    }
+
+    if (!parseAddress(interfaceAddress, interface_addr))
+    {
+        std::cerr << "MulticastReceiver: invalid interface address: " << interfaceAddress << "\n";
+        return false;
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        std::cerr << "MulticastReceiver: socket failed: " << errno << "\n";
+        return false;
+    }
+
+    // several receivers on one host
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    // only groups joined on this socket, not those of other sockets on the port
+    int all = 0;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_ALL, &all, sizeof(all));
+
+    // not bound to the group address, loss reports are sent from this socket
+    sockaddr_in local;
+    std::memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<uint16_t>(port));
+    local.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0)
+    {
+        std::cerr << "MulticastReceiver: could not bind to port " << port << ": " << errno << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    ip_mreq membership;
+    membership.imr_multiaddr = group_addr;
+    membership.imr_interface = interface_addr;
+
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+    {
+        std::cerr << "MulticastReceiver: could not join group " << group << ": " << errno << "\n";
+        ::close(fd);
+        return false;
+    }
+
+    if (m_buffer.size() < MAX_DATAGRAM_SIZE)
+    {
+        m_buffer.resize(MAX_DATAGRAM_SIZE);
+    }
+
+    m_fd = fd;
+    m_loop.add(fd, EPOLLIN, [this](uint32_t) { _read(); });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+
+    return true;
+}
+
+void MulticastReceiver::close()
+{
+    if (m_fd < 0)
+    {
+        return;
+    }
+
+    // close on the loop thread, the read handler is not running concurrently
+    m_loop.invoke([this]() {
+        m_loop.remove(m_fd);
+        ::close(m_fd);
+        m_fd = -1;
+    });
+}
+
+void MulticastReceiver::_read()
+{
+    while (m_fd >= 0)
+    {
+        sockaddr_in sender;
+        socklen_t sender_size = sizeof(sender);
+
+        ssize_t n = ::recvfrom(m_fd, m_buffer.data(), m_buffer.size(), 0,
+                               reinterpret_cast<sockaddr*>(&sender), &sender_size);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            // EAGAIN
+            return;
+        }
+
+        uint32_t session;
+        uint32_t sequence;
+        if (Multicast::readHeartbeat(m_buffer.data(), static_cast<size_t>(n), session, sequence))
+        {
+            _heartbeat(sender, session, sequence);
+            continue;
+        }
+
+        if (!Multicast::readHeader(m_buffer.data(), static_cast<size_t>(n), session, sequence))
+        {
+            continue;
+        }
+
+        if (!m_synced ||
+            session != m_session)
+        {
+            // first datagram of a sender
+            m_synced = true;
+            m_session = session;
+            m_expected = sequence;
+        }
+
+        int32_t distance = static_cast<int32_t>(sequence - m_expected);
+
+        if (distance < 0)
+        {
+            // reordered or duplicated, the value might be outdated
+            m_late++;
+            continue;
+        }
+
+        if (distance > 0)
+        {
+            m_lost += static_cast<uint64_t>(distance);
+            _nack(sender, m_expected, static_cast<uint32_t>(distance));
+        }
+
+        m_expected = sequence + 1;
+        m_received++;
+
+        if (m_listener &&
+            static_cast<size_t>(n) > Multicast::HEADER_SIZE)
+        {
+            m_listener->received(m_buffer.data() + Multicast::HEADER_SIZE,
+                                 static_cast<size_t>(n) - Multicast::HEADER_SIZE);
+        }
+    }
+}
+
+void MulticastReceiver::_heartbeat(const sockaddr_in& sender, uint32_t session, uint32_t sequence)
+{
+    m_heartbeats++;
+
+    if (!m_synced ||
+        session != m_session)
+    {
+        // nothing missed of a sender not heard before
+        m_synced = true;
+        m_session = session;
+        m_expected = sequence;
+        return;
+    }
+
+    int32_t distance = static_cast<int32_t>(sequence - m_expected);
+
+    if (distance > 0)
+    {
+        // the last datagrams before the sender went idle are lost
+        m_lost += static_cast<uint64_t>(distance);
+        _nack(sender, m_expected, static_cast<uint32_t>(distance));
+        m_expected = sequence;
+    }
+}
+
+void MulticastReceiver::_nack(const sockaddr_in& sender, uint32_t first, uint32_t count)
+{
+    char nack[Multicast::NACK_SIZE];
+    Multicast::writeNack(nack, m_session, first, count);
+
+    // best effort, a lost report leaves the values until their next change
+    ::sendto(m_fd, nack, sizeof(nack), 0,
+             reinterpret_cast<const sockaddr*>(&sender), sizeof(sender));
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,306 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_MULTICAST_H
+#define RCP_MULTICAST_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "valuechannel.h"
+
+#ifdef __linux__
+#include <netinet/in.h>
+
+#include "clienttransporter.h"
+#include "eventloop.h"
+#endif
+
+namespace rcp {
+
+/*
+* Multicast - datagram formats of the multicast value channel
+*
+* value datagram, sender to group:
+*   "RCPV" | session (u32) | sequence (u32) | rcp packets back to back
+*
+* loss report, receiver to sender address:
+*   "RCPN" | session (u32) | first lost sequence (u32) | count (u32)
+*
+* heartbeat, sender to group while idle:
+*   "RCPH" | session (u32) | sequence of the next datagram (u32)
+*   lets receivers detect the loss of the last datagrams.
+*
+* numbers are big endian. the session is random per sender,
+* a new session restarts sequence tracking.
+*/
+class Multicast
+{
+public:
+    static const size_t HEADER_SIZE = 12;
+    static const size_t NACK_SIZE = 16;
+    static const size_t HEARTBEAT_SIZE = 12;
+
+    static void writeHeader(char* out, uint32_t session, uint32_t sequence)
+    {
+        out[0] = 'R';
+        out[1] = 'C';
+        out[2] = 'P';
+        out[3] = 'V';
+        writeU32(out + 4, session);
+        writeU32(out + 8, sequence);
+    }
+
+    static bool readHeader(const char* data, size_t size, uint32_t& session, uint32_t& sequence)
+    {
+        if (size < HEADER_SIZE ||
+            data[0] != 'R' || data[1] != 'C' || data[2] != 'P' || data[3] != 'V')
+        {
+            return false;
+        }
+
+        session = readU32(data + 4);
+        sequence = readU32(data + 8);
+        return true;
+    }
+
+    static void writeHeartbeat(char* out, uint32_t session, uint32_t sequence)
+    {
+        out[0] = 'R';
+        out[1] = 'C';
+        out[2] = 'P';
+        out[3] = 'H';
+        writeU32(out + 4, session);
+        writeU32(out + 8, sequence);
+    }
+
+    static bool readHeartbeat(const char* data, size_t size, uint32_t& session, uint32_t& sequence)
+    {
+        if (size < HEARTBEAT_SIZE ||
+            data[0] != 'R' || data[1] != 'C' || data[2] != 'P' || data[3] != 'H')
+        {
+            return false;
+        }
+
+        session = readU32(data + 4);
+        sequence = readU32(data + 8);
+        return true;
+    }
+
+    static void writeNack(char* out, uint32_t session, uint32_t first, uint32_t count)
+    {
+        out[0] = 'R';
+        out[1] = 'C';
+        out[2] = 'P';
+        out[3] = 'N';
+        writeU32(out + 4, session);
+        writeU32(out + 8, first);
+        writeU32(out + 12, count);
+    }
+
+    static bool readNack(const char* data, size_t size, uint32_t& session, uint32_t& first, uint32_t& count)
+    {
+        if (size < NACK_SIZE ||
+            data[0] != 'R' || data[1] != 'C' || data[2] != 'P' || data[3] != 'N')
+        {
+            return false;
+        }
+
+        session = readU32(data + 4);
+        first = readU32(data + 8);
+        count = readU32(data + 12);
+        return true;
+    }
+
+private:
+    static void writeU32(char* out, uint32_t value)
+    {
+        out[0] = static_cast<char>((value >> 24) & 0xFF);
+        out[1] = static_cast<char>((value >> 16) & 0xFF);
+        out[2] = static_cast<char>((value >> 8) & 0xFF);
+        out[3] = static_cast<char>(value & 0xFF);
+    }
+
+    static uint32_t readU32(const char* in)
+    {
+        const unsigned char* u = reinterpret_cast<const unsigned char*>(in);
+        return (uint32_t(u[0]) << 24) | (uint32_t(u[1]) << 16) | (uint32_t(u[2]) << 8) | uint32_t(u[3]);
+    }
+};
+
+
+#ifdef __linux__
+
+/*
+* MulticastSender - value channel on ip multicast
+*
+* UPDATEVALUE packets of one update() are packed into datagrams of max
+* datagram size and sent once to the group. packets that do not fit
+* a datagram go to the transporters.
+* the parameter ids of the last HISTORY_SIZE datagrams are kept to answer
+* loss reports, which arrive on the sending socket.
+* an update() without values sends a heartbeat if nothing was sent for
+* the heartbeat interval, so a lost last datagram is reported as well.
+*
+* used from ParameterServer::update(), not thread safe on its own.
+*/
+class MulticastSender : public ValueChannel
+{
+public:
+    // stays below common ethernet mtu, no ip fragmentation
+    static const size_t DEFAULT_MAX_DATAGRAM_SIZE = 1400;
+    static const size_t HISTORY_SIZE = 256;
+    static const uint32_t DEFAULT_HEARTBEAT_MS = 100;
+
+public:
+    MulticastSender();
+    ~MulticastSender();
+
+    MulticastSender(const MulticastSender&) = delete;
+    MulticastSender& operator=(const MulticastSender&) = delete;
+
+    // interfaceAddress: local address of the sending interface, empty for default route
+    bool open(const std::string& group, int port, const std::string& interfaceAddress = "", int ttl = 1);
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    // including header, call before open()
+    void setMaxDatagramSize(size_t size) { m_maxDatagramSize = size; }
+    size_t getMaxDatagramSize() const { return m_maxDatagramSize; }
+
+    // 0: no heartbeats
+    void setHeartbeatInterval(uint32_t ms) { m_heartbeatInterval = std::chrono::milliseconds(ms); }
+
+    uint32_t getSession() const { return m_session; }
+    // sequence of the next datagram
+    uint32_t getSequence() const { return m_sequence; }
+
+    size_t datagramsSent() const { return m_datagramsSent; }
+    size_t resyncRequests() const { return m_resyncRequests; }
+    size_t heartbeatsSent() const { return m_heartbeatsSent; }
+
+public:
+    // ValueChannel
+    bool add(int16_t id, const char* data, size_t size) override;
+    void flush() override;
+    void takeResync(std::vector<int16_t>& ids, bool& all) override;
+
+private:
+    struct HistoryEntry
+    {
+        uint32_t sequence{0};
+        bool valid{false};
+        std::vector<int16_t> ids;
+    };
+
+    void _send();
+    void _heartbeat();
+
+    int m_fd{-1};
+    sockaddr_in m_group;
+    size_t m_maxDatagramSize{DEFAULT_MAX_DATAGRAM_SIZE};
+
+    uint32_t m_session{0};
+    uint32_t m_sequence{0};
+
+    // datagram in progress, header is written on send
+    std::vector<char> m_datagram;
+    std::vector<int16_t> m_ids;
+    std::vector<HistoryEntry> m_history;
+
+    std::chrono::steady_clock::duration m_heartbeatInterval{std::chrono::milliseconds(DEFAULT_HEARTBEAT_MS)};
+    std::chrono::steady_clock::time_point m_lastSend;
+
+    size_t m_datagramsSent{0};
+    size_t m_resyncRequests{0};
+    size_t m_heartbeatsSent{0};
+};
+
+
+/*
+* MulticastReceiver - receives a multicast value channel
+*
+* datagrams are passed to the listener without header, usually
+* a ParameterClient. to keep the client single threaded, share the loop
+* of its transporter:
+*
+*   MulticastReceiver receiver(transporter.loop());
+*   receiver.setListener(&client);
+*
+* a gap in the sequence, seen in a datagram or a heartbeat, is reported
+* to the sender, late datagrams are dropped. sequence state survives close() and open() as long as the
+* sender session does not change, so values missed while closed are
+* requested as well.
+*/
+class MulticastReceiver
+{
+public:
+    MulticastReceiver();
+    MulticastReceiver(EventLoop& loop);
+    ~MulticastReceiver();
+
+    MulticastReceiver(const MulticastReceiver&) = delete;
+    MulticastReceiver& operator=(const MulticastReceiver&) = delete;
+
+    // interfaceAddress: local address of the receiving interface, empty for any
+    bool open(const std::string& group, int port, const std::string& interfaceAddress = "");
+    void close();
+    bool isOpen() const { return m_fd >= 0; }
+
+    // call before open()
+    void setListener(ClientTransporterListener* listener) { m_listener = listener; }
+
+    uint64_t receivedCount() const { return m_received; }
+    uint64_t lostCount() const { return m_lost; }
+    uint64_t lateCount() const { return m_late; }
+    uint64_t heartbeatCount() const { return m_heartbeats; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _read();
+    void _nack(const sockaddr_in& sender, uint32_t first, uint32_t count);
+    void _heartbeat(const sockaddr_in& sender, uint32_t session, uint32_t sequence);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    int m_fd{-1};
+    ClientTransporterListener* m_listener{nullptr};
+    std::vector<char> m_buffer;
+
+    // loop thread
+    bool m_synced{false};
+    uint32_t m_session{0};
+    uint32_t m_expected{0};
+
+    std::atomic<uint64_t> m_received{0};
+    std::atomic<uint64_t> m_lost{0};
+    std::atomic<uint64_t> m_late{0};
+    std::atomic<uint64_t> m_heartbeats{0};
+};
+
+#endif // __linux__
+
+}
+
+#endif // RCP_MULTICAST_H
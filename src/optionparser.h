@@ -18,14 +18,20 @@
 #ifndef RCP_OPTIONPARSER_H
 #define RCP_OPTIONPARSER_H
 
-#include <istream>
+#include "bytereader.h"
 
 namespace rcp {
 
 class IOptionparser
 {
 public:
-    virtual void parseOptions(std::istream& is) = 0;
+    virtual void parseOptions(ByteReader& is) = 0;
+
+    // implementers add "using IOptionparser::parseOptions;" to keep this visible
+    void parseOptions(std::istream& is) {
+        ByteReader reader(is);
+        parseOptions(reader);
+    }
 };
 
 }
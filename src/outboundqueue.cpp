@@ -0,0 +1,149 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#include "outboundqueue.h"
+
+#include <cstring>
+
+namespace rcp {
+
+bool OutboundQueue::push(const char* header, size_t headerSize, const SharedBuffer& body)
+{
+    if (headerSize > MAX_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    m_messages.emplace_back();
+    Message& message = m_messages.back();
+    message.buffer = body;
+    message.headerSize = headerSize;
+    if (headerSize > 0)
+    {
+        std::memcpy(message.header, header, headerSize);
+    }
+
+    m_bytes += message.size();
+
+    if (m_budget > 0 &&
+        m_bytes > m_budget)
+    {
+        _collapse();
+
+        // the newest message always survives collapsing,
+        // a single message bigger than the budget is accepted
+        if (m_bytes - m_messages.back().size() > m_budget)
+        {
+            m_bytes -= m_messages.back().size();
+            m_messages.pop_back();
+            m_overflows++;
+            return false;
+        }
+    }
+
+    if (m_bytes > m_peakBytes)
+    {
+        m_peakBytes = m_bytes;
+    }
+
+    return true;
+}
+
+void OutboundQueue::consume(size_t bytes)
+{
+    m_bytes -= bytes;
+
+    while (bytes > 0)
+    {
+        size_t left = m_messages.front().size() - m_offset;
+
+        if (bytes >= left)
+        {
+            bytes -= left;
+            m_messages.pop_front();
+            m_offset = 0;
+        }
+        else
+        {
+            m_offset += bytes;
+            bytes = 0;
+        }
+    }
+}
+
+void OutboundQueue::clear()
+{
+    m_messages.clear();
+    m_offset = 0;
+    m_bytes = 0;
+}
+
+OutboundQueue::Stats OutboundQueue::stats() const
+{
+    Stats stats;
+    stats.bytes = m_bytes;
+    stats.messages = m_messages.size();
+    stats.peakBytes = m_peakBytes;
+    stats.collapsed = m_collapsed;
+    stats.overflows = m_overflows;
+    return stats;
+}
+
+void OutboundQueue::_collapse()
+{
+    if (m_messages.size() < 2)
+    {
+        return;
+    }
+
+    // walk from the back, keep the newest message per key
+    // and move kept messages towards the back
+    m_keys.clear();
+
+    size_t write = m_messages.size();
+    size_t read = m_messages.size();
+
+    // a partly written front message stays
+    size_t first = m_offset > 0 ? 1 : 0;
+
+    while (read > first)
+    {
+        read--;
+        Message& message = m_messages[read];
+        int32_t key = message.buffer.key();
+
+        if (key != SharedBuffer::NO_KEY &&
+            !m_keys.insert(key).second)
+        {
+            // outdated by a newer message
+            m_bytes -= message.size();
+            m_collapsed++;
+            continue;
+        }
+
+        write--;
+        if (write != read)
+        {
+            m_messages[write] = std::move(message);
+        }
+    }
+
+    // remove the gap between the front message and the kept messages
+    m_messages.erase(m_messages.begin() + first, m_messages.begin() + write);
+}
+
+}
@@ -0,0 +1,141 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_OUTBOUNDQUEUE_H
+#define RCP_OUTBOUNDQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+
+#include "sharedbuffer.h"
+
+namespace rcp {
+
+/*
+* OutboundQueue - messages waiting to be written to one connection
+*
+* every message is a small header (e.g. a length prefix) and a SharedBuffer.
+* with a byte budget the queue is collapsed when it grows over the
+* budget: of messages with the same key (SharedBuffer::key()) only the
+* newest is kept, so queued value updates shrink to the last value
+* per parameter. messages without key are never dropped.
+* if the messages queued before the new one still exceed the budget
+* after that, push() fails and the connection is considered too slow.
+*
+* the first message may be partly written, it is never dropped.
+*
+* not thread safe, owned by the connection.
+*/
+class OutboundQueue
+{
+public:
+    static const size_t MAX_HEADER_SIZE = 16;
+
+    struct Stats
+    {
+        size_t bytes{0};
+        size_t messages{0};
+        // highest number of queued bytes
+        size_t peakBytes{0};
+        // messages dropped in favour of newer ones
+        size_t collapsed{0};
+        // pushes over budget after collapsing
+        size_t overflows{0};
+    };
+
+public:
+    // budget in bytes, 0: unlimited
+    void setBudget(size_t budget) { m_budget = budget; }
+    size_t getBudget() const { return m_budget; }
+
+    // returns false if the message does not fit the budget,
+    // it is not queued then
+    bool push(const char* header, size_t headerSize, const SharedBuffer& body);
+
+    // drop bytes written from the front
+    void consume(size_t bytes);
+
+    void clear();
+
+    bool empty() const { return m_messages.empty(); }
+    size_t messages() const { return m_messages.size(); }
+    size_t bytes() const { return m_bytes; }
+    Stats stats() const;
+
+    // calls f(const char* data, size_t size) for unwritten parts
+    // from the front until f returns false
+    template<typename F>
+    void forEachSegment(F f) const
+    {
+        size_t offset = m_offset;
+
+        for (const Message& message : m_messages)
+        {
+            if (offset < message.headerSize)
+            {
+                if (!f(message.header + offset, message.headerSize - offset))
+                {
+                    return;
+                }
+                offset = 0;
+            }
+            else
+            {
+                offset -= message.headerSize;
+            }
+
+            if (message.buffer.size() > offset &&
+                !f(message.buffer.data() + offset, message.buffer.size() - offset))
+            {
+                return;
+            }
+
+            offset = 0;
+        }
+    }
+
+private:
+    struct Message
+    {
+        SharedBuffer buffer;
+        char header[MAX_HEADER_SIZE];
+        size_t headerSize;
+
+        size_t size() const { return headerSize + buffer.size(); }
+    };
+
+    void _collapse();
+
+    std::deque<Message> m_messages;
+    // bytes of the front message already written
+    size_t m_offset{0};
+    size_t m_bytes{0};
+    size_t m_budget{0};
+
+    size_t m_peakBytes{0};
+    size_t m_collapsed{0};
+    size_t m_overflows{0};
+
+    // _collapse()
+    std::unordered_set<int32_t> m_keys;
+};
+
+}
+
+#endif // RCP_OUTBOUNDQUEUE_H
@@ -21,9 +21,24 @@
 
 namespace rcp {
 
+Option<Packet>
+Packet::parse(const char* data, size_t size, std::shared_ptr<IParameterManager> manager)
+{
+    ByteReader reader(data, size);
+    return parse(reader, manager);
+}
 
 Option<Packet>
 Packet::parse(std::istream& is, std::shared_ptr<IParameterManager> manager)
+{
+    // reads the bytes of the packet from the stream, nothing after it
+    ByteReader reader(is);
+    return parse(reader, manager);
+}
+
+
+Option<Packet>
+Packet::parse(ByteReader& is, std::shared_ptr<IParameterManager> manager)
 {
     // read command
     command_t command = static_cast<command_t>(is.get());
@@ -146,10 +161,17 @@ Packet::parse(std::istream& is, std::shared_ptr<IParameterManager> manager)
             }
 
             case COMMAND_DISCOVER:
-                // TODO
-                // exect ID-data or null
-                // parameter-id followed by terminator
+            {
+                // group id
+                IdDataPtr id_data = IdData::parse(is);
+
+                if (id_data != nullptr)
+                {
+                    packet_option.value().setData(id_data);
+                }
+
                 break;
+            }
 
             case COMMAND_UPDATE:
             {
@@ -177,6 +199,23 @@ Packet::parse(std::istream& is, std::shared_ptr<IParameterManager> manager)
                 break;
             }
 
+            case COMMAND_SUBSCRIBE:
+            {
+                // we expect SubscriptionData
+                SubscriptionDataPtr subscription = SubscriptionData::parse(is);
+
+                if (subscription != nullptr)
+                {
+                    packet_option.value().setData(subscription);
+                }
+                else
+                {
+                    return Option<Packet>();
+                }
+
+                break;
+            }
+
             case COMMAND_UPDATEVALUE:
                 // handled above
                 break;
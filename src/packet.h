@@ -24,6 +24,7 @@
 #include "parameter_parser.h"
 #include "infodata.h"
 #include "iddata.h"
+#include "subscriptiondata.h"
 
 namespace rcp {
 
@@ -32,6 +33,11 @@ class Packet
 {
 
 public:
+    static Option<Packet> parse(ByteReader& is, std::shared_ptr<IParameterManager> manager = nullptr);
+    static Option<Packet> parse(const char* data, size_t size, std::shared_ptr<IParameterManager> manager = nullptr);
+
+    // stream wrapper
+    // reads exactly the bytes of the packet, also from non-seekable streams
     static Option<Packet> parse(std::istream& is, std::shared_ptr<IParameterManager> manager = nullptr);
 
 public:
@@ -0,0 +1,707 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#include "packetscanner.h"
+
+#include <algorithm>
+
+namespace rcp {
+
+PacketScanner::PacketScanner()
+{
+}
+
+void PacketScanner::reset()
+{
+    m_state = STATE_COMMAND;
+    m_command = 0;
+    m_packetSize = 0;
+    m_complete = false;
+    m_error = false;
+    m_hasData = false;
+    m_remaining = 0;
+    m_fieldNumber = false;
+    m_fieldValue = 0;
+    m_type = 0;
+    m_elementType = 0;
+    m_customSize = 0;
+    m_pending.clear();
+}
+
+size_t PacketScanner::scan(const char* data, size_t size)
+{
+    size_t pos = 0;
+
+    while (pos < size &&
+           !m_complete &&
+           !m_error)
+    {
+        if (m_remaining > 0)
+        {
+            if (m_fieldNumber)
+            {
+                m_fieldValue = (m_fieldValue << 8) | static_cast<uint8_t>(data[pos]);
+                pos++;
+                m_remaining--;
+            }
+            else
+            {
+                // skip what is there of a string or value
+                size_t n = std::min(static_cast<size_t>(m_remaining), size - pos);
+                pos += n;
+                m_remaining -= static_cast<uint32_t>(n);
+            }
+
+            if (m_remaining == 0)
+            {
+                _fieldDone();
+            }
+
+            continue;
+        }
+
+        _byte(static_cast<uint8_t>(data[pos]));
+        pos++;
+    }
+
+    m_packetSize += pos;
+
+    return pos;
+}
+
+bool PacketScanner::feed(const char* data, size_t size, const PacketCallback& callback)
+{
+    if (m_error)
+    {
+        return false;
+    }
+
+    size_t pos = 0;
+
+    if (!m_pending.empty())
+    {
+        // continue the packet of the last chunk
+        pos = scan(data, size);
+        m_pending.insert(m_pending.end(), data, data + pos);
+
+        if (m_error ||
+            _tooBig())
+        {
+            return false;
+        }
+
+        if (!m_complete)
+        {
+            return true;
+        }
+
+        callback(m_pending.data(), m_pending.size());
+        reset();
+    }
+
+    while (pos < size)
+    {
+        size_t used = scan(data + pos, size - pos);
+
+        if (m_error ||
+            _tooBig())
+        {
+            return false;
+        }
+
+        if (!m_complete)
+        {
+            // continues in the next chunk
+            m_pending.assign(data + pos, data + pos + used);
+            return true;
+        }
+
+        callback(data + pos, used);
+        pos += used;
+        reset();
+    }
+
+    return true;
+}
+
+size_t PacketScanner::findPacket(const char* data, size_t size)
+{
+    PacketScanner scanner;
+    size_t used = scanner.scan(data, size);
+
+    return scanner.isComplete() ? used : 0;
+}
+
+bool PacketScanner::_tooBig()
+{
+    if (m_maxPacketSize > 0 &&
+        m_packetSize > m_maxPacketSize)
+    {
+        m_error = true;
+        return true;
+    }
+
+    return false;
+}
+
+void PacketScanner::_fail()
+{
+    m_error = true;
+}
+
+void PacketScanner::_field(uint32_t size, bool number, state_t next)
+{
+    m_remaining = size;
+    m_fieldNumber = number;
+    m_fieldValue = 0;
+    m_state = next;
+
+    if (size == 0)
+    {
+        _fieldDone();
+    }
+}
+
+void PacketScanner::_string(uint32_t sizeBytes, state_t next)
+{
+    m_stringNext = next;
+    _field(sizeBytes, true, STATE_STRING_SIZE);
+}
+
+void PacketScanner::_fieldDone()
+{
+    switch (m_state)
+    {
+    case STATE_STRING_SIZE:
+        _field(m_fieldValue, false, m_stringNext);
+        break;
+
+    case STATE_CUSTOM_SIZE:
+        m_customSize = m_fieldValue;
+        m_state = STATE_TYPE_OPTION;
+        break;
+
+    case STATE_ENUM_ENTRY_SIZE:
+        if (m_fieldValue == 0)
+        {
+            // empty entry ends the list
+            m_state = STATE_TYPE_OPTION;
+        }
+        else
+        {
+            _field(m_fieldValue, false, STATE_ENUM_ENTRY);
+        }
+        break;
+
+    case STATE_ENUM_ENTRY:
+        _field(1, true, STATE_ENUM_ENTRY_SIZE);
+        break;
+
+    case STATE_LANGUAGE_CODE:
+        _string(m_languageSizeBytes, STATE_LANGUAGE);
+        break;
+
+    case STATE_VALUE_CUSTOM_SIZE:
+        m_customSize = m_fieldValue;
+        _field(m_customSize, false, STATE_DONE);
+        break;
+
+    case STATE_DONE:
+        // update value has no terminator
+        m_complete = true;
+        break;
+
+    default:
+        // continue with the next byte
+        break;
+    }
+}
+
+void PacketScanner::_byte(uint8_t b)
+{
+    switch (m_state)
+    {
+    case STATE_COMMAND:
+        m_command = b;
+
+        if (b == COMMAND_UPDATEVALUE)
+        {
+            // id, type, value
+            _field(2, false, STATE_VALUE_TYPE);
+        }
+        else if (b > COMMAND_INVALID &&
+                 b < COMMAND_MAX_)
+        {
+            m_state = STATE_PACKET_OPTION;
+        }
+        else
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_PACKET_OPTION:
+        if (b == TERMINATOR)
+        {
+            m_complete = true;
+        }
+        else if (b == PACKET_OPTIONS_TIMESTAMP)
+        {
+            _field(8, false, STATE_PACKET_OPTION);
+        }
+        else if (b == PACKET_OPTIONS_DATA &&
+                 !m_hasData)
+        {
+            m_hasData = true;
+
+            switch (m_command)
+            {
+            case COMMAND_INFO:
+                // version
+                _string(1, STATE_INFO_OPTION);
+                break;
+
+            case COMMAND_INITIALIZE:
+            case COMMAND_DISCOVER:
+            case COMMAND_REMOVE:
+                // id
+                _field(2, false, STATE_PACKET_OPTION);
+                break;
+
+            case COMMAND_SUBSCRIBE:
+                m_state = STATE_SUBSCRIPTION_OPTION;
+                break;
+
+            case COMMAND_UPDATE:
+                // id, then type
+                _field(2, false, STATE_PARAMETER_TYPE);
+                break;
+
+            default:
+                _fail();
+                break;
+            }
+        }
+        else
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_INFO_OPTION:
+        if (b == TERMINATOR)
+        {
+            m_state = STATE_PACKET_OPTION;
+        }
+        else if (b == INFODATA_OPTIONS_APPLICATIONID)
+        {
+            _string(1, STATE_INFO_OPTION);
+        }
+        else
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_SUBSCRIPTION_OPTION:
+        if (b == TERMINATOR)
+        {
+            m_state = STATE_PACKET_OPTION;
+        }
+        else if (b == SUBSCRIPTION_OPTIONS_GROUP)
+        {
+            // id
+            _field(2, false, STATE_SUBSCRIPTION_OPTION);
+        }
+        else if (b == SUBSCRIPTION_OPTIONS_TAG)
+        {
+            _string(1, STATE_SUBSCRIPTION_OPTION);
+        }
+        else
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_PARAMETER_TYPE:
+        if (!_setType(b))
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_RANGE_ELEMENT:
+        if (!_isNumber(b))
+        {
+            _fail();
+            break;
+        }
+
+        m_elementType = b;
+        m_state = STATE_TYPE_OPTION;
+        break;
+
+    case STATE_TYPE_OPTION:
+        if (b == TERMINATOR)
+        {
+            // a range continues with its own options after the element options
+            m_state = m_type == DATATYPE_RANGE ? STATE_RANGE_OPTION : STATE_PARAMETER_OPTION;
+        }
+        else if (!_typeOption(b))
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_RANGE_OPTION:
+        if (b == TERMINATOR)
+        {
+            m_state = STATE_PARAMETER_OPTION;
+        }
+        else if (b == RANGE_OPTIONS_DEFAULT)
+        {
+            _field(2 * _fixedSize(m_elementType), false, STATE_RANGE_OPTION);
+        }
+        else
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_PARAMETER_OPTION:
+        if (b == TERMINATOR)
+        {
+            m_state = STATE_PACKET_OPTION;
+        }
+        else if (!_parameterOption(b))
+        {
+            _fail();
+        }
+        break;
+
+    case STATE_LANGUAGE:
+        if (b == TERMINATOR)
+        {
+            m_state = STATE_PARAMETER_OPTION;
+        }
+        else
+        {
+            // first byte of the language code
+            _field(2, false, STATE_LANGUAGE_CODE);
+        }
+        break;
+
+    case STATE_VALUE_TYPE:
+        m_type = b;
+
+        if (b == DATATYPE_RANGE)
+        {
+            m_state = STATE_VALUE_RANGE_ELEMENT;
+        }
+        else if (b == DATATYPE_CUSTOMTYPE)
+        {
+            _field(4, true, STATE_VALUE_CUSTOM_SIZE);
+        }
+        else
+        {
+            _value(STATE_DONE);
+        }
+        break;
+
+    case STATE_VALUE_RANGE_ELEMENT:
+        if (!_isNumber(b))
+        {
+            _fail();
+            break;
+        }
+
+        m_elementType = b;
+        _value(STATE_DONE);
+        break;
+
+    default:
+        _fail();
+        break;
+    }
+}
+
+bool PacketScanner::_setType(uint8_t type)
+{
+    m_type = type;
+
+    switch (type)
+    {
+    case DATATYPE_RANGE:
+        m_state = STATE_RANGE_ELEMENT;
+        return true;
+
+    case DATATYPE_CUSTOMTYPE:
+        _field(4, true, STATE_CUSTOM_SIZE);
+        return true;
+
+    case DATATYPE_STRING:
+    case DATATYPE_ENUM:
+    case DATATYPE_URI:
+    case DATATYPE_BANG:
+    case DATATYPE_GROUP:
+        m_state = STATE_TYPE_OPTION;
+        return true;
+
+    default:
+        break;
+    }
+
+    if (_fixedSize(type) > 0)
+    {
+        m_state = STATE_TYPE_OPTION;
+        return true;
+    }
+
+    // array, list, image
+    return false;
+}
+
+bool PacketScanner::_typeOption(uint8_t option)
+{
+    switch (m_type)
+    {
+    case DATATYPE_BOOLEAN:
+    case DATATYPE_RGB:
+    case DATATYPE_RGBA:
+    case DATATYPE_IPV4:
+    case DATATYPE_IPV6:
+        if (option == OPTIONS_DEFAULT)
+        {
+            _field(_fixedSize(m_type), false, STATE_TYPE_OPTION);
+            return true;
+        }
+        return false;
+
+    case DATATYPE_STRING:
+        if (option == STRING_OPTIONS_DEFAULT ||
+            option == STRING_OPTIONS_REGULAR_EXPRESSION)
+        {
+            _string(4, STATE_TYPE_OPTION);
+            return true;
+        }
+        return false;
+
+    case DATATYPE_ENUM:
+        switch (option)
+        {
+        case ENUM_OPTIONS_DEFAULT:
+            _string(1, STATE_TYPE_OPTION);
+            return true;
+        case ENUM_OPTIONS_ENTRIES:
+            _field(1, true, STATE_ENUM_ENTRY_SIZE);
+            return true;
+        case ENUM_OPTIONS_MULTISELECT:
+            _field(1, false, STATE_TYPE_OPTION);
+            return true;
+        }
+        return false;
+
+    case DATATYPE_URI:
+        switch (option)
+        {
+        case URI_OPTIONS_DEFAULT:
+            _string(4, STATE_TYPE_OPTION);
+            return true;
+        case URI_OPTIONS_FILTER:
+        case URI_OPTIONS_SCHEMA:
+            _string(1, STATE_TYPE_OPTION);
+            return true;
+        }
+        return false;
+
+    case DATATYPE_CUSTOMTYPE:
+        switch (option)
+        {
+        case CUSTOMTYPE_OPTIONS_DEFAULT:
+            _field(m_customSize, false, STATE_TYPE_OPTION);
+            return true;
+        case CUSTOMTYPE_OPTIONS_UUID:
+            _field(16, false, STATE_TYPE_OPTION);
+            return true;
+        case CUSTOMTYPE_OPTIONS_CONFIG:
+            _string(4, STATE_TYPE_OPTION);
+            return true;
+        }
+        return false;
+
+    case DATATYPE_BANG:
+    case DATATYPE_GROUP:
+        // no options
+        return false;
+
+    default:
+        break;
+    }
+
+    // numbers and vectors, for a range the options of its element
+    uint32_t size = _fixedSize(m_type == DATATYPE_RANGE ? m_elementType : m_type);
+
+    switch (option)
+    {
+    case NUMBER_OPTIONS_DEFAULT:
+    case NUMBER_OPTIONS_MINIMUM:
+    case NUMBER_OPTIONS_MAXIMUM:
+    case NUMBER_OPTIONS_MULTIPLEOF:
+        _field(size, false, STATE_TYPE_OPTION);
+        return true;
+    case NUMBER_OPTIONS_SCALE:
+        _field(1, false, STATE_TYPE_OPTION);
+        return true;
+    case NUMBER_OPTIONS_UNIT:
+        _string(1, STATE_TYPE_OPTION);
+        return true;
+    }
+
+    return false;
+}
+
+bool PacketScanner::_parameterOption(uint8_t option)
+{
+    switch (option)
+    {
+    case PARAMETER_OPTIONS_VALUE:
+        if (m_type == DATATYPE_BANG ||
+            m_type == DATATYPE_GROUP)
+        {
+            return false;
+        }
+        _value(STATE_PARAMETER_OPTION);
+        return true;
+
+    case PARAMETER_OPTIONS_LABEL:
+        m_languageSizeBytes = 1;
+        m_state = STATE_LANGUAGE;
+        return true;
+
+    case PARAMETER_OPTIONS_DESCRIPTION:
+        m_languageSizeBytes = 2;
+        m_state = STATE_LANGUAGE;
+        return true;
+
+    case PARAMETER_OPTIONS_TAGS:
+    case PARAMETER_OPTIONS_USERID:
+        _string(1, STATE_PARAMETER_OPTION);
+        return true;
+
+    case PARAMETER_OPTIONS_ORDER:
+        _field(4, false, STATE_PARAMETER_OPTION);
+        return true;
+
+    case PARAMETER_OPTIONS_PARENTID:
+        _field(2, false, STATE_PARAMETER_OPTION);
+        return true;
+
+    case PARAMETER_OPTIONS_WIDGET:
+        // no data, like the parameter parser
+        return true;
+
+    case PARAMETER_OPTIONS_USERDATA:
+        _string(4, STATE_PARAMETER_OPTION);
+        return true;
+
+    case PARAMETER_OPTIONS_READONLY:
+        _field(1, false, STATE_PARAMETER_OPTION);
+        return true;
+    }
+
+    return false;
+}
+
+void PacketScanner::_value(state_t next)
+{
+    switch (m_type)
+    {
+    case DATATYPE_STRING:
+    case DATATYPE_URI:
+        _string(4, next);
+        return;
+
+    case DATATYPE_ENUM:
+        _string(1, next);
+        return;
+
+    case DATATYPE_RANGE:
+        _field(2 * _fixedSize(m_elementType), false, next);
+        return;
+
+    case DATATYPE_CUSTOMTYPE:
+        _field(m_customSize, false, next);
+        return;
+
+    default:
+        break;
+    }
+
+    uint32_t size = _fixedSize(m_type);
+    if (size == 0)
+    {
+        // bang, group or unsupported
+        _fail();
+        return;
+    }
+
+    _field(size, false, next);
+}
+
+uint32_t PacketScanner::_fixedSize(uint8_t type)
+{
+    switch (type)
+    {
+    case DATATYPE_BOOLEAN:
+    case DATATYPE_INT8:
+    case DATATYPE_UINT8:
+        return 1;
+    case DATATYPE_INT16:
+    case DATATYPE_UINT16:
+        return 2;
+    case DATATYPE_INT32:
+    case DATATYPE_UINT32:
+    case DATATYPE_FLOAT32:
+    case DATATYPE_RGB:
+    case DATATYPE_RGBA:
+    case DATATYPE_IPV4:
+        return 4;
+    case DATATYPE_INT64:
+    case DATATYPE_UINT64:
+    case DATATYPE_FLOAT64:
+    case DATATYPE_VECTOR2I32:
+    case DATATYPE_VECTOR2F32:
+        return 8;
+    case DATATYPE_VECTOR3I32:
+    case DATATYPE_VECTOR3F32:
+        return 12;
+    case DATATYPE_VECTOR4I32:
+    case DATATYPE_VECTOR4F32:
+    case DATATYPE_IPV6:
+        return 16;
+    }
+
+    return 0;
+}
+
+bool PacketScanner::_isNumber(uint8_t type)
+{
+    return type >= DATATYPE_INT8 &&
+           type <= DATATYPE_FLOAT64;
+}
+
+}
@@ -0,0 +1,159 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_PACKETSCANNER_H
+#define RCP_PACKETSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "types.h"
+
+namespace rcp {
+
+/*
+* PacketScanner - finds packet boundaries in a byte stream
+*
+* rcp packets carry no length, their end is only known by walking
+* the packet grammar. the scanner does this one byte at a time and keeps
+* its position in the grammar between calls, so a packet split over
+* any number of reads is scanned exactly once.
+* scan() only looks at lengths and datatypes and allocates nothing.
+*
+* low level, for data that stays in place (e.g. a socket read buffer):
+*
+*   size_t offset = scanner.packetSize();
+*   scanner.scan(data + offset, available - offset);
+*   if (scanner.isComplete()) { parse(data, scanner.packetSize()); scanner.reset(); }
+*
+* push interface, for chunks that do not outlive the call: feed()
+* passes complete packets to the callback straight from the chunk.
+* only the bytes of a packet continuing in the next chunk are kept.
+*
+* packets of types the parser does not support (array, list, image)
+* and unknown options are reported as error, the stream can not be
+* resynchronized after that.
+*/
+class PacketScanner
+{
+public:
+    typedef std::function<void(const char* data, size_t size)> PacketCallback;
+
+public:
+    PacketScanner();
+
+    // scan bytes of the current packet, stops after its last byte
+    // returns the number of bytes used
+    size_t scan(const char* data, size_t size);
+
+    bool isComplete() const { return m_complete; }
+    bool hasError() const { return m_error; }
+
+    // bytes of the current packet scanned so far
+    size_t packetSize() const { return m_packetSize; }
+
+    // start with the next packet
+    void reset();
+
+    // scan a chunk, callback is called for every complete packet
+    // returns false on malformed data
+    bool feed(const char* data, size_t size, const PacketCallback& callback);
+
+    // bytes of an incomplete packet kept by feed()
+    size_t pending() const { return m_pending.size(); }
+
+    // feed() fails on packets bigger than this, 0: no limit
+    void setMaxPacketSize(size_t size) { m_maxPacketSize = size; }
+
+    // size of the packet at data, 0 if it is incomplete or malformed
+    static size_t findPacket(const char* data, size_t size);
+
+private:
+    enum state_t {
+        STATE_COMMAND,
+        STATE_PACKET_OPTION,
+        STATE_INFO_OPTION,
+        STATE_SUBSCRIPTION_OPTION,
+        STATE_PARAMETER_TYPE,
+        STATE_RANGE_ELEMENT,
+        STATE_CUSTOM_SIZE,
+        STATE_TYPE_OPTION,
+        STATE_RANGE_OPTION,
+        STATE_ENUM_ENTRY_SIZE,
+        STATE_ENUM_ENTRY,
+        STATE_PARAMETER_OPTION,
+        STATE_LANGUAGE,
+        STATE_LANGUAGE_CODE,
+        STATE_STRING_SIZE,
+        STATE_VALUE_TYPE,
+        STATE_VALUE_RANGE_ELEMENT,
+        STATE_VALUE_CUSTOM_SIZE,
+        STATE_DONE
+    };
+
+    void _byte(uint8_t b);
+    void _fieldDone();
+
+    // read a field of size bytes, then continue in next
+    // number fields are collected big endian into m_fieldValue
+    void _field(uint32_t size, bool number, state_t next);
+    // length prefixed string
+    void _string(uint32_t sizeBytes, state_t next);
+    // value of the current parameter
+    void _value(state_t next);
+    void _fail();
+
+    bool _setType(uint8_t type);
+    bool _typeOption(uint8_t option);
+    bool _parameterOption(uint8_t option);
+
+    bool _tooBig();
+
+    // size of fixed size values, 0 for others
+    static uint32_t _fixedSize(uint8_t type);
+    static bool _isNumber(uint8_t type);
+
+    state_t m_state{STATE_COMMAND};
+    uint8_t m_command{0};
+    size_t m_packetSize{0};
+    bool m_complete{false};
+    bool m_error{false};
+    bool m_hasData{false};
+
+    // field in progress
+    uint32_t m_remaining{0};
+    bool m_fieldNumber{false};
+    uint32_t m_fieldValue{0};
+    // after the size of a string
+    state_t m_stringNext{STATE_COMMAND};
+
+    // current parameter
+    uint8_t m_type{0};
+    uint8_t m_elementType{0};
+    uint32_t m_customSize{0};
+    uint32_t m_languageSizeBytes{1};
+
+    // feed()
+    std::vector<char> m_pending;
+    size_t m_maxPacketSize{0};
+};
+
+}
+
+#endif // RCP_PACKETSCANNER_H
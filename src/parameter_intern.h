@@ -20,7 +20,6 @@
 
 #include <cinttypes>
 #include <iostream>
-#include <istream>
 #include <string>
 #include <map>
 #include <thread>
@@ -42,6 +41,7 @@
 #include "type_array.h"
 #include "tinystring.h"
 #include "parameter_listener.h"
+#include "deadband.h"
 
 
 //#define RCP_PARAMETER_NO_LOCKING
@@ -117,10 +117,17 @@ public:
         getTypeDefinition().writeMandatory(out);
     }
 
+    bool readUpdateValue(ByteReader& /*is*/) override
+    {
+        // no value
+        return false;
+    }
+
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
         // NOTE: no need to lock here
         // parsing options always into a newly created parameter
@@ -1004,7 +1011,7 @@ public:
     template<typename, typename, datatype_t> friend class ValueParameter;
 
 protected:
-    virtual bool handleOption(const parameter_options_t& /*opt*/, std::istream& /*is*/) {
+    virtual bool handleOption(const parameter_options_t& /*opt*/, ByteReader& /*is*/) {
         return false;
     }
 
@@ -1626,6 +1633,26 @@ public:
         obj->writeValue(out);
     }
 
+    bool readUpdateValue(ByteReader& is) override
+    {
+        // read before locking, parsing may fail
+        T val = getDefaultTypeDefinition().readValue(is);
+        CHECK_STREAM_RETURN(false)
+
+#ifndef RCP_PARAMETER_NO_LOCKING
+        std::lock_guard<std::recursive_mutex> locker(Parameter<TD>::mutex());
+#endif
+
+        // same as update() with a value-only parameter
+        obj->value = val;
+        if (obj->value.changed())
+        {
+            obj->callValueUpdatedCb();
+        }
+
+        return true;
+    }
+
     void dump() override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
@@ -1653,7 +1680,7 @@ public:
         return Parameter<TD>::hasAnyOption() || obj->value.hasValue();
     }
 
-    virtual bool handleOption(const parameter_options_t& opt, std::istream& is) override
+    virtual bool handleOption(const parameter_options_t& opt, ByteReader& is) override
     {
         // NOTE: locking is not necessary
         // parsing options (handleOption()) always uses newly created parameter
@@ -1699,7 +1726,8 @@ public:
 #endif
 
         obj->value = value;
-        if (obj->value.changed())
+        if (obj->value.changed() &&
+            obj->outsideDeadband())
         {
             setDirty();
         }
@@ -1822,6 +1850,46 @@ public:
 
 
 
+    //--------------------------------------------
+    // deadband - number and vector types
+    // a new value closer than threshold to the last sent value
+    // does not mark the parameter dirty.
+    // relative: threshold is a fraction of the last sent value
+    // 0: off (default)
+
+    template<class Q = T>
+    void setDeadband(const typename std::enable_if<Deadband<Q>::supported, double>::type& threshold, bool relative = false)
+    {
+#ifndef RCP_PARAMETER_NO_LOCKING
+        std::lock_guard<std::recursive_mutex> locker(Parameter<TD>::mutex());
+#endif
+        obj->deadband = threshold;
+        obj->deadbandRelative = relative;
+        obj->hasSent = false;
+    }
+
+    template<class Q = T>
+    typename std::enable_if<Deadband<Q>::supported, double>::type
+    getDeadband() const
+    {
+#ifndef RCP_PARAMETER_NO_LOCKING
+        std::lock_guard<std::recursive_mutex> locker(Parameter<TD>::mutex());
+#endif
+        return obj->deadband;
+    }
+
+    template<class Q = T>
+    typename std::enable_if<Deadband<Q>::supported, bool>::type
+    isDeadbandRelative() const
+    {
+#ifndef RCP_PARAMETER_NO_LOCKING
+        std::lock_guard<std::recursive_mutex> locker(Parameter<TD>::mutex());
+#endif
+        return obj->deadbandRelative;
+    }
+
+
+
     //--------------------------------------------
     // convenience - other... string, enum, etc
     // do that in subclasses?
@@ -1971,6 +2039,7 @@ private:
                     if (!all)
                     {
                         value.setUnchanged();
+                        setSent();
                     }
                 }
             }
@@ -1984,6 +2053,27 @@ private:
         void writeValue(Writer& out) {
             out.write(value.value());
             value.setUnchanged();
+            setSent();
+        }
+
+        // deadband reference, only kept with a deadband
+        void setSent() {
+            if (deadband > 0.0 &&
+                value.hasValue())
+            {
+                sent = value.value();
+                hasSent = true;
+            }
+        }
+
+        bool outsideDeadband() const {
+            if (deadband <= 0.0 ||
+                !hasSent ||
+                !value.hasValue())
+            {
+                return true;
+            }
+            return Deadband<T>::exceeds(value.value(), sent, deadband, deadbandRelative);
         }
 
         void callValueUpdatedCb() {
@@ -1994,6 +2084,11 @@ private:
 
         Option<T> value{};
 
+        double deadband{0.0};
+        bool deadbandRelative{false};
+        bool hasSent{false};
+        T sent{};
+
         std::vector< std::shared_ptr<ValueUpdateEventHolder> > valueUpdatedCallbacks;
     };
     std::shared_ptr<Value> obj;
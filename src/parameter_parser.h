@@ -27,7 +27,62 @@ class ParameterParser
 {
 public:
 
-    static ParameterPtr parseUpdateValue(std::istream& is)
+    // apply an update-value directly to the cached parameter
+    // without creating a temporary parameter
+    // returns the updated parameter or nullptr if the data could not be applied.
+    // on nullptr the reader is left untouched - use parseUpdateValue instead
+    static ParameterPtr applyUpdateValue(ByteReader& is, const std::shared_ptr<IParameterManager>& manager)
+    {
+        if (!manager)
+        {
+            return nullptr;
+        }
+
+        ByteReader reader = is;
+
+        // read id
+        int16_t parameter_id = 0;
+        parameter_id = readFromStream(reader, parameter_id);
+
+        // get parameter type_id
+        datatype_t type_id = static_cast<datatype_t>(reader.get());
+
+        if (reader.eof())
+        {
+            return nullptr;
+        }
+
+        switch (type_id)
+        {
+        case DATATYPE_BANG:
+        case DATATYPE_GROUP:
+        case DATATYPE_RANGE:
+        case DATATYPE_ARRAY:
+        case DATATYPE_LIST:
+        case DATATYPE_CUSTOMTYPE:
+            // more mandatory data or no value
+            return nullptr;
+        default:
+            break;
+        }
+
+        ParameterPtr cached = manager->getParameter(parameter_id);
+        if (!cached ||
+            cached->getDatatype() != type_id)
+        {
+            return nullptr;
+        }
+
+        if (!cached->readUpdateValue(reader))
+        {
+            return nullptr;
+        }
+
+        is = reader;
+        return cached;
+    }
+
+    static ParameterPtr parseUpdateValue(ByteReader& is)
     {
         // read id
         int16_t parameter_id = 0;
@@ -60,7 +115,13 @@ public:
         return ParameterFactory::createParameterReadValue(parameter_id, type_id, is);
     }
 
-    static ParameterPtr parse(std::istream& is, std::shared_ptr<IParameterManager> manager = nullptr) {
+    static ParameterPtr parseUpdateValue(std::istream& is)
+    {
+        ByteReader reader(is);
+        return parseUpdateValue(reader);
+    }
+
+    static ParameterPtr parse(ByteReader& is, std::shared_ptr<IParameterManager> manager = nullptr) {
 
         // get id and type
         int16_t parameter_id = 0;
@@ -141,6 +202,11 @@ public:
 
         return param;
     }
+
+    static ParameterPtr parse(std::istream& is, std::shared_ptr<IParameterManager> manager = nullptr) {
+        ByteReader reader(is);
+        return parse(reader, manager);
+    }
 };
 
 }
@@ -14,9 +14,12 @@
 * file, You can obtain one at https://mozilla.org/MPL/2.0/.
 *********************************************************************
 */
+#include <iterator>
+
 #include "parameterclient.h"
 
-#include "stringstreamwriter.h"
+#include "bufferwriter.h"
+#include "packetscanner.h"
 #include "version.h"
 
 namespace rcp {
@@ -65,29 +68,135 @@ void ParameterClient::update()
     // protect lists to be used from multiple threads
     m_parameterManager->lock();
 
+    // reuse one buffer for all packets
+    BufferWriter writer;
+
+    // collect packets into frames if enabled
+    auto send_frame = [this](const SharedBuffer& frame)
+    {
+        m_transporter.send(frame);
+    };
+
     // send updates
-    for (auto& p : m_parameterManager->dirtyParameter) {
+    m_parameterManager->dirtyParameter.drain([&](int16_t id)
+    {
+        const ParameterPtr& parameter = m_parameterManager->params.get(id);
+        if (!parameter)
+        {
+            return;
+        }
 
         command_t cmd = COMMAND_UPDATE;
 
-        if (p.second->onlyValueChanged())
+        if (parameter->onlyValueChanged())
         {
             cmd = COMMAND_UPDATEVALUE;
         }
 
-        Packet packet(cmd, p.second);
+        Packet packet(cmd);
+        packet.setData(parameter);
 
         // serialize
-        StringStreamWriter writer;
+        writer.clear();
         packet.write(writer, false);
 
-        m_transporter.send(writer.getBuffer());
+        if (m_frame.enabled())
+        {
+            m_frame.add(writer.data(), writer.size(), send_frame);
+        }
+        else
+        {
+            m_transporter.send(writer.data(), writer.size());
+        }
+    });
+
+    m_frame.flush(send_frame);
+
+    m_parameterManager->unlock();
+}
+
+void ParameterClient::subscribe(const std::vector<int16_t>& groups,
+                                const std::vector<std::string>& tags)
+{
+    m_parameterManager->lock();
+
+    m_subscription = SubscriptionData::create(groups, tags);
+
+    if (m_initializeSent)
+    {
+        // remove parameters not matching anymore
+        std::vector<ParameterPtr> removed;
+        for (const ParameterPtr& parameter : m_parameterManager->params)
+        {
+            if (!m_subscription->matches(parameter))
+            {
+                removed.push_back(parameter);
+            }
+        }
+
+        for (ParameterPtr& parameter : removed)
+        {
+            for (ParameterClientListener* listener : m_listener)
+            {
+                listener->parameterRemoved(parameter);
+            }
+
+            m_parameterManager->_removeParameterDirect(parameter);
+        }
+
+        // server answers with the parameters it did not send before
+        _sendSubscription();
     }
-    m_parameterManager->dirtyParameter.clear();
 
     m_parameterManager->unlock();
 }
 
+void ParameterClient::unsubscribe()
+{
+    m_parameterManager->lock();
+
+    m_subscription.reset();
+
+    if (m_initializeSent)
+    {
+        _sendSubscription();
+    }
+
+    m_parameterManager->unlock();
+}
+
+void ParameterClient::_sendSubscription()
+{
+    // no data: everything
+    Packet packet(COMMAND_SUBSCRIBE);
+    if (m_subscription)
+    {
+        packet.setData(m_subscription);
+    }
+
+    BufferWriter writer;
+    packet.write(writer, false);
+    m_transporter.send(writer.data(), writer.size());
+}
+
+void ParameterClient::discover(int16_t groupId)
+{
+    WriteablePtr id_data = IdData::create(groupId);
+    Packet packet(COMMAND_DISCOVER, id_data);
+
+    BufferWriter writer;
+    packet.write(writer, false);
+    m_transporter.send(writer.data(), writer.size());
+}
+
+void ParameterClient::setMaxFrameSize(size_t size)
+{
+    // frame is used in update()
+    m_parameterManager->lock();
+    m_frame.setMaxFrameSize(size);
+    m_parameterManager->unlock();
+}
+
 // interface ClientTransporterListener
 void ParameterClient::connected()
 {
@@ -110,59 +219,138 @@ void ParameterClient::disconnected()
 
 void ParameterClient::received(std::istream& data)
 {
-    auto packet = rcp::Packet::parse(data, m_parameterManager);
+    std::vector<char> buffer(std::istreambuf_iterator<char>(data),
+                             (std::istreambuf_iterator<char>()));
+    received(buffer.data(), buffer.size());
+}
+
+void ParameterClient::received(const char* data, size_t size)
+{
+    receivePackets(data, size);
+}
+
+size_t ParameterClient::receivePackets(const char* data, size_t size)
+{
+    // data may contain several packets back to back (a frame)
+    ByteReader reader(data, size);
+    size_t applied = 0;
+    size_t index = 0;
+
+    // one lock for all packets, they are applied like one update
+    m_parameterManager->lock();
 
-    if (packet.hasValue())
+    while (reader.remaining() > 0 &&
+           !reader.eof())
     {
-        rcp::Packet& the_packet = packet.value();
-        switch (the_packet.getCommand())
+        const char* packet_start = reader.current();
+        size_t packet_remaining = reader.remaining();
+
+        if (!_receivedPacket(reader))
         {
-        case COMMAND_INITIALIZE:
-            // NOTE: marks the end of init parameters from server
-            for (ParameterClientListener* listener : m_listener)
+            PacketError error;
+            error.index = index;
+            error.offset = static_cast<size_t>(packet_start - data);
+            error.size = PacketScanner::findPacket(packet_start, packet_remaining);
+            error.command = static_cast<unsigned char>(*packet_start);
+
+            _packetError(error);
+
+            if (error.size == 0)
             {
-                listener->initializeDone();
+                // can not find the next packet
+                break;
             }
-            break;
-
-        case COMMAND_UPDATE:
-        case COMMAND_UPDATEVALUE:
-            _update(the_packet);
-            break;
-
-        case COMMAND_INFO:
-            _version(the_packet);
-            break;
-
-        case COMMAND_DISCOVER:
-            // not implemented
-//            std::cerr << "invalid command 'discover' on client\n";
-            break;
-
-        case COMMAND_REMOVE:
-            _remove(the_packet);
-            break;
-
-        case COMMAND_INVALID:
-        case COMMAND_MAX_:
-//            std::cerr << "got invalid command!\n";
-            break;
+
+            reader = ByteReader(packet_start + error.size, packet_remaining - error.size);
+            index++;
+            continue;
         }
+
+        applied++;
+        index++;
     }
-    else
+
+    m_parameterManager->unlock();
+
+    return applied;
+}
+
+void ParameterClient::_packetError(const PacketError& error)
+{
+    for (ParameterClientListener* listener : m_listener)
     {
-        // parsing error??
+        listener->parsingError();
+        listener->packetError(error);
+    }
 
-        for (ParameterClientListener* listener : m_listener)
+    for (const auto& kv : parsing_error_cb)
+    {
+        (kv.first->*kv.second)();
+        kv.first->packetError(error);
+    }
+}
+
+bool ParameterClient::_receivedPacket(ByteReader& reader)
+{
+    // fast path: apply value updates directly to the cached parameter
+    if (reader.peek() == COMMAND_UPDATEVALUE)
+    {
+        ByteReader value_reader = reader;
+        value_reader.get();
+
+        if (ParameterParser::applyUpdateValue(value_reader, m_parameterManager))
         {
-            listener->parsingError();
+            reader = value_reader;
+            return true;
         }
+    }
+
+    auto packet = rcp::Packet::parse(reader, m_parameterManager);
+
+    if (!packet.hasValue())
+    {
+        return false;
+    }
 
-        for (const auto& kv : parsing_error_cb)
+    rcp::Packet& the_packet = packet.value();
+    switch (the_packet.getCommand())
+    {
+    case COMMAND_INITIALIZE:
+        // NOTE: marks the end of init parameters from server
+        for (ParameterClientListener* listener : m_listener)
         {
-            (kv.first->*kv.second)();
+            listener->initializeDone();
         }
+        break;
+
+    case COMMAND_UPDATE:
+    case COMMAND_UPDATEVALUE:
+        _update(the_packet);
+        break;
+
+    case COMMAND_INFO:
+        _version(the_packet);
+        break;
+
+    case COMMAND_DISCOVER:
+        _discovered(the_packet);
+        break;
+
+    case COMMAND_SUBSCRIBE:
+        // sent by clients only
+        break;
+
+    case COMMAND_REMOVE:
+        _remove(the_packet);
+        break;
+
+    case COMMAND_INVALID:
+    case COMMAND_MAX_:
+//        std::cerr << "got invalid command!\n";
+        break;
     }
+
+    return true;
 }
 
 void ParameterClient::_version(Packet& packet) {
@@ -192,7 +380,22 @@ void ParameterClient::_version(Packet& packet) {
             if (!m_initializeSent &&
                 version_ok)
             {
-                initialize();
+                if (m_subscription)
+                {
+                    _sendSubscription();
+                }
+                else if (m_lazyDiscovery)
+                {
+                    // top level only
+                    char data[2];
+                    data[0] = COMMAND_DISCOVER;
+                    data[1] = TERMINATOR;
+                    m_transporter.send(data, 2);
+                }
+                else
+                {
+                    initialize();
+                }
 
                 // only send initialize once
                 m_initializeSent = true;
@@ -204,9 +407,9 @@ void ParameterClient::_version(Packet& packet) {
         // no data, respond with version
         WriteablePtr version = InfoData::create(RCP_SPECIFICATION_VERSION, m_applicationId);
         Packet resp_packet(COMMAND_INFO, version);
-        StringStreamWriter writer;
+        BufferWriter writer;
         resp_packet.write(writer, false);
-        m_transporter.send(writer.getBuffer());
+        m_transporter.send(writer.data(), writer.size());
     }
 }
 
@@ -261,6 +464,24 @@ void ParameterClient::_update(rcp::Packet& packet)
 
 }
 
+void ParameterClient::_discovered(Packet& packet)
+{
+    // marks the end of a discovered subtree
+    if (!packet.hasData())
+    {
+        return;
+    }
+
+    IdDataPtr id_data = std::dynamic_pointer_cast<IdData>(packet.getData());
+    if (id_data)
+    {
+        for (ParameterClientListener* listener : m_listener)
+        {
+            listener->discoverDone(id_data->getId());
+        }
+    }
+}
+
 void ParameterClient::_remove(Packet& packet)
 {
     if (!packet.hasData())
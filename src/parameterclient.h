@@ -22,6 +22,7 @@
 #include "clienttransporter.h"
 #include "parametermanager.h"
 #include "rcp_error_listener.h"
+#include "framebuilder.h"
 
 namespace rcp {
 
@@ -32,7 +33,11 @@ public:
     virtual void parameterAdded(ParameterPtr /*parameter*/) {}
     virtual void parameterRemoved(ParameterPtr /*parameter*/) {}
     virtual void initializeDone() {}
+    // subtree of ParameterClient::discover() arrived
+    virtual void discoverDone(int16_t /*groupId*/) {}
     virtual void parsingError() {}
+    // called after parsingError() with details
+    virtual void packetError(const PacketError& /*error*/) {}
 };
 
 
@@ -50,6 +55,28 @@ public:
     void initialize(); // tries to send an init-command
     void update(); // update all changes
 
+    // receive only parameters matching the subscription, see SubscriptionData.
+    // groups are always received, they make up the tree.
+    // sent instead of initialize, or right away if already initialized:
+    // parameters not matching anymore are removed then
+    void subscribe(const std::vector<int16_t>& groups,
+                   const std::vector<std::string>& tags = std::vector<std::string>());
+    // receive all parameters again
+    void unsubscribe();
+
+    // lazy browsing: init with the top level parameters only,
+    // groups are filled by discover(). a subscription takes precedence
+    void setLazyDiscovery(bool lazy) { m_lazyDiscovery = lazy; }
+    bool isLazyDiscovery() const { return m_lazyDiscovery; }
+
+    // request the subtree of a group
+    void discover(int16_t groupId);
+
+    // pack all packets of one update() into frames of max size bytes
+    // 0: one packet per send (default)
+    void setMaxFrameSize(size_t size);
+    size_t getMaxFrameSize() const { return m_frame.getMaxFrameSize(); }
+
     // listener
     void addListener(ParameterClientListener* listener);
     void removeListener(ParameterClientListener* listener);
@@ -75,6 +102,10 @@ public:
         return m_parameterManager->rootGroup();
     }
 
+    ParameterPtr getParameter(const int16_t id) const {
+        return m_parameterManager->getParameter(id);
+    }
+
     std::string getServerVersion() const
     {
         return m_serverVersion;
@@ -93,21 +124,36 @@ public:
     virtual void connected();
     virtual void disconnected();
     virtual void received(std::istream& data);
+    virtual void received(const char* data, size_t size);
+
+    // apply all packets of data in order, the parameter manager is locked once.
+    // a broken packet is reported to the parsing error listeners
+    // and skipped if its end can be found
+    // returns the number of applied packets
+    size_t receivePackets(const char* data, size_t size);
 
 protected:
     std::shared_ptr<ParameterManager> m_parameterManager;
     ClientTransporter& m_transporter;
 
 private:
+    bool _receivedPacket(ByteReader& reader);
+    void _packetError(const PacketError& error);
     void _update(Packet& packet);
     void _remove(Packet& packet);
     void _version(Packet& packet);
+    void _sendSubscription();
+    void _discovered(Packet& packet);
 
     std::map<ParsingErrorListener*, void(ParsingErrorListener::*)()> parsing_error_cb;
     std::vector<ParameterClientListener*> m_listener;
 
     std::string m_applicationId;
     bool m_initializeSent{false};
+    SubscriptionDataPtr m_subscription;
+    bool m_lazyDiscovery{false};
+
+    FrameBuilder m_frame;
 
     // server
     std::string m_serverApplicationId;
@@ -118,7 +118,7 @@ ParameterPtr ParameterFactory::createParameter(int16_t parameter_id, datatype_t
     return nullptr;
 }
 
-ParameterPtr ParameterFactory::createParameterReadValue(int16_t parameter_id, datatype_t type_id, std::istream& is)
+ParameterPtr ParameterFactory::createParameterReadValue(int16_t parameter_id, datatype_t type_id, ByteReader& is)
 {
     switch (type_id) {
     // no value
@@ -263,7 +263,7 @@ ParameterPtr ParameterFactory::createRangeParameter(int16_t parameter_id, dataty
     return nullptr;
 }
 
-ParameterPtr ParameterFactory::createRangeParameterReadValue(int16_t parameter_id, datatype_t type_id, std::istream& is)
+ParameterPtr ParameterFactory::createRangeParameterReadValue(int16_t parameter_id, datatype_t type_id, ByteReader& is)
 {
     switch (type_id) {
     case DATATYPE_INT8:
@@ -303,4 +303,16 @@ ParameterPtr ParameterFactory::createRangeParameterReadValue(int16_t parameter_i
 
     return nullptr;
 }
+
+ParameterPtr ParameterFactory::createParameterReadValue(int16_t parameter_id, datatype_t type_id, std::istream& is)
+{
+    ByteReader reader(is);
+    return createParameterReadValue(parameter_id, type_id, reader);
+}
+
+ParameterPtr ParameterFactory::createRangeParameterReadValue(int16_t parameter_id, datatype_t type_id, std::istream& is)
+{
+    ByteReader reader(is);
+    return createRangeParameterReadValue(parameter_id, type_id, reader);
+}
 }
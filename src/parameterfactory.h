@@ -31,12 +31,19 @@ class ParameterFactory
 {
 public:
     template<typename T>
-    static ParameterPtr readValue(const T& p, std::istream& is) {
+    static ParameterPtr readValue(const T& p, ByteReader& is) {
         p->setValue(p->getDefaultTypeDefinition().readValue(is));
         return p;
     }
 
+    template<typename T>
+    static ParameterPtr readValue(const T& p, std::istream& is) {
+        ByteReader reader(is);
+        return readValue(p, reader);
+    }
+
     static ParameterPtr createParameter(int16_t parameter_id, datatype_t type_id);
+    static ParameterPtr createParameterReadValue(int16_t parameter_id, datatype_t type_id, ByteReader& is);
     static ParameterPtr createParameterReadValue(int16_t parameter_id, datatype_t type_id, std::istream& is);
 
 
@@ -46,6 +53,7 @@ public:
     }
 
     static ParameterPtr createRangeParameter(int16_t parameter_id, datatype_t type_id);
+    static ParameterPtr createRangeParameterReadValue(int16_t parameter_id, datatype_t type_id, ByteReader& is);
     static ParameterPtr createRangeParameterReadValue(int16_t parameter_id, datatype_t type_id, std::istream& is);
 };
 
@@ -26,6 +26,7 @@ ParameterManager::ParameterManager()
 }
 
 ParameterManager::~ParameterManager() {
+    releaseReservedIds();
 }
 
 void ParameterManager::removeParameter(ParameterPtr parameter) {
@@ -44,16 +45,16 @@ void ParameterManager::removeParameter(int16_t id)
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    auto it = params.find(id);
-    if (it == params.end())
+    ParameterPtr parameter = params.get(id);
+    if (!parameter)
     {
         return;
     }
 
     // add it to removed
-    setParameterRemoved(params[id]);
+    setParameterRemoved(parameter);
 
-    _removeParameterDirect(params[id]);
+    _removeParameterDirect(parameter);
 }
 
 void ParameterManager::_removeParameterDirect(ParameterPtr& parameter)
@@ -68,14 +69,14 @@ void ParameterManager::_removeParameterDirect(ParameterPtr& parameter)
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    // erase from available ids
-    auto id_it = std::find(ids.begin(), ids.end(), parameter->getId());
-    if (id_it != ids.end()) {
-        ids.erase(id_it);
-    } else {
+    // release id
+    if (!ids.release(parameter->getId())) {
         std::cerr << "ParameterManager::removeParameterDirect - could not find id in id list\n";
     }
 
+    // a reused id starts without limit
+    _resetRateLimit(parameter->getId());
+
     if (auto p = parameter->getParent().lock()) {
         p->removeChild(parameter);
     }
@@ -84,8 +85,13 @@ void ParameterManager::_removeParameterDirect(ParameterPtr& parameter)
     // check if this is a group... if so, remove all children without!! adding them to the removed-list
     if (parameter->getTypeDefinition().getDatatype() == DATATYPE_GROUP) {
         GroupParameterPtr gp = std::dynamic_pointer_cast<GroupParameter>(parameter);
+        // children remove themselves from the group
+        std::vector<ParameterPtr> children;
         for (auto& child : gp->children()) {
-            _removeParameterDirect(child.second);
+            children.push_back(child.second);
+        }
+        for (auto& child : children) {
+            _removeParameterDirect(child);
         }
     }
 }
@@ -271,39 +277,59 @@ ParameterPtr ParameterManager::getParameter(const int16_t id) const
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    auto it = params.find(id);
+    return params.get(id);
+}
 
-    if (it != params.end())
+
+// private functions
+
+
+int16_t ParameterManager::_getNextId()
+{
+#ifndef RCP_MANAGER_NO_LOCKING
+    // protect lists to be used from multiple threads
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+#endif
+
+    if (!reservedIds.empty())
     {
-        return it->second;
+        int16_t id = reservedIds.front();
+        reservedIds.pop_front();
+        return id;
     }
 
-    return nullptr;
+    // returns invalid id 0 if no id is available
+    return ids.allocate();
 }
 
+size_t ParameterManager::reserveIds(size_t count)
+{
+#ifndef RCP_MANAGER_NO_LOCKING
+    // protect lists to be used from multiple threads
+    std::lock_guard<std::recursive_mutex> lock(m_mutex);
+#endif
 
-// private functions
+    std::vector<int16_t> new_ids;
+    new_ids.reserve(count);
 
+    size_t allocated = ids.allocate(count, new_ids);
+    reservedIds.insert(reservedIds.end(), new_ids.begin(), new_ids.end());
 
-int16_t ParameterManager::_getNextId()
+    return allocated;
+}
+
+void ParameterManager::releaseReservedIds()
 {
 #ifndef RCP_MANAGER_NO_LOCKING
     // protect lists to be used from multiple threads
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    for (unsigned short i=1; i<USHRT_MAX; i++)
+    for (int16_t id : reservedIds)
     {
-        if (ids.find(static_cast<int16_t>(i)) == ids.end())
-        {
-            int16_t i_s = static_cast<int16_t>(i);
-            ids.insert(i_s);
-            return i_s;
-        }
+        ids.release(id);
     }
-
-    // return invalid id 0
-    return 0;
+    reservedIds.clear();
 }
 
 
@@ -323,22 +349,19 @@ void ParameterManager::_addParameter(ParameterPtr& parameter)
 #endif
 
     // check if already in map
-    if (params.find(parameter->getId()) != params.end())
+    if (params.contains(parameter->getId()))
     {
         // parameter is already registered in map... ignore
         return;
     }
 
     // need to reserve id
-    if (std::find(ids.begin(), ids.end(), parameter->getId()) != ids.end())
+    if (!ids.reserve(parameter->getId()))
     {
         // huh - parameter is not in parameter cache, but id already taken!?
         std::cerr << "inconsistency in id,parameter list\n";
     }
 
-    // in any case: reserve that id
-    ids.insert(parameter->getId());
-
     // avoid parameter getting dirty when setting parent
     //        parameter->setManager(nullptr);
 
@@ -355,7 +378,7 @@ void ParameterManager::_addParameter(ParameterPtr& parameter)
     }
 
     // add parameter to map
-    params[parameter->getId()] = parameter;
+    params.set(parameter->getId(), parameter);
 
     if (isGroup(parameter))
     {
@@ -430,7 +453,7 @@ void ParameterManager::_addParameterDirect(const std::string& label, ParameterPt
         m_rootGroup->addChild(parameter);
     }
 
-    params[parameter->getId()] = parameter;
+    params.set(parameter->getId(), parameter);
 }
 
 
@@ -442,63 +465,223 @@ bool ParameterManager::setParameterDirty(ParameterPtr parameter)
         return false;
     }
 
-#ifndef RCP_MANAGER_NO_LOCKING
-    // protect lists to be used from multiple threads
-    std::lock_guard<std::recursive_mutex> lock(m_mutex);
-#endif
+    // NOTE: no locking, dirty and removed ids are atomic
 
     // only add if not already removed
-    if (removedParameter.find(parameter->getId()) != removedParameter.end()) {
+    if (removedParameter.test(parameter->getId())) {
         // parameter is removed, don't add
         std::cout << "parameter going to be removed: " << parameter->getId() << "\n";
         return false;
     }
 
-    dirtyParameter[parameter->getId()] = parameter;
+    dirtyParameter.set(parameter->getId());
 
     return true;
 }
 
 bool ParameterManager::isParameterDirty(ParameterPtr parameter)
+{
+    return dirtyParameter.test(parameter->getId());
+}
+
+void ParameterManager::setParameterRemoved(ParameterPtr parameter)
+{
+    // mark removed first, so a concurrent setParameterDirty can not add it again
+    removedParameter.set(parameter->getId());
+
+    // remove parameter from dirties
+    dirtyParameter.reset(parameter->getId());
+}
+
+void ParameterManager::_clear()
 {
 #ifndef RCP_MANAGER_NO_LOCKING
     // protect lists to be used from multiple threads
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    return dirtyParameter.find(parameter->getId()) != dirtyParameter.end();
+    releaseReservedIds();
+    ids.clear();
+    params.clear();
+    dirtyParameter.clear();
+    removedParameter.clear();
+    m_rootGroup->children().clear();
+    missingParents.clear();
+    m_rateLimits.clear();
+    m_rateLimitCount = 0;
 }
 
-void ParameterManager::setParameterRemoved(ParameterPtr parameter)
+static size_t rateLimitIndex(int16_t id)
+{
+    return static_cast<uint16_t>(id);
+}
+
+void ParameterManager::setMaxUpdateRate(int16_t id, float hz)
 {
 #ifndef RCP_MANAGER_NO_LOCKING
     // protect lists to be used from multiple threads
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    // check if parameter is dirty...
-    auto it = dirtyParameter.find(parameter->getId());
-    if (it != dirtyParameter.end()) {
-        // remove parameter from dirties
-        dirtyParameter.erase(it);
+    if (hz <= 0.f)
+    {
+        _resetRateLimit(id);
+    }
+    else
+    {
+        size_t index = rateLimitIndex(id);
+        if (index >= m_rateLimits.size())
+        {
+            m_rateLimits.resize(index + 1);
+        }
+
+        RateLimit& limit = m_rateLimits[index];
+        if (limit.own == clock::duration::zero())
+        {
+            m_rateLimitCount++;
+        }
+
+        limit.own = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / hz));
+        limit.interval = limit.own;
     }
 
-    removedParameter[parameter->getId()] = parameter;
+    // resolve inherited limits now, not on every update
+    const ParameterPtr& parameter = params.get(id);
+    if (parameter &&
+        m_rateLimitCount > 0)
+    {
+        _resolveUpdateInterval(parameter, _inheritedInterval(parameter));
+    }
 }
 
-void ParameterManager::_clear()
+float ParameterManager::getMaxUpdateRate(int16_t id) const
 {
 #ifndef RCP_MANAGER_NO_LOCKING
     // protect lists to be used from multiple threads
     std::lock_guard<std::recursive_mutex> lock(m_mutex);
 #endif
 
-    ids.clear();
-    params.clear();
-    dirtyParameter.clear();
-    removedParameter.clear();
-    m_rootGroup->children().clear();
-    missingParents.clear();
+    size_t index = rateLimitIndex(id);
+    if (index >= m_rateLimits.size() ||
+        m_rateLimits[index].own == clock::duration::zero())
+    {
+        return 0.f;
+    }
+
+    return static_cast<float>(1.0 / std::chrono::duration<double>(m_rateLimits[index].own).count());
+}
+
+bool ParameterManager::_takeUpdate(const ParameterPtr& parameter, bool structureChanged, clock::time_point now)
+{
+    if (m_rateLimits.empty())
+    {
+        // no limits
+        return true;
+    }
+
+    if (structureChanged)
+    {
+        // new or moved parameter
+        _resolveUpdateInterval(parameter, _inheritedInterval(parameter));
+    }
+
+    int16_t id = parameter->getId();
+    size_t index = rateLimitIndex(id);
+    if (index >= m_rateLimits.size())
+    {
+        return true;
+    }
+
+    RateLimit& limit = m_rateLimits[index];
+    if (limit.interval == clock::duration::zero())
+    {
+        return true;
+    }
+
+    if (limit.sent &&
+        now - limit.lastUpdate < limit.interval)
+    {
+        // keep the change, the latest value is sent when the interval passed
+        dirtyParameter.set(id);
+        return false;
+    }
+
+    limit.lastUpdate = now;
+    limit.sent = true;
+
+    return true;
+}
+
+void ParameterManager::_resolveUpdateInterval(const ParameterPtr& parameter, clock::duration inherited)
+{
+    clock::duration interval = inherited;
+
+    size_t index = rateLimitIndex(parameter->getId());
+    if (index < m_rateLimits.size())
+    {
+        RateLimit& limit = m_rateLimits[index];
+        if (limit.own != clock::duration::zero())
+        {
+            interval = limit.own;
+        }
+        limit.interval = interval;
+    }
+    else if (interval != clock::duration::zero())
+    {
+        m_rateLimits.resize(index + 1);
+        m_rateLimits[index].interval = interval;
+    }
+
+    if (parameter->getTypeDefinition().getDatatype() == DATATYPE_GROUP)
+    {
+        GroupParameterPtr group = std::dynamic_pointer_cast<GroupParameter>(parameter);
+        if (group)
+        {
+            for (auto& child : group->children())
+            {
+                _resolveUpdateInterval(child.second, interval);
+            }
+        }
+    }
+}
+
+ParameterManager::clock::duration ParameterManager::_inheritedInterval(const ParameterPtr& parameter) const
+{
+    // the parent is resolved already
+    GroupParameterPtr parent = parameter->getParent().lock();
+    if (parent)
+    {
+        size_t index = rateLimitIndex(parent->getId());
+        if (index < m_rateLimits.size())
+        {
+            return m_rateLimits[index].interval;
+        }
+    }
+
+    return clock::duration::zero();
+}
+
+void ParameterManager::_resetRateLimit(int16_t id)
+{
+    size_t index = rateLimitIndex(id);
+    if (index >= m_rateLimits.size())
+    {
+        return;
+    }
+
+    RateLimit& limit = m_rateLimits[index];
+    if (limit.own != clock::duration::zero())
+    {
+        m_rateLimitCount--;
+    }
+
+    limit = RateLimit();
+
+    if (m_rateLimitCount == 0)
+    {
+        // inherited ones are gone as well
+        m_rateLimits.clear();
+    }
 }
 
 void ParameterManager::lock()
@@ -20,10 +20,10 @@
 
 //#define RCP_MANAGER_NO_LOCKING
 
+#include <chrono>
 #include <map>
 #include <vector>
-#include <unordered_set>
-#include <climits>
+#include <deque>
 
 #ifndef RCP_MANAGER_NO_LOCKING
 #include <mutex>
@@ -31,6 +31,9 @@
 
 #include "parameter_intern.h"
 #include "iparametermanager.h"
+#include "idallocator.h"
+#include "parametertable.h"
+#include "atomicidset.h"
 
 namespace rcp {
 
@@ -61,6 +64,12 @@ public:
     void removeParameter(ParameterPtr parameter);
     void removeParameter(int16_t id);
 
+    // reserve ids for the next count parameters
+    // use when creating many parameters at once
+    // ids not used stay allocated until releaseReservedIds()
+    size_t reserveIds(size_t count);
+    void releaseReservedIds();
+
     BooleanParameterPtr createBooleanParameter(const std::string& label, GroupParameterPtr group = nullptr);
     Int8ParameterPtr createInt8Parameter(const std::string& label, GroupParameterPtr group = nullptr);
     Int16ParameterPtr createInt16Parameter(const std::string& label, GroupParameterPtr group = nullptr);
@@ -78,6 +87,14 @@ public:
     GroupParameterPtr rootGroup() const;
     void dumpHierarchy() const;
 
+    // send at most hz updates per second of parameter id, 0: no limit
+    // a limit set on a group is the default of all parameters below it
+    // without a limit of their own, each of them is limited separately.
+    // changes in between are collapsed, the last value is sent
+    // with the first update() after the interval.
+    void setMaxUpdateRate(int16_t id, float hz);
+    float getMaxUpdateRate(int16_t id) const;
+
     friend class ParameterServer;
     friend class ParameterClient;
 
@@ -100,16 +117,43 @@ private:
     void _removeParameterDirect(ParameterPtr& parameter);
     void _clear();
 
+    // rate limit, called with locked manager when sending
+    // returns false if parameter has to wait, it is marked dirty again
+    // on a structure change the inherited limit is resolved again
+    typedef std::chrono::steady_clock clock;
+    bool _takeUpdate(const ParameterPtr& parameter, bool structureChanged, clock::time_point now);
+    // sets the interval of parameter and the ones below it
+    void _resolveUpdateInterval(const ParameterPtr& parameter, clock::duration inherited);
+    clock::duration _inheritedInterval(const ParameterPtr& parameter) const;
+    void _resetRateLimit(int16_t id);
+
+    struct RateLimit
+    {
+        // set with setMaxUpdateRate
+        clock::duration own{clock::duration::zero()};
+        // own or the one inherited from the closest group
+        clock::duration interval{clock::duration::zero()};
+        clock::time_point lastUpdate;
+        bool sent{false};
+    };
+
     //--------
-    std::unordered_set<int16_t> ids;
-    std::map<int16_t, ParameterPtr > params;
-    std::map<int16_t, ParameterPtr > dirtyParameter;
-    std::map<int16_t, ParameterPtr > removedParameter;
+    IdAllocator ids;
+    std::deque<int16_t> reservedIds;
+    ParameterTable params;
+    // lock-free: parameters mark themselves dirty from any thread
+    AtomicIdSet dirtyParameter;
+    AtomicIdSet removedParameter;
     GroupParameterPtr m_rootGroup;
 
     //
     std::map<int16_t, std::vector<ParameterPtr> > missingParents;
 
+    // rate limits indexed by id, empty without any limit
+    std::vector<RateLimit> m_rateLimits;
+    // ids with a limit of their own
+    size_t m_rateLimitCount{0};
+
 private:
     void lock();
     void unlock();
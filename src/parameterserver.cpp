@@ -15,11 +15,15 @@
 *********************************************************************
 */
 
+#include <algorithm>
+#include <iterator>
+
 #include "parameterserver.h"
 
 #include "infodata.h"
 #include "packet.h"
-#include "stringstreamwriter.h"
+#include "packetscanner.h"
+#include "bufferwriter.h"
 #include "version.h"
 
 namespace rcp {
@@ -39,6 +43,7 @@ ParameterServer::ParameterServer(ServerTransporter& transporter)
 
 ParameterServer::~ParameterServer()
 {
+    stopSender();
     dispose();
 }
 
@@ -50,65 +55,229 @@ void ParameterServer::dispose()
 
 void ParameterServer::clear()
 {
+    m_parameterManager->lock();
+
     m_parameterManager->_clear();
+    m_initCache.clear();
+    m_initSnapshot = Snapshot();
+    m_topLevelSnapshot = Snapshot();
+    m_discoverCache.clear();
+
+    m_parameterManager->unlock();
 }
 
 
 void ParameterServer::received(std::istream& data, ServerTransporter& transporter, void* id)
 {
-    // parse data
-    Option<Packet> packet_option = Packet::parse(data, m_parameterManager);
+    std::vector<char> buffer(std::istreambuf_iterator<char>(data),
+                             (std::istreambuf_iterator<char>()));
+    received(buffer.data(), buffer.size(), transporter, id);
+}
+
+void ParameterServer::received(const char* data, size_t size, ServerTransporter& transporter, void* id)
+{
+    receivePackets(data, size, transporter, id);
+}
+
+size_t ParameterServer::receivePackets(const char* data, size_t size, ServerTransporter& transporter, void* id)
+{
+    // data may contain several packets back to back (a frame)
+    ByteReader reader(data, size);
+    size_t applied = 0;
+    size_t index = 0;
 
-    if (packet_option.hasValue())
+    // forward consecutive packets as one range
+    const char* forward_start = data;
+    size_t forward_size = 0;
+
+    // one lock for all packets, they are applied like one update
+    m_parameterManager->lock();
+
+    while (reader.remaining() > 0 &&
+           !reader.eof())
     {
-        // got a packet
-        Packet& the_packet = packet_option.value();
+        const char* packet_start = reader.current();
+        size_t packet_remaining = reader.remaining();
+        bool forward = false;
+
+        if (!_receivedPacket(reader, transporter, id, forward))
+        {
+            PacketError error;
+            error.index = index;
+            error.offset = static_cast<size_t>(packet_start - data);
+            error.size = PacketScanner::findPacket(packet_start, packet_remaining);
+            error.command = static_cast<unsigned char>(*packet_start);
+
+            _packetError(error);
+
+            if (error.size == 0)
+            {
+                // can not find the next packet
+                break;
+            }
+
+            reader = ByteReader(packet_start + error.size, packet_remaining - error.size);
+            index++;
+            continue;
+        }
+
+        applied++;
+        index++;
 
-        switch (the_packet.getCommand())
+        if (forward)
         {
-        case COMMAND_INITIALIZE:
-            _init(transporter, id);
-            break;
+            size_t packet_size = static_cast<size_t>(reader.current() - packet_start);
 
-        case COMMAND_UPDATEVALUE:
-        case COMMAND_UPDATE:
-            if (_update(the_packet, transporter, id))
+            if (!m_subscriptions.empty())
             {
-                // send data to all clients
-                for (auto& transporter : transporterList)
+                // filtered per packet, keep the order
+                if (forward_size > 0)
                 {
-                    // rewind data
-                    data.seekg(0, data.beg);
-                    transporter.get().sendToAll(data, id);
+                    _forward(forward_start, forward_size, id);
+                    forward_size = 0;
                 }
+
+                _forwardSubscribed(packet_start, packet_size, id);
+                continue;
+            }
+
+            if (forward_size > 0 &&
+                    (forward_start + forward_size != packet_start ||
+                     forward_size + packet_size > m_maxFrameSize))
+            {
+                _forward(forward_start, forward_size, id);
+                forward_size = 0;
             }
-            break;
 
-        case COMMAND_INFO:
-            // handle version-packet
-            _version(the_packet, transporter, id);
-            break;
+            if (forward_size == 0)
+            {
+                forward_start = packet_start;
+            }
+            forward_size += packet_size;
+        }
+    }
+
+    if (forward_size > 0)
+    {
+        _forward(forward_start, forward_size, id);
+    }
 
-        case COMMAND_DISCOVER:
-            // not implemented
-            break;
+    m_parameterManager->unlock();
 
-        case COMMAND_REMOVE:
-            // error!
-            break;
+    return applied;
+}
 
-        case COMMAND_INVALID:
-        case COMMAND_MAX_:
-            break;
-        }
+void ParameterServer::_packetError(const PacketError& error)
+{
+    for (const auto& kv : parsing_error_cb)
+    {
+        (kv.first->*kv.second)();
+        kv.first->packetError(error);
     }
-    else
+}
+
+bool ParameterServer::_receivedPacket(ByteReader& reader, ServerTransporter& transporter, void* id, bool& forward)
+{
+    // fast path: apply value updates directly to the cached parameter
+    if (reader.peek() == COMMAND_UPDATEVALUE)
     {
-        for (const auto& kv : parsing_error_cb)
+        ByteReader value_reader = reader;
+        value_reader.get();
+
+        ParameterPtr parameter = ParameterParser::applyUpdateValue(value_reader, m_parameterManager);
+        if (parameter)
         {
-            (kv.first->*kv.second)();
+            // cached images hold the old value
+            _patchInitCache(parameter->getId());
+
+            reader = value_reader;
+            forward = true;
+            return true;
         }
     }
+
+    // parse data
+    Option<Packet> packet_option = Packet::parse(reader, m_parameterManager);
+
+    if (!packet_option.hasValue())
+    {
+        return false;
+    }
+
+    // got a packet
+    Packet& the_packet = packet_option.value();
+
+    switch (the_packet.getCommand())
+    {
+    case COMMAND_INITIALIZE:
+        // everything, replaces a subscription
+        m_subscriptions.erase(Connection(&transporter, id));
+        _init(transporter, id);
+        break;
+
+    case COMMAND_UPDATEVALUE:
+    case COMMAND_UPDATE:
+        // send data to all clients
+        forward = _update(the_packet, transporter, id);
+        break;
+
+    case COMMAND_INFO:
+        // handle version-packet
+        _version(the_packet, transporter, id);
+        break;
+
+    case COMMAND_DISCOVER:
+        _discover(the_packet, transporter, id);
+        break;
+
+    case COMMAND_SUBSCRIBE:
+        _subscribe(the_packet, transporter, id);
+        break;
+
+    case COMMAND_REMOVE:
+        // error!
+        break;
+
+    case COMMAND_INVALID:
+    case COMMAND_MAX_:
+        break;
+    }
+
+    return true;
+}
+
+void ParameterServer::_forwardSubscribed(const char* data, size_t size, void* id)
+{
+    // NOTE: called with locked manager
+
+    // UPDATE and UPDATEVALUE start with the parameter id
+    ByteReader reader(data + 1, size - 1);
+    int16_t parameter_id = 0;
+    parameter_id = readFromStream(reader, parameter_id);
+
+    ParameterPtr parameter = m_parameterManager->getParameter(parameter_id);
+    if (!parameter)
+    {
+        _forward(data, size, id);
+        return;
+    }
+
+    ConnectionList excluded;
+    if (!_audience(parameter, getConnectionCount(), excluded))
+    {
+        // nobody else subscribed to it
+        return;
+    }
+
+    _sendTo(SharedBuffer(data, size), id, &excluded);
+}
+
+void ParameterServer::_forward(const char* data, size_t size, void* id)
+{
+    for (auto& transporter : transporterList)
+    {
+        transporter.get().sendToAll(data, size, id);
+    }
 }
 
 bool ParameterServer::addTransporter(ServerTransporter& transporter)
@@ -139,6 +308,22 @@ bool ParameterServer::removeTransporter(ServerTransporter& transporter) {
             // contained
             it->get().removeReceivedCb(this);
             transporterList.erase(it);
+
+            // forget subscriptions of its connections
+            m_parameterManager->lock();
+            for (auto sub = m_subscriptions.begin(); sub != m_subscriptions.end(); )
+            {
+                if (sub->first.first == &transporter)
+                {
+                    sub = m_subscriptions.erase(sub);
+                }
+                else
+                {
+                    sub++;
+                }
+            }
+            m_parameterManager->unlock();
+
             return true;
         }
     }
@@ -158,6 +343,28 @@ int ParameterServer::getConnectionCount()
     return count;
 }
 
+void ParameterServer::clientConnected(ServerTransporter& transporter, void* id)
+{
+    // a new connection might reuse the id of a closed one
+    clientDisconnected(transporter, id);
+}
+
+void ParameterServer::clientDisconnected(ServerTransporter& transporter, void* id)
+{
+    m_parameterManager->lock();
+    m_subscriptions.erase(Connection(&transporter, id));
+    m_parameterManager->unlock();
+}
+
+size_t ParameterServer::getSubscriptionCount() const
+{
+    m_parameterManager->lock();
+    size_t count = m_subscriptions.size();
+    m_parameterManager->unlock();
+
+    return count;
+}
+
 
 // listener
 void ParameterServer::addListener(ParameterServerListener* listener)
@@ -180,6 +387,33 @@ void ParameterServer::removeListener(ParameterServerListener* listener)
 }
 
 
+void ParameterServer::setMaxFrameSize(size_t size)
+{
+    // frame is used in update()
+    m_parameterManager->lock();
+
+    m_maxFrameSize = size;
+    m_frame.setMaxFrameSize(size);
+
+    // packets stay valid, only the frames change
+    m_initSnapshot.frames.reset();
+    m_topLevelSnapshot.frames.reset();
+    for (auto& kv : m_discoverCache)
+    {
+        kv.second.frames.reset();
+    }
+
+    m_parameterManager->unlock();
+}
+
+void ParameterServer::setValueChannel(ValueChannel* channel)
+{
+    // channel is used in update()
+    m_parameterManager->lock();
+    m_valueChannel = channel;
+    m_parameterManager->unlock();
+}
+
 bool ParameterServer::update()
 {
     if (transporterList.empty())
@@ -187,119 +421,954 @@ bool ParameterServer::update()
         return false;
     }
 
+    if (isSenderRunning())
+    {
+        return _handOff();
+    }
+
     // protect lists to be used from multiple threads
     m_parameterManager->lock();
 
+    _collect(m_changes);
+    _sendChanges(m_changes);
+
+    // unlock mutex
+    m_parameterManager->unlock();
+
+    return false;
+}
+
+void ParameterServer::_collect(ChangeSet& changes)
+{
+    // NOTE: no locking needed, dirty and removed ids are atomic
+    changes.removed.clear();
+    changes.dirty.clear();
+
+    m_parameterManager->removedParameter.drain([&](int16_t id)
+    {
+        changes.removed.push_back(id);
+    });
+
+    m_parameterManager->dirtyParameter.drain([&](int16_t id)
+    {
+        changes.dirty.push_back(id);
+    });
+}
+
+void ParameterServer::_sendChanges(const ChangeSet& changes)
+{
+    // NOTE: called with locked manager
+
+    // collect packets into frames if enabled
+    BufferWriter writer;
+    BufferWriter value_writer;
+    auto send_frame = [this](const SharedBuffer& frame)
+    {
+        _emit(frame, nullptr);
+    };
+
+    // packets for some of the clients are not framed
+    auto send = [&](Packet& packet, const ConnectionList* excluded)
+    {
+        if (m_frame.enabled() &&
+            (!excluded || excluded->empty()))
+        {
+            writer.clear();
+            packet.write(writer, false);
+            m_frame.add(writer.data(), writer.size(), send_frame);
+        }
+        else
+        {
+            sendPacket(packet, nullptr, excluded);
+        }
+    };
+
+    // with subscriptions every change is sent to interested clients only
+    const bool filter = !m_subscriptions.empty();
+    const int connection_count = filter ? getConnectionCount() : 0;
+    ConnectionList excluded;
+
+    if (m_valueChannel)
+    {
+        // values lost on the channel are sent again below
+        _resync();
+    }
+
     // send removes
-    for (auto& p : m_parameterManager->removedParameter)
+    for (int16_t id : changes.removed)
     {
-        WriteablePtr id_data = IdData::create(p.second->getId());
+        _invalidateInitCache(id, nullptr);
+
+        WriteablePtr id_data = IdData::create(id);
         Packet packet(COMMAND_REMOVE, id_data);
-        sendPacket(packet);
+        send(packet, nullptr);
     }
-    m_parameterManager->removedParameter.clear();
 
     // send updates
-    for (auto& p : m_parameterManager->dirtyParameter)
+    ParameterManager::clock::time_point now = ParameterManager::clock::now();
+
+    for (int16_t id : changes.dirty)
     {
-        // TODO send COMMAND_UPDATEVALUE
+        const ParameterPtr& parameter = m_parameterManager->params.get(id);
+        if (!parameter)
+        {
+            continue;
+        }
+
+        const bool value_only = parameter->onlyValueChanged();
+
+        if (!m_parameterManager->_takeUpdate(parameter, !value_only, now))
+        {
+            // rate limited, sent by a later update
+            continue;
+        }
+
         command_t cmd = COMMAND_UPDATE;
 
-        if (p.second->onlyValueChanged())
+        // cached images follow what was sent,
+        // a held back change is patched in when it goes out
+        if (value_only)
         {
             cmd = COMMAND_UPDATEVALUE;
+            _patchInitCache(id);
+        }
+        else
+        {
+            _invalidateInitCache(id, parameter);
+        }
+
+        Packet packet(cmd);
+        packet.setData(parameter);
+
+        if (cmd == COMMAND_UPDATEVALUE &&
+            m_valueChannel)
+        {
+            value_writer.clear();
+            packet.write(value_writer, false);
+
+            if (m_valueChannel->add(id, value_writer.data(), value_writer.size()))
+            {
+                continue;
+            }
         }
 
-        Packet packet(cmd, p.second);
-        sendPacket(packet);
+        excluded.clear();
+        if (filter &&
+            !_audience(parameter, connection_count, excluded))
+        {
+            // nobody subscribed to it, not serialized
+            continue;
+        }
+
+        send(packet, &excluded);
     }
-    m_parameterManager->dirtyParameter.clear();
 
-    // unlock mutex
-    m_parameterManager->unlock();
+    m_frame.flush(send_frame);
 
-    return false;
+    if (m_valueChannel)
+    {
+        m_valueChannel->flush();
+    }
 }
 
-void ParameterServer::sendPacket(Packet& packet, void *id)
+
+//------------------------------------------------------------------
+// pipelined sending
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point start)
 {
-    if (transporterList.empty())
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now() - start).count());
+}
+
+static void addTime(std::atomic<uint64_t>& total, std::atomic<uint64_t>& max, uint64_t ns)
+{
+    // one writer per stage
+    total.store(total.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > max.load(std::memory_order_relaxed))
+    {
+        max.store(ns, std::memory_order_relaxed);
+    }
+}
+
+void ParameterServer::startSender(uint32_t tickMs)
+{
+    if (m_sender.joinable())
     {
         return;
     }
 
-    // serialize
-    StringStreamWriter writer;
-    packet.write(writer, false);
+    m_batches.reset(new SpscQueue<ChangeSet>(16));
+    m_spareBatches.reset(new SpscQueue<ChangeSet>(16));
+    m_senderTick = tickMs;
+    m_senderRunning.store(true, std::memory_order_release);
+
+    m_sender = std::thread([this, tickMs]() { _senderLoop(tickMs); });
+}
+
+void ParameterServer::stopSender()
+{
+    if (!m_sender.joinable())
+    {
+        return;
+    }
 
-    for (auto& transporterW : transporterList)
     {
-        transporterW.get().sendToAll(writer.getBuffer(), id);
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_senderRunning.store(false, std::memory_order_release);
     }
+    m_wake.notify_one();
+
+    // batches handed off before are sent
+    m_sender.join();
+
+    m_batches.reset();
+    m_spareBatches.reset();
 }
 
+ParameterServer::SenderStats ParameterServer::getSenderStats() const
+{
+    SenderStats stats;
+    stats.batches = m_statBatches.load(std::memory_order_relaxed);
+    stats.queueFull = m_statQueueFull.load(std::memory_order_relaxed);
+    stats.handOffNs = m_statHandOffNs.load(std::memory_order_relaxed);
+    stats.handOffMaxNs = m_statHandOffMaxNs.load(std::memory_order_relaxed);
+    stats.serializeNs = m_statSerializeNs.load(std::memory_order_relaxed);
+    stats.serializeMaxNs = m_statSerializeMaxNs.load(std::memory_order_relaxed);
+    stats.sendNs = m_statSendNs.load(std::memory_order_relaxed);
+    stats.sendMaxNs = m_statSendMaxNs.load(std::memory_order_relaxed);
+    return stats;
+}
 
-void ParameterServer::_sendParameterFull(ParameterPtr& parameter,
-                                         ServerTransporter& transporter,
-                                         void *id)
+bool ParameterServer::_handOff()
 {
+    if (m_senderTick > 0)
+    {
+        // collected by the sender
+        return false;
+    }
 
-    Packet packet(COMMAND_UPDATE);
-    packet.setData(parameter);
+    // the queues and m_changes take one producer.
+    // a concurrent update() returns, its changes stay in the dirty set
+    if (m_handingOff.exchange(true, std::memory_order_acquire))
+    {
+        return false;
+    }
 
-    // serialize
-    StringStreamWriter aWriter;
-    packet.write(aWriter, true);
+    _pushBatch();
 
-    transporter.sendToOne(aWriter.getBuffer(), id);
+    m_handingOff.store(false, std::memory_order_release);
 
-    if (parameter->getTypeDefinition().getDatatype() == DATATYPE_GROUP)
+    return false;
+}
+
+void ParameterServer::_pushBatch()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (m_batches->size() >= m_batches->capacity())
     {
-        std::shared_ptr<GroupParameter> group_param = std::dynamic_pointer_cast<GroupParameter>(parameter);
-        if (group_param)
-        {
-            for (auto& child : group_param->children())
-            {
-                _sendParameterFull(child.second, transporter, id);
-            }
-        }
+        // sender is behind, changes stay in the dirty set
+        m_statQueueFull.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // reuse vectors of a sent batch
+    if (m_changes.dirty.capacity() == 0)
+    {
+        m_spareBatches->pop(m_changes);
     }
-}
 
+    _collect(m_changes);
 
-void ParameterServer::_init(ServerTransporter& transporter, void *id)
-{
-    for (auto& child : m_parameterManager->rootGroup()->children())
+    if (m_changes.removed.empty() &&
+        m_changes.dirty.empty() &&
+        !m_valueChannel)
     {
-        _sendParameterFull(child.second, transporter, id);
+        // nothing to do
+        return;
     }
 
-    // send initialize to mark end of init
-    Packet packet(COMMAND_INITIALIZE);
-    StringStreamWriter aWriter;
-    packet.write(aWriter, true);
+    m_batches->push(std::move(m_changes));
+    m_statBatches.fetch_add(1, std::memory_order_relaxed);
+
+    // pairs with the fence in _senderLoop: either the sender sees
+    // the batch before waiting or we see it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_senderWaiting.load(std::memory_order_relaxed))
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wake.notify_one();
+    }
 
-    transporter.sendToOne(aWriter.getBuffer(), id);
+    addTime(m_statHandOffNs, m_statHandOffMaxNs, elapsedNs(start));
 }
 
-bool ParameterServer::_update(Packet& packet, ServerTransporter& /*transporter*/, void* /*id*/)
+void ParameterServer::_senderLoop(uint32_t tickMs)
 {
-    if (!packet.hasData())
-    {
-        std::cerr << "_update: packet has no data\n";
-        return false;
-    }
+    ChangeSet changes;
+    std::chrono::steady_clock::duration tick = std::chrono::milliseconds(tickMs);
+    std::chrono::steady_clock::time_point next_tick = std::chrono::steady_clock::now() + tick;
 
-    // assume this is a parameter!!
-    ParameterPtr param = std::dynamic_pointer_cast<IParameter>(packet.getData());
-    if (param)
+    while (true)
     {
-        ParameterPtr chached_param = m_parameterManager->getParameter(param->getId());
+        bool running = m_senderRunning.load(std::memory_order_acquire);
 
-        if (chached_param)
+        while (m_batches->pop(changes))
         {
-            // got it... update it
-            chached_param->update(param);
+            _process(changes);
+
+            // hand the vectors back, dropped if update() did not take them yet
+            m_spareBatches->push(std::move(changes));
+        }
+
+        if (tickMs > 0 &&
+            (!running || std::chrono::steady_clock::now() >= next_tick))
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            _collect(changes);
+            addTime(m_statHandOffNs, m_statHandOffMaxNs, elapsedNs(start));
+            m_statBatches.fetch_add(1, std::memory_order_relaxed);
+
+            _process(changes);
+
+            next_tick += tick;
+            if (next_tick < std::chrono::steady_clock::now())
+            {
+                // too slow for the tick, do not catch up
+                next_tick = std::chrono::steady_clock::now() + tick;
+            }
+        }
+
+        if (!running)
+        {
+            // last changes are sent
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+
+        m_senderWaiting.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        auto wake = [this]() {
+            return !m_batches->empty() ||
+                    !m_senderRunning.load(std::memory_order_acquire);
+        };
+
+        if (tickMs > 0)
+        {
+            m_wake.wait_until(lock, next_tick, wake);
+        }
+        else
+        {
+            m_wake.wait(lock, wake);
+        }
+
+        m_senderWaiting.store(false, std::memory_order_relaxed);
+    }
+}
+
+void ParameterServer::_process(ChangeSet& changes)
+{
+    std::vector<Outgoing> outgoing;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    m_parameterManager->lock();
+
+    m_outgoing = &outgoing;
+    _sendChanges(changes);
+    m_outgoing = nullptr;
+
+    m_parameterManager->unlock();
+
+    addTime(m_statSerializeNs, m_statSerializeMaxNs, elapsedNs(start));
+
+    // transporters are called without holding the manager,
+    // receiving is not blocked by sending
+    start = std::chrono::steady_clock::now();
+
+    for (const Outgoing& o : outgoing)
+    {
+        _sendTo(o.buffer, nullptr, &o.excluded);
+    }
+
+    addTime(m_statSendNs, m_statSendMaxNs, elapsedNs(start));
+}
+
+void ParameterServer::sendPacket(Packet& packet, void *id, const ConnectionList* excluded)
+{
+    if (transporterList.empty())
+    {
+        return;
+    }
+
+    // serialize once, share the buffer with all transporters
+    BufferWriter writer;
+    packet.write(writer, false);
+    SharedBuffer buffer = writer.share();
+
+    if (packet.getCommand() == COMMAND_UPDATEVALUE)
+    {
+        // a newer value of the parameter replaces this one
+        // in the queue of a slow connection
+        ParameterPtr parameter = std::dynamic_pointer_cast<IParameter>(packet.getData());
+        if (parameter)
+        {
+            buffer.setKey(parameter->getId());
+        }
+    }
+
+    _emit(buffer, id, excluded);
+}
+
+void ParameterServer::_emit(const SharedBuffer& buffer, void* id, const ConnectionList* excluded)
+{
+    if (m_outgoing &&
+        id == nullptr)
+    {
+        // sender thread: sent after unlocking the manager
+        m_outgoing->push_back(Outgoing());
+        m_outgoing->back().buffer = buffer;
+        if (excluded)
+        {
+            m_outgoing->back().excluded = *excluded;
+        }
+        return;
+    }
+
+    _sendTo(buffer, id, excluded);
+}
+
+void ParameterServer::_sendTo(const SharedBuffer& buffer, void* excludeId, const ConnectionList* excluded)
+{
+    for (auto& transporterW : transporterList)
+    {
+        ServerTransporter& transporter = transporterW.get();
+
+        if (!excluded ||
+            std::none_of(excluded->begin(), excluded->end(),
+                         [&transporter](const Connection& c) { return c.first == &transporter; }))
+        {
+            transporter.sendToAll(buffer, excludeId);
+            continue;
+        }
+
+        transporter.sendToSome(buffer, [&](void* id)
+        {
+            return id != excludeId &&
+                    std::find(excluded->begin(), excluded->end(), Connection(&transporter, id)) == excluded->end();
+        });
+    }
+}
+
+const SharedBuffer& ParameterServer::_parameterFull(const ParameterPtr& parameter, BufferWriter& writer)
+{
+    // cached full serialization
+    auto it = m_initCache.find(parameter->getId());
+    if (it != m_initCache.end())
+    {
+        if (it->second.parameter.lock() == parameter)
+        {
+            return it->second.buffer;
+        }
+
+        // id was reused by another parameter
+        m_initCache.erase(it);
+    }
+
+    Packet packet(COMMAND_UPDATE);
+    packet.setData(parameter);
+
+    writer.clear();
+    packet.write(writer, true);
+
+    InitCacheEntry& entry = m_initCache[parameter->getId()];
+    entry.parameter = parameter;
+    entry.buffer = SharedBuffer(writer.data(), writer.size());
+
+    return entry.buffer;
+}
+
+void ParameterServer::_snapshotParameter(const ParameterPtr& parameter,
+                                         Snapshot& snapshot,
+                                         BufferWriter& writer)
+{
+    snapshot.slots[parameter->getId()] = snapshot.packets.size();
+    snapshot.packets.push_back(_parameterFull(parameter, writer));
+
+    if (parameter->getTypeDefinition().getDatatype() == DATATYPE_GROUP)
+    {
+        std::shared_ptr<GroupParameter> group_param = std::dynamic_pointer_cast<GroupParameter>(parameter);
+        if (group_param)
+        {
+            for (auto& child : group_param->children())
+            {
+                _snapshotParameter(child.second, snapshot, writer);
+            }
+        }
+    }
+}
+
+// combine packets into frames
+static void packFrames(std::vector<SharedBuffer>& packets, size_t maxFrameSize)
+{
+    std::vector<SharedBuffer> frames;
+    FrameBuilder frame(maxFrameSize);
+    auto add_frame = [&frames](const SharedBuffer& f) { frames.push_back(f); };
+
+    for (const SharedBuffer& p : packets)
+    {
+        frame.add(p.data(), p.size(), add_frame);
+    }
+    frame.flush(add_frame);
+
+    packets.swap(frames);
+}
+
+std::shared_ptr<const std::vector<SharedBuffer> > ParameterServer::_initSnapshot()
+{
+    // NOTE: called with locked manager
+
+    if (m_initSnapshot.packets.empty())
+    {
+        BufferWriter writer;
+
+        for (auto& child : m_parameterManager->rootGroup()->children())
+        {
+            _snapshotParameter(child.second, m_initSnapshot, writer);
+        }
+
+        // initialize marks end of init
+        Packet packet(COMMAND_INITIALIZE);
+        writer.clear();
+        packet.write(writer, true);
+        m_initSnapshot.packets.push_back(SharedBuffer(writer.data(), writer.size()));
+    }
+
+    return _snapshotFrames(m_initSnapshot);
+}
+
+std::shared_ptr<const std::vector<SharedBuffer> > ParameterServer::_snapshotFrames(Snapshot& snapshot)
+{
+    // NOTE: called with locked manager
+
+    if (snapshot.frames)
+    {
+        // still valid
+        return snapshot.frames;
+    }
+
+    if (!snapshot.stale.empty())
+    {
+        // serialize changed values only
+        BufferWriter writer;
+
+        for (int16_t id : snapshot.stale)
+        {
+            const ParameterPtr& parameter = m_parameterManager->params.get(id);
+            if (parameter)
+            {
+                snapshot.packets[snapshot.slots[id]] = _parameterFull(parameter, writer);
+            }
+        }
+
+        snapshot.stale.clear();
+    }
+
+    // copy, clients might still send the previous frames
+    std::vector<SharedBuffer> packets(snapshot.packets);
+
+    if (m_maxFrameSize > 0)
+    {
+        packFrames(packets, m_maxFrameSize);
+    }
+
+    snapshot.frames = std::make_shared<const std::vector<SharedBuffer> >(std::move(packets));
+    return snapshot.frames;
+}
+
+void ParameterServer::_patchInitCache(int16_t id)
+{
+    // NOTE: called with locked manager
+
+    m_initCache.erase(id);
+
+    if (!m_initSnapshot.packets.empty() &&
+        m_initSnapshot.slots.find(id) == m_initSnapshot.slots.end())
+    {
+        // not part of the snapshot yet
+        _invalidateInitCache(id, m_parameterManager->params.get(id));
+        return;
+    }
+
+    // serialized again when a snapshot is requested
+    auto mark_stale = [id](Snapshot& snapshot)
+    {
+        if (snapshot.slots.find(id) != snapshot.slots.end())
+        {
+            snapshot.stale.insert(id);
+            snapshot.frames.reset();
+        }
+    };
+
+    mark_stale(m_initSnapshot);
+    mark_stale(m_topLevelSnapshot);
+
+    for (auto& kv : m_discoverCache)
+    {
+        mark_stale(kv.second);
+    }
+}
+
+void ParameterServer::_invalidateInitCache(int16_t id, const ParameterPtr& parameter)
+{
+    // NOTE: called with locked manager
+
+    m_initCache.erase(id);
+    m_initSnapshot = Snapshot();
+    m_topLevelSnapshot = Snapshot();
+
+    // only subtrees containing the parameter or its (new) parent
+    const int16_t root_id = m_parameterManager->rootGroup()->getId();
+    int16_t parent_id = root_id;
+    if (parameter)
+    {
+        GroupParameterPtr parent = parameter->getParent().lock();
+        if (parent)
+        {
+            parent_id = parent->getId();
+        }
+    }
+
+    for (auto it = m_discoverCache.begin(); it != m_discoverCache.end();)
+    {
+        const Snapshot& snapshot = it->second;
+
+        if (it->first == root_id ||
+            it->first == id ||
+            it->first == parent_id ||
+            snapshot.slots.find(id) != snapshot.slots.end() ||
+            snapshot.slots.find(parent_id) != snapshot.slots.end())
+        {
+            it = m_discoverCache.erase(it);
+        }
+        else
+        {
+            it++;
+        }
+    }
+}
+
+void ParameterServer::_resync()
+{
+    // NOTE: called with locked manager
+
+    bool all = false;
+    m_resyncIds.clear();
+    m_valueChannel->takeResync(m_resyncIds, all);
+
+    if (!all &&
+        m_resyncIds.empty())
+    {
+        return;
+    }
+
+    // the value is written even if it did not change since the last update
+    BufferWriter writer;
+    auto resend = [&](const ParameterPtr& parameter)
+    {
+        datatype_t type = parameter->getDatatype();
+        if (type == DATATYPE_GROUP ||
+            type == DATATYPE_BANG)
+        {
+            // no value, a bang is not triggered again
+            return;
+        }
+
+        Packet packet(COMMAND_UPDATEVALUE);
+        packet.setData(parameter);
+
+        writer.clear();
+        packet.write(writer, false);
+
+        if (!m_valueChannel->add(parameter->getId(), writer.data(), writer.size()))
+        {
+            sendPacket(packet);
+        }
+    };
+
+    if (all)
+    {
+        for (const ParameterPtr& parameter : m_parameterManager->params)
+        {
+            resend(parameter);
+        }
+        return;
+    }
+
+    std::sort(m_resyncIds.begin(), m_resyncIds.end());
+    m_resyncIds.erase(std::unique(m_resyncIds.begin(), m_resyncIds.end()), m_resyncIds.end());
+
+    for (int16_t id : m_resyncIds)
+    {
+        const ParameterPtr& parameter = m_parameterManager->params.get(id);
+        if (parameter)
+        {
+            resend(parameter);
+        }
+    }
+}
+
+void ParameterServer::_init(ServerTransporter& transporter, void *id)
+{
+    // all clients initializing before the next change share the same snapshot
+    m_parameterManager->lock();
+    std::shared_ptr<const std::vector<SharedBuffer> > snapshot = _initSnapshot();
+    m_parameterManager->unlock();
+
+    for (const SharedBuffer& buffer : *snapshot)
+    {
+        transporter.sendToOne(buffer, id);
+    }
+}
+
+void ParameterServer::_subscribe(Packet& packet, ServerTransporter& transporter, void* id)
+{
+    // NOTE: called with locked manager
+
+    SubscriptionDataPtr subscription;
+    if (packet.hasData())
+    {
+        subscription = std::dynamic_pointer_cast<SubscriptionData>(packet.getData());
+    }
+
+    Connection connection(&transporter, id);
+
+    if (!subscription ||
+        subscription->empty())
+    {
+        // everything
+        m_subscriptions.erase(connection);
+        _init(transporter, id);
+        return;
+    }
+
+    m_subscriptions[connection] = subscription;
+
+    // init with the subscribed parameters
+    std::vector<SharedBuffer> packets;
+    BufferWriter writer;
+
+    for (auto& child : m_parameterManager->rootGroup()->children())
+    {
+        _snapshotSubscribed(child.second, *subscription, packets, writer);
+    }
+
+    Packet init_packet(COMMAND_INITIALIZE);
+    writer.clear();
+    init_packet.write(writer, true);
+    packets.push_back(SharedBuffer(writer.data(), writer.size()));
+
+    if (m_maxFrameSize > 0)
+    {
+        packFrames(packets, m_maxFrameSize);
+    }
+
+    for (const SharedBuffer& buffer : packets)
+    {
+        transporter.sendToOne(buffer, id);
+    }
+}
+
+void ParameterServer::_snapshotSubscribed(const ParameterPtr& parameter,
+                                          const SubscriptionData& subscription,
+                                          std::vector<SharedBuffer>& packets,
+                                          BufferWriter& writer)
+{
+    if (parameter->getTypeDefinition().getDatatype() != DATATYPE_GROUP)
+    {
+        if (subscription.matches(parameter))
+        {
+            packets.push_back(_parameterFull(parameter, writer));
+        }
+        return;
+    }
+
+    packets.push_back(_parameterFull(parameter, writer));
+
+    std::shared_ptr<GroupParameter> group_param = std::dynamic_pointer_cast<GroupParameter>(parameter);
+    if (group_param)
+    {
+        for (auto& child : group_param->children())
+        {
+            _snapshotSubscribed(child.second, subscription, packets, writer);
+        }
+    }
+}
+
+bool ParameterServer::_audience(const ParameterPtr& parameter, int connectionCount, ConnectionList& excluded)
+{
+    // NOTE: called with locked manager
+    for (const auto& kv : m_subscriptions)
+    {
+        if (!kv.second->matches(parameter))
+        {
+            excluded.push_back(kv.first);
+        }
+    }
+
+    return static_cast<int>(excluded.size()) < connectionCount;
+}
+
+void ParameterServer::_discover(Packet& packet, ServerTransporter& transporter, void* id)
+{
+    // NOTE: called with locked manager
+
+    IdDataPtr id_data;
+    if (packet.hasData())
+    {
+        id_data = std::dynamic_pointer_cast<IdData>(packet.getData());
+    }
+
+    Connection connection(&transporter, id);
+    std::shared_ptr<const std::vector<SharedBuffer> > snapshot;
+
+    if (!id_data)
+    {
+        // init with the top level, changes of undiscovered groups are not sent
+        SubscriptionDataPtr interest = std::make_shared<SubscriptionData>();
+        interest->setLazy(true);
+        m_subscriptions[connection] = interest;
+
+        snapshot = _topLevelSnapshot();
+    }
+    else
+    {
+        auto it = m_subscriptions.find(connection);
+        if (it != m_subscriptions.end() &&
+            it->second->isLazy())
+        {
+            it->second->addGroup(id_data->getId());
+        }
+
+        snapshot = _discoverSnapshot(id_data->getId());
+    }
+
+    for (const SharedBuffer& buffer : *snapshot)
+    {
+        transporter.sendToOne(buffer, id);
+    }
+}
+
+std::shared_ptr<const std::vector<SharedBuffer> > ParameterServer::_topLevelSnapshot()
+{
+    // NOTE: called with locked manager
+
+    Snapshot& snapshot = m_topLevelSnapshot;
+
+    if (snapshot.packets.empty())
+    {
+        BufferWriter writer;
+
+        for (auto& child : m_parameterManager->rootGroup()->children())
+        {
+            snapshot.slots[child.second->getId()] = snapshot.packets.size();
+            snapshot.packets.push_back(_parameterFull(child.second, writer));
+        }
+
+        // initialize marks end of init
+        Packet packet(COMMAND_INITIALIZE);
+        writer.clear();
+        packet.write(writer, true);
+        snapshot.packets.push_back(SharedBuffer(writer.data(), writer.size()));
+    }
+
+    return _snapshotFrames(snapshot);
+}
+
+std::shared_ptr<const std::vector<SharedBuffer> > ParameterServer::_discoverSnapshot(int16_t id)
+{
+    // NOTE: called with locked manager
+
+    auto it = m_discoverCache.find(id);
+    if (it != m_discoverCache.end())
+    {
+        return _snapshotFrames(it->second);
+    }
+
+    Snapshot& snapshot = m_discoverCache[id];
+    BufferWriter writer;
+    GroupParameterPtr root = m_parameterManager->rootGroup();
+
+    if (id == root->getId())
+    {
+        for (auto& child : root->children())
+        {
+            _snapshotParameter(child.second, snapshot, writer);
+        }
+    }
+    else
+    {
+        ParameterPtr parameter = m_parameterManager->params.get(id);
+        if (parameter)
+        {
+            // parents first, the client might not know them yet
+            std::vector<ParameterPtr> path;
+            for (GroupParameterPtr group = parameter->getParent().lock();
+                 group && group != root;
+                 group = group->getParent().lock())
+            {
+                path.push_back(group);
+            }
+
+            for (auto p = path.rbegin(); p != path.rend(); p++)
+            {
+                snapshot.slots[(*p)->getId()] = snapshot.packets.size();
+                snapshot.packets.push_back(_parameterFull(*p, writer));
+            }
+
+            _snapshotParameter(parameter, snapshot, writer);
+        }
+    }
+
+    // discover marks the end of the subtree, unknown ids get it too
+    WriteablePtr id_data = IdData::create(id);
+    Packet packet(COMMAND_DISCOVER, id_data);
+    writer.clear();
+    packet.write(writer, true);
+    snapshot.packets.push_back(SharedBuffer(writer.data(), writer.size()));
+
+    return _snapshotFrames(snapshot);
+}
+
+bool ParameterServer::_update(Packet& packet, ServerTransporter& /*transporter*/, void* /*id*/)
+{
+    if (!packet.hasData())
+    {
+        std::cerr << "_update: packet has no data\n";
+        return false;
+    }
+
+    // assume this is a parameter!!
+    ParameterPtr param = std::dynamic_pointer_cast<IParameter>(packet.getData());
+    if (param)
+    {
+        ParameterPtr chached_param = m_parameterManager->getParameter(param->getId());
+
+        if (chached_param)
+        {
+            // got it... update it
+            chached_param->update(param);
+
+            if (chached_param->onlyValueChanged())
+            {
+                _patchInitCache(chached_param->getId());
+            }
+            else
+            {
+                _invalidateInitCache(chached_param->getId(), chached_param);
+            }
 
             // call updateParameter callbacks
         }
@@ -339,15 +1408,15 @@ void ParameterServer::_version(Packet& packet, ServerTransporter& transporter, v
         // no data, respond with version
         WriteablePtr version = InfoData::create(RCP_SPECIFICATION_VERSION, m_applicationId);
         Packet resp_packet(COMMAND_INFO, version);
-        StringStreamWriter writer;
+        BufferWriter writer;
         resp_packet.write(writer, false);
-        transporter.sendToOne(writer.getBuffer(), id);
+        transporter.sendToOne(writer.data(), writer.size(), id);
 
         // ask for version
-        StringStreamWriter writer1;
+        writer.clear();
         Packet req_info_packet(COMMAND_INFO);
-        req_info_packet.write(writer1, false);
-        transporter.sendToOne(writer1.getBuffer(), id);
+        req_info_packet.write(writer, false);
+        transporter.sendToOne(writer.data(), writer.size(), id);
     }
 }
 
@@ -18,11 +18,23 @@
 #ifndef RCPSERVER_H
 #define RCPSERVER_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "servertransporter.h"
 #include "parametermanager.h"
 #include "rcp_error_listener.h"
+#include "framebuilder.h"
+#include "spscqueue.h"
+#include "subscriptiondata.h"
+#include "valuechannel.h"
 
 namespace rcp {
 
@@ -56,11 +68,80 @@ public:
     void addListener(ParameterServerListener* listener);
     void removeListener(ParameterServerListener* listener);
 
+    // send all changes since the last update()
+    // with a running sender only the changed ids are handed to it
     virtual bool update();
 
+    // pipelined sending: a sender thread serializes and sends changes.
+    // update() collects the changed ids without locking the parameter
+    // manager and passes them to the sender through a lock-free queue.
+    // if the sender is behind, update() returns right away and the
+    // changes are sent with the next batch.
+    // update() may be called from several threads, while one of them
+    // hands off the others return and leave their changes for the next.
+    // tickMs > 0: the sender collects changes itself every tickMs,
+    // update() does nothing then.
+    // do not add or remove transporters while the sender runs.
+    void startSender(uint32_t tickMs = 0);
+    void stopSender();
+    bool isSenderRunning() const { return m_senderRunning.load(std::memory_order_acquire); }
+
+    struct SenderStats
+    {
+        // batches handed to the sender
+        uint64_t batches{0};
+        // update() calls finding the queue full
+        uint64_t queueFull{0};
+        // nanoseconds per stage, total and longest single run
+        // handOff: collecting ids in update() (or on the tick)
+        // serialize: writing packets with the manager locked
+        // send: passing buffers to the transporters
+        uint64_t handOffNs{0};
+        uint64_t handOffMaxNs{0};
+        uint64_t serializeNs{0};
+        uint64_t serializeMaxNs{0};
+        uint64_t sendNs{0};
+        uint64_t sendMaxNs{0};
+    };
+    SenderStats getSenderStats() const;
+
+    // pack all packets of one update() into frames of max size bytes
+    // receivers of this library split frames, other receivers might not
+    // 0: one packet per send (default)
+    void setMaxFrameSize(size_t size);
+    size_t getMaxFrameSize() const { return m_maxFrameSize; }
+
+    // clients sending COMMAND_SUBSCRIBE only get changes of parameters
+    // matching their SubscriptionData, other clients get all changes.
+    // changes nobody subscribed to are not serialized at all.
+    // with frames enabled, packets not going to all clients are sent unframed.
+    // changes of clients are forwarded to the other clients by the same
+    // rules, one packet at a time.
+    // not filtered: removes and the value channel
+    // clients discovering the tree (COMMAND_DISCOVER without data) get
+    // the top level parameters on init and the subtree of a group when
+    // they discover it. they only get changes of the parts they know
+    // and count as subscribed.
+    size_t getSubscriptionCount() const;
+
+    // send UPDATEVALUE packets of update() through channel
+    // structural packets and forwarded client packets stay on the transporters
+    // nullptr: transporters only (default)
+    void setValueChannel(ValueChannel* channel);
+    ValueChannel* getValueChannel() const { return m_valueChannel; }
+
 public:
     // ServerTransporterReceiver
-    void received(std::istream& data, ServerTransporter& transporter, void* id);
+    void received(std::istream& data, ServerTransporter& transporter, void* id) override;
+    void received(const char* data, size_t size, ServerTransporter& transporter, void* id) override;
+    void clientConnected(ServerTransporter& transporter, void* id) override;
+    void clientDisconnected(ServerTransporter& transporter, void* id) override;
+
+    // apply all packets of data in order, the parameter manager is locked once.
+    // a broken packet is reported to the parsing error listeners
+    // and skipped if its end can be found
+    // returns the number of applied packets
+    size_t receivePackets(const char* data, size_t size, ServerTransporter& transporter, void* id);
 
 public:
     GroupParameterPtr getRoot() const { return m_parameterManager->rootGroup(); }
@@ -69,6 +150,24 @@ public:
         return m_parameterManager->getParameter(id);
     }
 
+    // limit updates of a parameter or of all parameters in a group
+    // see ParameterManager::setMaxUpdateRate
+    void setMaxUpdateRate(int16_t id, float hz) {
+        m_parameterManager->setMaxUpdateRate(id, hz);
+    }
+    float getMaxUpdateRate(int16_t id) const {
+        return m_parameterManager->getMaxUpdateRate(id);
+    }
+
+    // reserve ids before creating many parameters
+    // ids not used stay allocated until releaseReservedIds()
+    size_t reserveIds(size_t count) {
+        return m_parameterManager->reserveIds(count);
+    }
+    void releaseReservedIds() {
+        m_parameterManager->releaseReservedIds();
+    }
+
     //
     void removeParameter(ParameterPtr parameter) {
         m_parameterManager->removeParameter(parameter);
@@ -184,11 +283,71 @@ protected:
     std::vector<std::reference_wrapper<ServerTransporter> > transporterList;
 
 private:
+    bool _receivedPacket(ByteReader& reader, ServerTransporter& transporter, void* id, bool& forward);
+    void _forward(const char* data, size_t size, void* id);
+    void _forwardSubscribed(const char* data, size_t size, void* id);
+    void _packetError(const PacketError& error);
     void _init(ServerTransporter& transporter, void *id);
     bool _update(Packet& Packet, ServerTransporter& transporter, void *id);
     void _version(Packet& packet, ServerTransporter& transporter, void *id);
-    void _sendParameterFull(ParameterPtr& parameter, ServerTransporter& transporter, void *id);
-    void sendPacket(Packet& packet, void *id=nullptr);
+    // connections to leave out when sending to all
+    typedef std::pair<ServerTransporter*, void*> Connection;
+    typedef std::vector<Connection> ConnectionList;
+
+    void sendPacket(Packet& packet, void *id=nullptr, const ConnectionList* excluded=nullptr);
+    void _emit(const SharedBuffer& buffer, void* id, const ConnectionList* excluded=nullptr);
+    void _sendTo(const SharedBuffer& buffer, void* excludeId, const ConnectionList* excluded);
+
+    // subscriptions
+    void _subscribe(Packet& packet, ServerTransporter& transporter, void* id);
+    void _snapshotSubscribed(const ParameterPtr& parameter, const SubscriptionData& subscription,
+                             std::vector<SharedBuffer>& packets, BufferWriter& writer);
+    // fills excluded with subscribed connections not matching parameter
+    // returns false if no connection wants it
+    bool _audience(const ParameterPtr& parameter, int connectionCount, ConnectionList& excluded);
+
+    // discovery
+    void _discover(Packet& packet, ServerTransporter& transporter, void* id);
+    std::shared_ptr<const std::vector<SharedBuffer> > _topLevelSnapshot();
+    std::shared_ptr<const std::vector<SharedBuffer> > _discoverSnapshot(int16_t id);
+
+    // ids changed since the last update
+    struct ChangeSet
+    {
+        std::vector<int16_t> removed;
+        std::vector<int16_t> dirty;
+    };
+    void _collect(ChangeSet& changes);
+    void _sendChanges(const ChangeSet& changes);
+
+    // sender thread
+    bool _handOff();
+    void _pushBatch();
+    void _senderLoop(uint32_t tickMs);
+    void _process(ChangeSet& changes);
+
+    // packets of a cached snapshot
+    // a value change only replaces the slot of its parameter
+    struct Snapshot
+    {
+        std::vector<SharedBuffer> packets;
+        std::unordered_map<int16_t, size_t> slots;
+        std::unordered_set<int16_t> stale;
+        // packets (or frames) handed out, rebuilt after a change
+        std::shared_ptr<const std::vector<SharedBuffer> > frames;
+    };
+
+    // init snapshot
+    const SharedBuffer& _parameterFull(const ParameterPtr& parameter, BufferWriter& writer);
+    void _snapshotParameter(const ParameterPtr& parameter, Snapshot& snapshot, BufferWriter& writer);
+    std::shared_ptr<const std::vector<SharedBuffer> > _snapshotFrames(Snapshot& snapshot);
+    std::shared_ptr<const std::vector<SharedBuffer> > _initSnapshot();
+    // value change: patch the slots of id
+    void _patchInitCache(int16_t id);
+    // structure or option change: drop snapshots containing id
+    // parameter is null if it was removed
+    void _invalidateInitCache(int16_t id, const ParameterPtr& parameter);
+    void _resync();
 
     std::string m_applicationId;
     //    Events:
@@ -196,6 +355,61 @@ private:
     //    onError(Exception ex);
 
     std::vector<ParameterServerListener*> m_listener;
+
+    size_t m_maxFrameSize{0};
+    FrameBuilder m_frame;
+
+    ValueChannel* m_valueChannel{nullptr};
+    std::vector<int16_t> m_resyncIds;
+
+    // full serialization per parameter, invalidated on change
+    struct InitCacheEntry
+    {
+        std::weak_ptr<IParameter> parameter;
+        SharedBuffer buffer;
+    };
+    std::unordered_map<int16_t, InitCacheEntry> m_initCache;
+    // packets sent on INITIALIZE
+    Snapshot m_initSnapshot;
+
+    // packets sent on DISCOVER
+    Snapshot m_topLevelSnapshot;
+    std::unordered_map<int16_t, Snapshot> m_discoverCache;
+
+    // interest of subscribed connections
+    std::map<Connection, SubscriptionDataPtr> m_subscriptions;
+
+    ChangeSet m_changes;
+
+    // pipelined sending
+    // update() to sender, and back to reuse the vectors
+    std::unique_ptr<SpscQueue<ChangeSet> > m_batches;
+    std::unique_ptr<SpscQueue<ChangeSet> > m_spareBatches;
+    std::thread m_sender;
+    std::atomic<bool> m_senderRunning{false};
+    uint32_t m_senderTick{0};
+    // set while one update() hands off
+    std::atomic<bool> m_handingOff{false};
+    // set while the sender waits, update() only wakes it then
+    std::atomic<bool> m_senderWaiting{false};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    // buffers of the batch in progress, sent after unlocking the manager
+    struct Outgoing
+    {
+        SharedBuffer buffer;
+        ConnectionList excluded;
+    };
+    std::vector<Outgoing>* m_outgoing{nullptr};
+
+    std::atomic<uint64_t> m_statBatches{0};
+    std::atomic<uint64_t> m_statQueueFull{0};
+    std::atomic<uint64_t> m_statHandOffNs{0};
+    std::atomic<uint64_t> m_statHandOffMaxNs{0};
+    std::atomic<uint64_t> m_statSerializeNs{0};
+    std::atomic<uint64_t> m_statSerializeMaxNs{0};
+    std::atomic<uint64_t> m_statSendNs{0};
+    std::atomic<uint64_t> m_statSendMaxNs{0};
 };
 
 }
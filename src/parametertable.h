@@ -0,0 +1,228 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_PARAMETERTABLE_H
+#define RCP_PARAMETERTABLE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <iterator>
+
+#include "iparameter.h"
+
+namespace rcp {
+
+/*
+* ParameterTable - parameters directly indexed by id
+*
+* 256 pages with 256 slots each, pages are allocated on first use
+* and released when empty, so a sparse table stays small.
+* iteration is in id order (same order as std::map<int16_t, ...>).
+*/
+class ParameterTable
+{
+public:
+    static const size_t PAGE_SIZE = 256;
+    static const size_t PAGE_COUNT = 256;
+
+private:
+    struct Page
+    {
+        ParameterPtr slots[PAGE_SIZE];
+        size_t count{0};
+    };
+
+    // pages in signed id order: -32768..-1, 0..32767
+    static size_t pageIndex(size_t order) { return (order + PAGE_COUNT / 2) % PAGE_COUNT; }
+    static size_t pageOf(int16_t id) { return static_cast<uint16_t>(id) / PAGE_SIZE; }
+    static size_t slotOf(int16_t id) { return static_cast<uint16_t>(id) % PAGE_SIZE; }
+
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef ParameterPtr value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const ParameterPtr* pointer;
+        typedef const ParameterPtr& reference;
+
+        const_iterator(const ParameterTable* table, size_t order, size_t slot)
+            : m_table(table)
+            , m_order(order)
+            , m_slot(slot)
+        {
+            seek();
+        }
+
+        reference operator*() const { return m_table->m_pages[pageIndex(m_order)]->slots[m_slot]; }
+        pointer operator->() const { return &(**this); }
+
+        const_iterator& operator++()
+        {
+            m_slot++;
+            seek();
+            return *this;
+        }
+
+        const_iterator operator++(int)
+        {
+            const_iterator tmp = *this;
+            ++(*this);
+            return tmp;
+        }
+
+        bool operator==(const const_iterator& other) const { return m_order == other.m_order && m_slot == other.m_slot; }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        // move to next used slot starting at current position
+        void seek()
+        {
+            while (m_order < PAGE_COUNT)
+            {
+                const Page* page = m_table->m_pages[pageIndex(m_order)].get();
+
+                if (page && page->count > 0)
+                {
+                    while (m_slot < PAGE_SIZE)
+                    {
+                        if (page->slots[m_slot])
+                        {
+                            return;
+                        }
+                        m_slot++;
+                    }
+                }
+
+                m_order++;
+                m_slot = 0;
+            }
+        }
+
+        const ParameterTable* m_table;
+        size_t m_order;
+        size_t m_slot;
+    };
+
+public:
+    ParameterTable() {}
+
+    ParameterTable(const ParameterTable&) = delete;
+    ParameterTable& operator=(const ParameterTable&) = delete;
+
+    const ParameterPtr& get(int16_t id) const
+    {
+        const Page* page = m_pages[pageOf(id)].get();
+        if (page)
+        {
+            return page->slots[slotOf(id)];
+        }
+
+        return nullParameter();
+    }
+
+    bool contains(int16_t id) const
+    {
+        return get(id) != nullptr;
+    }
+
+    // returns true if id was not set before
+    bool set(int16_t id, const ParameterPtr& parameter)
+    {
+        if (!parameter)
+        {
+            return erase(id);
+        }
+
+        std::unique_ptr<Page>& page = m_pages[pageOf(id)];
+        if (!page)
+        {
+            page.reset(new Page());
+        }
+
+        ParameterPtr& slot = page->slots[slotOf(id)];
+        bool added = (slot == nullptr);
+
+        slot = parameter;
+
+        if (added)
+        {
+            page->count++;
+            m_size++;
+        }
+
+        return added;
+    }
+
+    // returns true if id was set
+    bool erase(int16_t id)
+    {
+        std::unique_ptr<Page>& page = m_pages[pageOf(id)];
+        if (!page)
+        {
+            return false;
+        }
+
+        ParameterPtr& slot = page->slots[slotOf(id)];
+        if (!slot)
+        {
+            return false;
+        }
+
+        slot.reset();
+        page->count--;
+        m_size--;
+
+        if (page->count == 0)
+        {
+            page.reset();
+        }
+
+        return true;
+    }
+
+    void clear()
+    {
+        for (auto& page : m_pages)
+        {
+            page.reset();
+        }
+        m_size = 0;
+    }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, PAGE_COUNT, 0); }
+
+private:
+    static const ParameterPtr& nullParameter()
+    {
+        static const ParameterPtr null_parameter;
+        return null_parameter;
+    }
+
+    std::unique_ptr<Page> m_pages[PAGE_COUNT];
+    size_t m_size{0};
+};
+
+}
+
+#endif // RCP_PARAMETERTABLE_H
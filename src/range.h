@@ -22,6 +22,8 @@
 #include <string>
 #include <type_traits>
 
+#include "bytereader.h"
+
 namespace rcp {
 
 template <class T,
@@ -85,10 +87,12 @@ private:
 
 template <typename T,
          typename = std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value > >
-Range<T> readFromStream(std::istream& is, const Range<T>& /*i*/)
+Range<T> readFromStream(ByteReader& is, const Range<T>& /*i*/)
 {
-    T v1 = readFromStream(is, v1);
-    T v2 = readFromStream(is, v2);
+    T v1{};
+    v1 = readFromStream(is, v1);
+    T v2{};
+    v2 = readFromStream(is, v2);
 
     return Range<T>(v1, v2);
 }
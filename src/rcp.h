@@ -30,6 +30,9 @@
 #include "parameterfactory.h"
 
 #include "stringstreamwriter.h"
+#include "bufferwriter.h"
+#include "sharedbuffer.h"
+#include "bytereader.h"
 
 #include "parametermanager.h"
 #include "parameterserver.h"
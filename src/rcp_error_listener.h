@@ -18,12 +18,34 @@
 #ifndef RCP_ERROR_LISTENER_H
 #define RCP_ERROR_LISTENER_H
 
+#include <cstddef>
+
 namespace rcp {
 
+/*
+* PacketError - packet of a received buffer that could not be parsed
+*
+* the other packets of the buffer are applied, as long as the end
+* of the broken packet can be found.
+*/
+struct PacketError
+{
+    // position of the packet in the received buffer
+    size_t index;
+    size_t offset;
+    // bytes of the packet, 0 if its end could not be found.
+    // the rest of the buffer is dropped then
+    size_t size;
+    // first byte of the packet
+    int command;
+};
+
 class ParsingErrorListener
 {
 public:
     virtual void parsingError() = 0;
+    // called after parsingError() with details
+    virtual void packetError(const PacketError& /*error*/) {}
 };
 
 }
@@ -18,8 +18,14 @@
 #ifndef SERVERTRANSPORTER_H
 #define SERVERTRANSPORTER_H
 
+#include <functional>
 #include <map>
 #include <istream>
+#include <iterator>
+#include <vector>
+
+#include "memorystream.h"
+#include "sharedbuffer.h"
 
 namespace rcp {
 
@@ -29,6 +35,18 @@ class ServerTransporterReceiver
 {
 public:
     virtual void received(std::istream& data, ServerTransporter& transporter, void* id) = 0;
+
+    // receive a block of memory
+    // default: wrap the memory into a stream without copying
+    virtual void received(const char* data, size_t size, ServerTransporter& transporter, void* id)
+    {
+        MemoryInputStream stream(data, size);
+        received(stream, transporter, id);
+    }
+
+    // connection notifications from transporters tracking connections
+    virtual void clientConnected(ServerTransporter& /*transporter*/, void* /*id*/) {}
+    virtual void clientDisconnected(ServerTransporter& /*transporter*/, void* /*id*/) {}
 };
 
 
@@ -38,8 +56,39 @@ public:
     virtual void bind(int port) = 0;
     virtual void unbind() = 0;
 
-    virtual void sendToOne(std::istream& data, void* id) = 0;
-    virtual void sendToAll(std::istream& data, void* excludeId) = 0;
+    virtual void sendToOne(const char* data, size_t size, void* id) = 0;
+    virtual void sendToAll(const char* data, size_t size, void* excludeId) = 0;
+
+    // refcounted buffers
+    // transporters queueing data can keep a reference instead of copying
+    virtual void sendToOne(const SharedBuffer& buffer, void* id)
+    {
+        sendToOne(buffer.data(), buffer.size(), id);
+    }
+    virtual void sendToAll(const SharedBuffer& buffer, void* excludeId)
+    {
+        sendToAll(buffer.data(), buffer.size(), excludeId);
+    }
+
+    // send to connections filter returns true for
+    // filter is called while sending, for every connection
+    // default: transporters not listing their connections send to all
+    virtual void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& /*filter*/)
+    {
+        sendToAll(buffer, nullptr);
+    }
+
+    // stream adapters
+    virtual void sendToOne(std::istream& data, void* id)
+    {
+        std::vector<char> buffer = readAll(data);
+        sendToOne(buffer.data(), buffer.size(), id);
+    }
+    virtual void sendToAll(std::istream& data, void* excludeId)
+    {
+        std::vector<char> buffer = readAll(data);
+        sendToAll(buffer.data(), buffer.size(), excludeId);
+    }
 
     virtual int getConnectionCount() = 0;
 
@@ -58,6 +107,29 @@ protected:
         }
     }
 
+    void _received(const char* data, size_t size, void* client) {
+        for (const auto& kv : receive_cb) {
+            kv.first->received(data, size, *this, client);
+        }
+    }
+
+    void _clientConnected(void* client) {
+        for (const auto& kv : receive_cb) {
+            kv.first->clientConnected(*this, client);
+        }
+    }
+
+    void _clientDisconnected(void* client) {
+        for (const auto& kv : receive_cb) {
+            kv.first->clientDisconnected(*this, client);
+        }
+    }
+
+    static std::vector<char> readAll(std::istream& in) {
+        return std::vector<char>(std::istreambuf_iterator<char>(in),
+                                 std::istreambuf_iterator<char>());
+    }
+
     std::map<ServerTransporterReceiver*, void(ServerTransporterReceiver::*)(std::istream&, ServerTransporter&, void*)> receive_cb;
 };
 }
@@ -0,0 +1,91 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_SHAREDBUFFER_H
+#define RCP_SHAREDBUFFER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace rcp {
+
+/*
+* SharedBuffer - refcounted immutable block of bytes
+* copies of a SharedBuffer share the same memory,
+* so one serialized packet can be queued to many connections
+*
+* the key marks buffers which replace each other: of queued buffers
+* with the same key only the last one needs to be sent (see OutboundQueue).
+* copies keep the key.
+*/
+class SharedBuffer
+{
+public:
+    SharedBuffer()
+    {}
+
+    SharedBuffer(const char* data, size_t size)
+        : m_data(std::make_shared<const std::vector<char> >(data, data + size))
+    {}
+
+    explicit SharedBuffer(std::vector<char>&& data)
+        : m_data(std::make_shared<const std::vector<char> >(std::move(data)))
+    {}
+
+    const char* data() const
+    {
+        return m_data ? m_data->data() : nullptr;
+    }
+
+    size_t size() const
+    {
+        return m_data ? m_data->size() : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    long useCount() const
+    {
+        return m_data.use_count();
+    }
+
+    // NO_KEY: can not be replaced (default)
+    void setKey(int32_t key)
+    {
+        m_key = key;
+    }
+
+    int32_t key() const
+    {
+        return m_key;
+    }
+
+public:
+    static const int32_t NO_KEY = -1;
+
+private:
+    std::shared_ptr<const std::vector<char> > m_data;
+    int32_t m_key{NO_KEY};
+};
+
+}
+
+#endif // RCP_SHAREDBUFFER_H
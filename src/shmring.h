@@ -0,0 +1,242 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_SHMRING_H
+#define RCP_SHMRING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace rcp {
+
+/*
+* ShmRingControl - positions of a ShmRing
+*
+* lives in shared memory next to the ring data.
+* positions are free running counters, head and tail are on
+* separate cache lines.
+*/
+struct ShmRingControl
+{
+    // consumer
+    alignas(64) std::atomic<uint64_t> head;
+    // producer
+    alignas(64) std::atomic<uint64_t> tail;
+};
+
+
+/*
+* ShmRing - spsc ring of variable sized messages
+*
+* a view on a ShmRingControl and its data, both may be shared between
+* processes. every message is a 4 byte size followed by the payload,
+* padded to 8 bytes. a message that does not fit before the end of the
+* data is preceded by a wrap marker and written to the start.
+*
+* the producer reserves space, writes the message in place and commits
+* it. the consumer reads messages in place and releases them.
+* one producer and one consumer at a time.
+*/
+class ShmRing
+{
+public:
+    static const size_t HEADER_SIZE = 4;
+    static const uint32_t WRAP = 0xFFFFFFFF;
+
+    static size_t messageSpace(size_t size)
+    {
+        return (HEADER_SIZE + size + 7) & ~size_t(7);
+    }
+
+public:
+    ShmRing() {}
+
+    // capacity: power of two, at least 64
+    ShmRing(ShmRingControl* control, char* data, size_t capacity)
+        : m_control(control)
+        , m_data(data)
+        , m_capacity(capacity)
+        , m_mask(capacity - 1)
+    {}
+
+    // not while producer or consumer are active
+    void reset()
+    {
+        m_control->head.store(0, std::memory_order_relaxed);
+        m_control->tail.store(0, std::memory_order_release);
+        m_corrupt = false;
+    }
+
+    // consumer: the producer wrote an invalid message, peek returns false from then on.
+    // the producer lives in another process, treat it as dead
+    bool corrupt() const { return m_corrupt; }
+    // consumer: for a new producer on the same memory
+    void clearCorrupt() { m_corrupt = false; }
+
+    // bigger messages might never fit
+    size_t maxMessageSize() const { return m_capacity / 2 - HEADER_SIZE; }
+
+    bool empty() const
+    {
+        return m_control->head.load(std::memory_order_acquire) ==
+                m_control->tail.load(std::memory_order_acquire);
+    }
+
+    // producer: space for size bytes, nullptr if full or too big
+    char* reserve(size_t size)
+    {
+        if (size > maxMessageSize())
+        {
+            return nullptr;
+        }
+
+        uint64_t tail = m_control->tail.load(std::memory_order_relaxed);
+        uint64_t head = m_control->head.load(std::memory_order_acquire);
+        size_t free_space = m_capacity - static_cast<size_t>(tail - head);
+
+        size_t space = messageSpace(size);
+        size_t index = static_cast<size_t>(tail) & m_mask;
+        size_t contiguous = m_capacity - index;
+
+        m_skip = 0;
+        if (space > contiguous)
+        {
+            // wrap to the start
+            m_skip = contiguous;
+            index = 0;
+        }
+
+        if (m_skip + space > free_space)
+        {
+            return nullptr;
+        }
+
+        if (m_skip > 0)
+        {
+            _writeSize(static_cast<size_t>(tail) & m_mask, WRAP);
+        }
+
+        return m_data + index + HEADER_SIZE;
+    }
+
+    // producer: publish a reserved message of size bytes
+    void commit(size_t size)
+    {
+        uint64_t tail = m_control->tail.load(std::memory_order_relaxed) + m_skip;
+        _writeSize(static_cast<size_t>(tail) & m_mask, static_cast<uint32_t>(size));
+        m_control->tail.store(tail + messageSpace(size), std::memory_order_release);
+    }
+
+    bool write(const char* data, size_t size)
+    {
+        char* target = reserve(size);
+        if (target == nullptr)
+        {
+            return false;
+        }
+
+        std::memcpy(target, data, size);
+        commit(size);
+        return true;
+    }
+
+    // consumer: next message, false if empty or corrupt
+    bool peek(const char*& data, size_t& size)
+    {
+        if (m_corrupt)
+        {
+            return false;
+        }
+
+        uint64_t head = m_control->head.load(std::memory_order_relaxed);
+        uint64_t tail;
+
+        while (head != (tail = m_control->tail.load(std::memory_order_acquire)))
+        {
+            size_t used = static_cast<size_t>(tail - head);
+            size_t index = static_cast<size_t>(head) & m_mask;
+            size_t contiguous = m_capacity - index;
+            uint32_t message_size = _readSize(index);
+
+            if (message_size == WRAP)
+            {
+                if (used > m_capacity ||
+                    contiguous > used)
+                {
+                    m_corrupt = true;
+                    return false;
+                }
+
+                head += contiguous;
+                m_control->head.store(head, std::memory_order_release);
+                continue;
+            }
+
+            // sizes and positions come from the other process
+            if (used > m_capacity ||
+                message_size > maxMessageSize() ||
+                messageSpace(message_size) > used ||
+                messageSpace(message_size) > contiguous)
+            {
+                m_corrupt = true;
+                return false;
+            }
+
+            data = m_data + index + HEADER_SIZE;
+            size = message_size;
+            return true;
+        }
+
+        return false;
+    }
+
+    // consumer: release the message returned by peek
+    void release(size_t size)
+    {
+        uint64_t head = m_control->head.load(std::memory_order_relaxed);
+        m_control->head.store(head + messageSpace(size), std::memory_order_release);
+    }
+
+private:
+    void _writeSize(size_t index, uint32_t size)
+    {
+        std::memcpy(m_data + index, &size, HEADER_SIZE);
+    }
+
+    uint32_t _readSize(size_t index) const
+    {
+        uint32_t size;
+        std::memcpy(&size, m_data + index, HEADER_SIZE);
+        return size;
+    }
+
+    ShmRingControl* m_control{nullptr};
+    char* m_data{nullptr};
+    size_t m_capacity{0};
+    size_t m_mask{0};
+
+    // producer: wrap padding of the reserved message
+    size_t m_skip{0};
+    // consumer: invalid message seen
+    bool m_corrupt{false};
+};
+
+}
+
+#endif // RCP_SHMRING_H
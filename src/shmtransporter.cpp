@@ -0,0 +1,942 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "shmtransporter.h"
+
+#include <chrono>
+#include <climits>
+#include <iostream>
+#include <new>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+static const uint32_t SHM_MAGIC = 0x52435053;
+static const uint32_t SHM_VERSION = 1;
+
+// sleeping threads wake up this often to check the other side is alive
+static const int LIVENESS_INTERVAL_MS = 100;
+// messages delivered per connection and poll
+static const size_t MAX_BATCH = 256;
+
+enum slot_state_t
+{
+    SLOT_FREE = 0,
+    // client initializes the rings
+    SLOT_CLAIMED,
+    // client waits for the server
+    SLOT_OPEN,
+    SLOT_ACCEPTED,
+    SLOT_CLIENT_CLOSED,
+    SLOT_SERVER_CLOSED
+};
+
+// futex word and flag of a sleeping consumer
+struct ShmWaker
+{
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> waiting;
+};
+
+struct ShmHeader
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t ringSize;
+    std::atomic<int32_t> serverPid;
+
+    alignas(64) ShmWaker serverWaker;
+};
+
+struct ShmSlot
+{
+    alignas(64) std::atomic<uint32_t> state;
+    std::atomic<int32_t> clientPid;
+
+    alignas(64) ShmWaker clientWaker;
+
+    ShmRingControl toServer;
+    ShmRingControl toClient;
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex needs plain 32 bit atomics");
+
+static size_t dataOffset(size_t slotCount)
+{
+    size_t size = sizeof(ShmHeader) + slotCount * sizeof(ShmSlot);
+    return (size + 4095) & ~size_t(4095);
+}
+
+static size_t segmentSize(size_t slotCount, size_t ringSize)
+{
+    return dataOffset(slotCount) + slotCount * 2 * ringSize;
+}
+
+static ShmSlot* slotAt(ShmHeader* header, size_t index)
+{
+    return reinterpret_cast<ShmSlot*>(reinterpret_cast<char*>(header) + sizeof(ShmHeader)) + index;
+}
+
+static char* ringData(ShmHeader* header, size_t index, bool toClient)
+{
+    return reinterpret_cast<char*>(header) +
+            dataOffset(header->slotCount) +
+            (index * 2 + (toClient ? 1 : 0)) * header->ringSize;
+}
+
+static bool processAlive(int pid)
+{
+    return pid > 0 &&
+            (::kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+static inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+static void futexWait(std::atomic<uint32_t>& word, uint32_t value, int timeoutMs)
+{
+    timespec timeout;
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_nsec = (timeoutMs % 1000) * 1000000L;
+
+    // shared futex, the word is in memory of more than one process
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &timeout, nullptr, 0);
+}
+
+static void futexWake(std::atomic<uint32_t>& word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// wake a consumer if it sleeps
+// call after publishing data
+static void wake(ShmWaker& waker)
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    if (waker.waiting.load(std::memory_order_relaxed) != 0)
+    {
+        waker.seq.fetch_add(1, std::memory_order_relaxed);
+        futexWake(waker.seq);
+    }
+}
+
+static void wakeAlways(ShmWaker& waker)
+{
+    waker.seq.fetch_add(1, std::memory_order_seq_cst);
+    futexWake(waker.seq);
+}
+
+// poll() until stopped, spin before sleeping on the waker
+// idle() is called after every sleep
+template<typename Poll, typename Idle>
+static void pollLoop(std::atomic<bool>& running, ShmWaker& waker, size_t spinCount, Poll poll, Idle idle)
+{
+    size_t spins = 0;
+
+    while (running.load(std::memory_order_acquire))
+    {
+        if (poll() > 0)
+        {
+            spins = 0;
+            continue;
+        }
+
+        if (spins < spinCount)
+        {
+            spins++;
+            cpuRelax();
+            continue;
+        }
+
+        // announce the sleep, then check again before sleeping
+        waker.waiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint32_t seq = waker.seq.load(std::memory_order_relaxed);
+
+        if (poll() == 0 &&
+            running.load(std::memory_order_acquire))
+        {
+            futexWait(waker.seq, seq, LIVENESS_INTERVAL_MS);
+        }
+
+        waker.waiting.store(0, std::memory_order_relaxed);
+        spins = 0;
+
+        idle();
+    }
+}
+
+// write with a timeout while the ring is full
+static bool writeWait(ShmRing& ring, const char* data, size_t size, int timeoutMs)
+{
+    if (ring.write(data, size))
+    {
+        return true;
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (!ring.write(data, size))
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+
+    return true;
+}
+
+// spinning only helps if the other side runs on another cpu
+static size_t defaultSpinCount()
+{
+    return std::thread::hardware_concurrency() > 1 ? 4000 : 0;
+}
+
+static size_t roundUpPowerOfTwo(size_t value)
+{
+    size_t result = 64;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+
+//------------------------------------------------------------------
+// ShmSegment
+ShmSegment::~ShmSegment()
+{
+    close();
+}
+
+bool ShmSegment::create(const std::string& name, size_t size)
+{
+    close();
+
+    int fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        std::cerr << "ShmSegment: could not resize " << name << ": " << errno << "\n";
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "ShmSegment: could not map " << name << ": " << errno << "\n";
+        ::shm_unlink(name.c_str());
+        return false;
+    }
+
+    m_name = name;
+    m_data = static_cast<char*>(data);
+    m_size = size;
+    m_owner = true;
+
+    return true;
+}
+
+bool ShmSegment::open(const std::string& name)
+{
+    close();
+
+    int fd = ::shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 ||
+        info.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    size_t size = static_cast<size_t>(info.st_size);
+    void* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        std::cerr << "ShmSegment: could not map " << name << ": " << errno << "\n";
+        return false;
+    }
+
+    m_name = name;
+    m_data = static_cast<char*>(data);
+    m_size = size;
+    m_owner = false;
+
+    return true;
+}
+
+void ShmSegment::close()
+{
+    if (m_data == nullptr)
+    {
+        return;
+    }
+
+    ::munmap(m_data, m_size);
+
+    if (m_owner)
+    {
+        ::shm_unlink(m_name.c_str());
+    }
+
+    m_data = nullptr;
+    m_size = 0;
+    m_owner = false;
+}
+
+void ShmSegment::unlink(const std::string& name)
+{
+    ::shm_unlink(name.c_str());
+}
+
+
+//------------------------------------------------------------------
+// ShmServerTransporter
+std::string ShmServerTransporter::segmentName(int port)
+{
+    return "/rcp-" + std::to_string(port);
+}
+
+ShmServerTransporter::ShmServerTransporter(size_t slotCount, size_t ringSize)
+    : m_slotCount(slotCount > 0 ? slotCount : 1)
+    , m_ringSize(roundUpPowerOfTwo(ringSize))
+    , m_spinCount(defaultSpinCount())
+{
+}
+
+ShmServerTransporter::~ShmServerTransporter()
+{
+    unbind();
+}
+
+void ShmServerTransporter::bind(int port)
+{
+    if (isBound())
+    {
+        unbind();
+    }
+
+    std::string name = segmentName(port);
+    size_t size = segmentSize(m_slotCount, m_ringSize);
+
+    if (!m_segment.create(name, size))
+    {
+        // replace the object of a server that is gone
+        ShmSegment existing;
+        if (existing.open(name) &&
+            existing.size() >= sizeof(ShmHeader))
+        {
+            ShmHeader* header = reinterpret_cast<ShmHeader*>(existing.data());
+            if (header->magic.load(std::memory_order_acquire) == SHM_MAGIC &&
+                processAlive(header->serverPid.load()))
+            {
+                std::cerr << "ShmServerTransporter: port " << port << " is in use\n";
+                return;
+            }
+        }
+        existing.close();
+
+        ShmSegment::unlink(name);
+        if (!m_segment.create(name, size))
+        {
+            std::cerr << "ShmServerTransporter: could not create " << name << ": " << errno << "\n";
+            return;
+        }
+    }
+
+    m_port = port;
+
+    // new memory is zeroed
+    m_header = new (m_segment.data()) ShmHeader();
+    m_header->version = SHM_VERSION;
+    m_header->slotCount = static_cast<uint32_t>(m_slotCount);
+    m_header->ringSize = static_cast<uint32_t>(m_ringSize);
+    m_header->serverPid.store(static_cast<int32_t>(::getpid()));
+
+    m_connections.clear();
+    for (size_t i = 0; i < m_slotCount; i++)
+    {
+        ShmSlot* slot = new (slotAt(m_header, i)) ShmSlot();
+
+        std::unique_ptr<Connection> connection(new Connection());
+        connection->slot = slot;
+        connection->toServer = ShmRing(&slot->toServer, ringData(m_header, i, false), m_ringSize);
+        connection->toClient = ShmRing(&slot->toClient, ringData(m_header, i, true), m_ringSize);
+        m_connections.push_back(std::move(connection));
+    }
+
+    // clients may attach from here
+    m_header->magic.store(SHM_MAGIC, std::memory_order_release);
+
+    m_running = true;
+    m_thread = std::thread(&ShmServerTransporter::_run, this);
+}
+
+void ShmServerTransporter::unbind()
+{
+    if (!isBound())
+    {
+        return;
+    }
+
+    m_running = false;
+    wakeAlways(m_header->serverWaker);
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    for (auto& connection : m_connections)
+    {
+        if (connection->open)
+        {
+            {
+                std::lock_guard<std::mutex> lock(connection->sendMutex);
+                connection->accepted = false;
+            }
+            connection->open = false;
+            m_connectionCount--;
+
+            connection->slot->state.store(SLOT_SERVER_CLOSED, std::memory_order_release);
+            wakeAlways(connection->slot->clientWaker);
+
+            _clientDisconnected(connection.get());
+        }
+    }
+
+    m_header->magic.store(0, std::memory_order_release);
+    m_header->serverPid.store(0);
+    m_header = nullptr;
+
+    // clients keep their mapping until they disconnect
+    m_segment.close();
+}
+
+void ShmServerTransporter::sendToOne(const char* data, size_t size, void* id)
+{
+    for (auto& connection : m_connections)
+    {
+        if (connection.get() == id)
+        {
+            _write(*connection, data, size);
+            return;
+        }
+    }
+}
+
+void ShmServerTransporter::sendToAll(const char* data, size_t size, void* excludeId)
+{
+    for (auto& connection : m_connections)
+    {
+        if (connection.get() != excludeId)
+        {
+            _write(*connection, data, size);
+        }
+    }
+}
+
+void ShmServerTransporter::sendToOne(const SharedBuffer& buffer, void* id)
+{
+    sendToOne(buffer.data(), buffer.size(), id);
+}
+
+void ShmServerTransporter::sendToAll(const SharedBuffer& buffer, void* excludeId)
+{
+    sendToAll(buffer.data(), buffer.size(), excludeId);
+}
+
+void ShmServerTransporter::sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter)
+{
+    for (auto& connection : m_connections)
+    {
+        if (filter(connection.get()))
+        {
+            _write(*connection, buffer.data(), buffer.size());
+        }
+    }
+}
+
+int ShmServerTransporter::getConnectionCount()
+{
+    return m_connectionCount.load();
+}
+
+void ShmServerTransporter::_run()
+{
+    auto last_check = std::chrono::steady_clock::now();
+
+    pollLoop(m_running, m_header->serverWaker, m_spinCount,
+             [this]() { return _poll(); },
+             [this, &last_check]() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_check > std::chrono::milliseconds(LIVENESS_INTERVAL_MS))
+        {
+            last_check = now;
+            _checkClients();
+        }
+    });
+}
+
+size_t ShmServerTransporter::_poll()
+{
+    size_t count = 0;
+
+    for (auto& c : m_connections)
+    {
+        Connection& connection = *c;
+        ShmSlot* slot = connection.slot;
+        uint32_t state = slot->state.load(std::memory_order_acquire);
+
+        if (!connection.open)
+        {
+            if (state == SLOT_OPEN)
+            {
+                connection.pid = slot->clientPid.load();
+                connection.open = true;
+                connection.toServer.clearCorrupt();
+                {
+                    std::lock_guard<std::mutex> lock(connection.sendMutex);
+                    connection.accepted = true;
+                }
+                m_connectionCount++;
+
+                slot->state.store(SLOT_ACCEPTED, std::memory_order_release);
+                wake(slot->clientWaker);
+
+                _clientConnected(&connection);
+                count++;
+            }
+            else if (state == SLOT_CLIENT_CLOSED)
+            {
+                // closed before it was accepted
+                slot->state.store(SLOT_FREE, std::memory_order_release);
+            }
+
+            continue;
+        }
+
+        const char* data;
+        size_t size;
+        for (size_t i = 0; i < MAX_BATCH && connection.toServer.peek(data, size); i++)
+        {
+            _received(data, size, &connection);
+            connection.toServer.release(size);
+            count++;
+        }
+
+        if (connection.toServer.corrupt())
+        {
+            std::cerr << "ShmServerTransporter: invalid message from client " << connection.pid << ", closing\n";
+            _close(connection);
+            count++;
+            continue;
+        }
+
+        if (state == SLOT_CLIENT_CLOSED &&
+            connection.toServer.empty())
+        {
+            _close(connection);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void ShmServerTransporter::_close(Connection& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(connection.sendMutex);
+        connection.accepted = false;
+    }
+    connection.open = false;
+    m_connectionCount--;
+
+    connection.slot->state.store(SLOT_FREE, std::memory_order_release);
+
+    _clientDisconnected(&connection);
+}
+
+void ShmServerTransporter::_checkClients()
+{
+    for (auto& connection : m_connections)
+    {
+        ShmSlot* slot = connection->slot;
+        uint32_t state = slot->state.load(std::memory_order_acquire);
+
+        if (state == SLOT_FREE ||
+            processAlive(slot->clientPid.load()))
+        {
+            continue;
+        }
+
+        if (connection->open)
+        {
+            _close(*connection);
+        }
+        else if (slot->clientPid.load() != 0)
+        {
+            // client died while connecting
+            slot->state.store(SLOT_FREE, std::memory_order_release);
+        }
+    }
+}
+
+bool ShmServerTransporter::_write(Connection& connection, const char* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(connection.sendMutex);
+
+    if (!connection.accepted)
+    {
+        return false;
+    }
+
+    if (size > maxMessageSize())
+    {
+        std::cerr << "ShmServerTransporter: message too big: " << size << "\n";
+        m_dropped++;
+        return false;
+    }
+
+    if (!writeWait(connection.toClient, data, size, m_sendTimeoutMs))
+    {
+        m_dropped++;
+        return false;
+    }
+
+    wake(connection.slot->clientWaker);
+    return true;
+}
+
+
+//------------------------------------------------------------------
+// ShmClientTransporter
+ShmClientTransporter::ShmClientTransporter()
+    : m_spinCount(defaultSpinCount())
+{
+}
+
+ShmClientTransporter::~ShmClientTransporter()
+{
+    // no notification, listeners might be gone already
+    m_connected = false;
+    _release();
+    _stop();
+}
+
+void ShmClientTransporter::connect(std::string /*host*/, int port, bool secure)
+{
+    if (secure)
+    {
+        std::cerr << "ShmClientTransporter: secure connections are not supported\n";
+        return;
+    }
+
+    if (m_running)
+    {
+        // connected or connecting
+        return;
+    }
+
+    if (m_thread.joinable() &&
+        m_thread.get_id() == std::this_thread::get_id())
+    {
+        std::cerr << "ShmClientTransporter: can not connect from the transporter thread\n";
+        return;
+    }
+
+    // release a segment of a closed connection
+    _stop();
+
+    std::string name = ShmServerTransporter::segmentName(port);
+    if (!m_segment.open(name))
+    {
+        std::cerr << "ShmClientTransporter: no server on port " << port << "\n";
+        return;
+    }
+
+    ShmHeader* header = reinterpret_cast<ShmHeader*>(m_segment.data());
+    if (m_segment.size() < sizeof(ShmHeader) ||
+        header->magic.load(std::memory_order_acquire) != SHM_MAGIC ||
+        header->version != SHM_VERSION ||
+        m_segment.size() < segmentSize(header->slotCount, header->ringSize))
+    {
+        std::cerr << "ShmClientTransporter: invalid segment " << name << "\n";
+        m_segment.close();
+        return;
+    }
+
+    ShmSlot* slot = nullptr;
+    size_t index = 0;
+    for (; index < header->slotCount; index++)
+    {
+        uint32_t expected = SLOT_FREE;
+        if (slotAt(header, index)->state.compare_exchange_strong(expected, SLOT_CLAIMED))
+        {
+            slot = slotAt(header, index);
+            break;
+        }
+    }
+
+    if (slot == nullptr)
+    {
+        std::cerr << "ShmClientTransporter: no free connection slot on port " << port << "\n";
+        m_segment.close();
+        return;
+    }
+
+    slot->clientPid.store(static_cast<int32_t>(::getpid()));
+    slot->clientWaker.waiting.store(0);
+
+    {
+        std::lock_guard<std::mutex> lock(m_sendMutex);
+        m_header = header;
+        m_slot = slot;
+        m_toServer = ShmRing(&slot->toServer, ringData(header, index, false), header->ringSize);
+        m_toClient = ShmRing(&slot->toClient, ringData(header, index, true), header->ringSize);
+        m_toServer.reset();
+        m_toClient.reset();
+    }
+
+    slot->state.store(SLOT_OPEN, std::memory_order_release);
+    wake(header->serverWaker);
+
+    m_running = true;
+    m_thread = std::thread(&ShmClientTransporter::_run, this);
+}
+
+void ShmClientTransporter::disconnect()
+{
+    if (!m_segment.isOpen())
+    {
+        return;
+    }
+
+    _release();
+
+    bool was_connected = m_connected.exchange(false);
+
+    _stop();
+
+    if (was_connected)
+    {
+        _disconnected();
+    }
+}
+
+bool ShmClientTransporter::isConnected()
+{
+    return m_connected.load(std::memory_order_acquire);
+}
+
+void ShmClientTransporter::send(const char* data, size_t size)
+{
+    if (!m_connected.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+
+    if (m_slot == nullptr)
+    {
+        return;
+    }
+
+    if (size > m_toServer.maxMessageSize())
+    {
+        std::cerr << "ShmClientTransporter: message too big: " << size << "\n";
+        m_dropped++;
+        return;
+    }
+
+    if (!writeWait(m_toServer, data, size, m_sendTimeoutMs))
+    {
+        m_dropped++;
+        return;
+    }
+
+    wake(m_header->serverWaker);
+}
+
+void ShmClientTransporter::send(const SharedBuffer& buffer)
+{
+    send(buffer.data(), buffer.size());
+}
+
+void ShmClientTransporter::_run()
+{
+    auto last_check = std::chrono::steady_clock::now();
+
+    pollLoop(m_running, m_slot->clientWaker, m_spinCount,
+             [this]() { return _poll(); },
+             [this, &last_check]() {
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_check > std::chrono::milliseconds(LIVENESS_INTERVAL_MS))
+        {
+            last_check = now;
+
+            if (!_serverAlive())
+            {
+                m_running = false;
+                if (m_connected.exchange(false))
+                {
+                    _disconnected();
+                }
+            }
+        }
+    });
+}
+
+size_t ShmClientTransporter::_poll()
+{
+    size_t count = 0;
+    uint32_t state = m_slot->state.load(std::memory_order_acquire);
+
+    if (!m_connected.load(std::memory_order_relaxed) &&
+        state == SLOT_ACCEPTED)
+    {
+        m_connected = true;
+        _connected();
+        count++;
+    }
+
+    if (m_connected.load(std::memory_order_relaxed))
+    {
+        const char* data;
+        size_t size;
+        for (size_t i = 0; i < MAX_BATCH && m_toClient.peek(data, size); i++)
+        {
+            _received(data, size);
+            m_toClient.release(size);
+            count++;
+        }
+
+        if (m_toClient.corrupt())
+        {
+            std::cerr << "ShmClientTransporter: invalid message from server, disconnecting\n";
+            m_running = false;
+            if (m_connected.exchange(false))
+            {
+                _disconnected();
+            }
+            return count + 1;
+        }
+    }
+
+    if (state == SLOT_SERVER_CLOSED &&
+        m_toClient.empty())
+    {
+        m_running = false;
+        if (m_connected.exchange(false))
+        {
+            _disconnected();
+        }
+        count++;
+    }
+
+    return count;
+}
+
+bool ShmClientTransporter::_serverAlive()
+{
+    return m_header->magic.load(std::memory_order_acquire) == SHM_MAGIC &&
+            processAlive(m_header->serverPid.load());
+}
+
+void ShmClientTransporter::_release()
+{
+    if (m_slot == nullptr)
+    {
+        return;
+    }
+
+    uint32_t state = m_slot->state.load(std::memory_order_acquire);
+    while (state == SLOT_CLAIMED ||
+           state == SLOT_OPEN ||
+           state == SLOT_ACCEPTED)
+    {
+        if (m_slot->state.compare_exchange_weak(state, SLOT_CLIENT_CLOSED))
+        {
+            wake(m_header->serverWaker);
+            break;
+        }
+    }
+}
+
+void ShmClientTransporter::_stop()
+{
+    m_running = false;
+
+    if (m_thread.joinable())
+    {
+        if (m_thread.get_id() == std::this_thread::get_id())
+        {
+            // called from a callback, the thread ends after it
+            return;
+        }
+
+        wakeAlways(m_slot->clientWaker);
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_sendMutex);
+    m_header = nullptr;
+    m_slot = nullptr;
+    m_segment.close();
+}
+
+}
+
+#endif // __linux__
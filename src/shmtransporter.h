@@ -0,0 +1,225 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_SHMTRANSPORTER_H
+#define RCP_SHMTRANSPORTER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "servertransporter.h"
+#include "clienttransporter.h"
+#include "sharedbuffer.h"
+#include "shmring.h"
+
+namespace rcp {
+
+struct ShmHeader;
+struct ShmSlot;
+
+/*
+* ShmSegment - mapped posix shared memory object
+*/
+class ShmSegment
+{
+public:
+    ShmSegment() {}
+    ~ShmSegment();
+
+    ShmSegment(const ShmSegment&) = delete;
+    ShmSegment& operator=(const ShmSegment&) = delete;
+
+    // create a new object, fails if it exists
+    bool create(const std::string& name, size_t size);
+    // open an existing object
+    bool open(const std::string& name);
+    // unmap, unlink if created
+    void close();
+
+    static void unlink(const std::string& name);
+
+    char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    bool isOpen() const { return m_data != nullptr; }
+
+private:
+    std::string m_name;
+    char* m_data{nullptr};
+    size_t m_size{0};
+    bool m_owner{false};
+};
+
+
+/*
+* ShmServerTransporter - server for clients in other processes on the same host
+*
+* bind() creates a posix shared memory object named after the port
+* (see segmentName) with a fixed number of connection slots.
+* every slot has one ShmRing per direction.
+*
+* messages are copied into the ring in place, the receiver delivers
+* them straight from shared memory. no system call is made while the
+* receiving side is busy: receivers spin for a while before they sleep
+* on a futex, senders only wake receivers that sleep.
+*
+* received data is delivered on the transporter thread.
+* the connection id passed to receivers is internal to the transporter.
+*/
+class ShmServerTransporter : public ServerTransporter
+{
+public:
+    static const size_t DEFAULT_SLOT_COUNT = 16;
+    static const size_t DEFAULT_RING_SIZE = 1024 * 1024;
+
+    static std::string segmentName(int port);
+
+public:
+    // ringSize: bytes per connection and direction, power of two
+    ShmServerTransporter(size_t slotCount = DEFAULT_SLOT_COUNT, size_t ringSize = DEFAULT_RING_SIZE);
+    ~ShmServerTransporter();
+
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    // ServerTransporter
+    void bind(int port) override;
+    void unbind() override;
+
+    void sendToOne(const char* data, size_t size, void* id) override;
+    void sendToAll(const char* data, size_t size, void* excludeId) override;
+    void sendToOne(const SharedBuffer& buffer, void* id) override;
+    void sendToAll(const SharedBuffer& buffer, void* excludeId) override;
+    void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter) override;
+
+    int getConnectionCount() override;
+
+public:
+    bool isBound() const { return m_segment.isOpen(); }
+    int getPort() const { return m_port; }
+
+    // polls before sleeping, default: 4000 (0 on single cpu systems)
+    void setSpinCount(size_t count) { m_spinCount = count; }
+    // how long a send waits for space in a full ring, default: 100ms
+    void setSendTimeout(int ms) { m_sendTimeoutMs = ms; }
+
+    size_t maxMessageSize() const { return m_ringSize / 2 - ShmRing::HEADER_SIZE; }
+
+    // messages dropped because a ring stayed full or they were too big
+    size_t droppedCount() const { return m_dropped.load(); }
+
+private:
+    struct Connection
+    {
+        ShmSlot* slot{nullptr};
+        ShmRing toServer;
+        ShmRing toClient;
+        int pid{0};
+        // server thread only
+        bool open{false};
+        // senders
+        std::mutex sendMutex;
+        bool accepted{false};
+    };
+
+    void _run();
+    size_t _poll();
+    void _close(Connection& connection);
+    void _checkClients();
+    bool _write(Connection& connection, const char* data, size_t size);
+
+    size_t m_slotCount;
+    size_t m_ringSize;
+    size_t m_spinCount;
+    int m_sendTimeoutMs{100};
+    int m_port{0};
+
+    ShmSegment m_segment;
+    ShmHeader* m_header{nullptr};
+    std::vector<std::unique_ptr<Connection> > m_connections;
+    std::atomic<int> m_connectionCount{0};
+    std::atomic<size_t> m_dropped{0};
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+};
+
+
+/*
+* ShmClientTransporter - client for ShmServerTransporter
+*
+* connect() opens the shared memory object of the port and claims a
+* free slot, the host is ignored. connected() is called when the
+* server accepted the slot.
+* received data is delivered on the transporter thread.
+*/
+class ShmClientTransporter : public ClientTransporter
+{
+public:
+    ShmClientTransporter();
+    ~ShmClientTransporter();
+
+    using ClientTransporter::send;
+
+    // ClientTransporter
+    void connect(std::string host, int port, bool secure = false) override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    void send(const char* data, size_t size) override;
+    void send(const SharedBuffer& buffer) override;
+
+public:
+    void setSpinCount(size_t count) { m_spinCount = count; }
+    void setSendTimeout(int ms) { m_sendTimeoutMs = ms; }
+
+    size_t droppedCount() const { return m_dropped.load(); }
+
+private:
+    void _run();
+    size_t _poll();
+    bool _serverAlive();
+    void _release();
+    void _stop();
+
+    size_t m_spinCount;
+    int m_sendTimeoutMs{100};
+
+    ShmSegment m_segment;
+    ShmHeader* m_header{nullptr};
+    ShmSlot* m_slot{nullptr};
+    ShmRing m_toServer;
+    ShmRing m_toClient;
+
+    std::mutex m_sendMutex;
+    std::atomic<bool> m_connected{false};
+    std::atomic<size_t> m_dropped{0};
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_SHMTRANSPORTER_H
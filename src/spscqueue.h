@@ -0,0 +1,134 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_SPSCQUEUE_H
+#define RCP_SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace rcp {
+
+/*
+* SpscQueue - bounded lock-free single producer single consumer queue
+*
+* one thread calls push(), one thread calls front() and pop().
+* capacity is rounded up to a power of two.
+*/
+template<typename T>
+class SpscQueue
+{
+public:
+    SpscQueue(size_t capacity = 1024)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    size_t capacity() const { return m_slots.size(); }
+
+    // producer
+    // returns false if the queue is full
+    bool push(const T& value)
+    {
+        T copy(value);
+        return push(std::move(copy));
+    }
+
+    bool push(T&& value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+        {
+            return false;
+        }
+
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // consumer
+    // returns nullptr if the queue is empty
+    T* front()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+
+        return &m_slots[head & m_mask];
+    }
+
+    void pop()
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+
+        // release the element before handing the slot back
+        m_slots[head & m_mask] = T();
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    bool pop(T& value)
+    {
+        T* f = front();
+        if (f == nullptr)
+        {
+            return false;
+        }
+
+        value = std::move(*f);
+        pop();
+
+        return true;
+    }
+
+    // approximate when called concurrently
+    size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+private:
+    std::vector<T> m_slots;
+    size_t m_mask;
+
+    // keep head and tail on different cache lines
+    char m_pad0[64];
+    std::atomic<size_t> m_head{0};
+    char m_pad1[64];
+    std::atomic<size_t> m_tail{0};
+};
+
+}
+
+#endif // RCP_SPSCQUEUE_H
@@ -31,41 +31,59 @@ std::string& swap_endian(std::string &u)
 
 //---------------------------------------------------
 // read from stream
-bool readFromStream(std::istream& is, bool const& /*i*/)
+bool readFromStream(ByteReader& is, bool const& /*i*/)
 {
-    bool value;
+    bool value{};
     is.read(reinterpret_cast<char*>(&value), sizeof(bool));
     return value;
 }
 
-std::string readFromStream(std::istream& /*is*/, std::string const& i)
+std::string readFromStream(ByteReader& /*is*/, std::string const& i)
 {
     return i;
 }
 
 //---------------------------------------------------
 // read strings from stream
-std::string readTinyString(std::istream& is)
+std::string readTinyString(ByteReader& is)
 {
 
     char size = 0;
     return readStringFromStream(is, size);
 }
 
-std::string readShortString(std::istream& is)
+std::string readShortString(ByteReader& is)
 {
 
     uint16_t size = 0;
     return readStringFromStream(is, size);
 }
 
-std::string readLongString(std::istream& is)
+std::string readLongString(ByteReader& is)
 {
 
     uint32_t size = 0;
     return readStringFromStream(is, size);
 }
 
+std::string readTinyString(std::istream& is)
+{
+    ByteReader reader(is);
+    return readTinyString(reader);
+}
+
+std::string readShortString(std::istream& is)
+{
+    ByteReader reader(is);
+    return readShortString(reader);
+}
+
+std::string readLongString(std::istream& is)
+{
+    ByteReader reader(is);
+    return readLongString(reader);
+}
+
 
 // to string
 std::string value_to_string(std::string value)
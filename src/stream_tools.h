@@ -35,7 +35,7 @@
 #ifndef STREAMTOOLS_H
 #define STREAMTOOLS_H
 
-#include <istream>
+#include "bytereader.h"
 #include <ostream>
 #include <string>
 #include <vector>
@@ -96,9 +96,9 @@ template <
     typename T,
     typename std::enable_if<std::is_arithmetic<T>::value>::type* = nullptr
     >
-T readFromStream(std::istream& is, const T& /*i*/) {
+T readFromStream(ByteReader& is, const T& /*i*/) {
 
-    T value;
+    T value{};
     is.read(reinterpret_cast<char *>(&value), sizeof(T));
 
 #if BYTE_ORDER == LITTLE_ENDIAN
@@ -109,14 +109,14 @@ T readFromStream(std::istream& is, const T& /*i*/) {
 }
 
 
-bool readFromStream(std::istream& is, bool const& i);
-std::string readFromStream(std::istream& is, std::string const& i);
+bool readFromStream(ByteReader& is, bool const& i);
+std::string readFromStream(ByteReader& is, std::string const& i);
 
 
 template <typename T,
          typename = std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, T>>
-std::string readStringFromStream(std::istream& is, T /*s*/) {
-    T size;
+std::string readStringFromStream(ByteReader& is, T /*s*/) {
+    T size{};
     is.read(reinterpret_cast<char *>(&size), sizeof(size));
 
 #if BYTE_ORDER == LITTLE_ENDIAN
@@ -132,6 +132,26 @@ std::string readStringFromStream(std::istream& is, T /*s*/) {
 
 
 // read strings from stream
+std::string readTinyString(ByteReader& is);
+std::string readShortString(ByteReader& is);
+std::string readLongString(ByteReader& is);
+
+
+// std::istream wrappers
+// read through a ByteReader in stream mode, which consumes only the bytes it needs
+template<typename T>
+T readFromStream(std::istream& is, const T& i) {
+    ByteReader reader(is);
+    return readFromStream(reader, i);
+}
+
+template <typename T,
+         typename = std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, T>>
+std::string readStringFromStream(std::istream& is, T s) {
+    ByteReader reader(is);
+    return readStringFromStream(reader, s);
+}
+
 std::string readTinyString(std::istream& is);
 std::string readShortString(std::istream& is);
 std::string readLongString(std::istream& is);
@@ -0,0 +1,230 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef SUBSCRIPTIONDATA_H
+#define SUBSCRIPTIONDATA_H
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+#include "writeable.h"
+#include "stream_tools.h"
+#include "parameter_intern.h"
+
+namespace rcp {
+
+class SubscriptionData;
+typedef std::shared_ptr<SubscriptionData> SubscriptionDataPtr;
+
+/*
+* SubscriptionData - parameters a client wants to receive
+*
+* data of COMMAND_SUBSCRIBE, an extension of this implementation:
+* a list of options, GROUP followed by an id, TAG followed by a tinystring,
+* then a terminator.
+*
+* a parameter matches if its id or the id of one of its parents is in
+* groups, or if one of its (whitespace separated) tags is in tags.
+* groups always match, they make up the tree.
+* an empty subscription matches everything.
+*
+* lazy: interest of a client discovering the tree (COMMAND_DISCOVER),
+* kept by the server and not written. top level parameters and the
+* subtrees of discovered groups match, other groups do not.
+*/
+class SubscriptionData
+    : public Writeable
+{
+public:
+    //----------------------------------------
+    // parser
+    static SubscriptionDataPtr parse(ByteReader& is) {
+
+        SubscriptionDataPtr subscription = std::make_shared<SubscriptionData>();
+
+        // read options
+        while (!is.eof()) {
+
+            // read option prefix
+            subscription_options_t option = static_cast<subscription_options_t>(is.get());
+
+            if (option == TERMINATOR) {
+                return subscription;
+            }
+
+            if (is.eof() || is.fail()) {
+                break;
+            }
+
+            switch (option) {
+            case SUBSCRIPTION_OPTIONS_GROUP:
+            {
+                const int16_t id = readFromStream(is, id);
+                subscription->addGroup(id);
+                break;
+            }
+            case SUBSCRIPTION_OPTIONS_TAG:
+                subscription->addTag(readTinyString(is));
+                break;
+            default:
+                return nullptr;
+            }
+        }
+
+        // missing terminator
+        return nullptr;
+    }
+
+    static inline SubscriptionDataPtr create(const std::vector<int16_t>& groups,
+                                             const std::vector<std::string>& tags) {
+        return std::make_shared<SubscriptionData>(groups, tags);
+    }
+
+
+    //----------------------------------------
+    //
+    SubscriptionData()
+    {}
+
+    SubscriptionData(const std::vector<int16_t>& groups, const std::vector<std::string>& tags) :
+        m_groups(groups)
+        , m_tags(tags)
+    {}
+
+    void addGroup(int16_t id) {
+        if (!_hasGroup(id)) {
+            m_groups.push_back(id);
+        }
+    }
+    const std::vector<int16_t>& getGroups() const { return m_groups; }
+
+    void addTag(const std::string& tag) {
+        m_tags.push_back(tag);
+    }
+    const std::vector<std::string>& getTags() const { return m_tags; }
+
+    bool empty() const {
+        return m_groups.empty() && m_tags.empty();
+    }
+
+    void setLazy(bool lazy) { m_lazy = lazy; }
+    bool isLazy() const { return m_lazy; }
+
+    bool matches(const ParameterPtr& parameter) const {
+
+        if (m_lazy)
+        {
+            // parent is the root group
+            GroupParameterPtr parent = parameter->getParent().lock();
+            if (!parent ||
+                !parent->getParent().lock())
+            {
+                return true;
+            }
+        }
+        else if (empty() ||
+                 parameter->getDatatype() == DATATYPE_GROUP)
+        {
+            return true;
+        }
+
+        if (_hasGroup(parameter->getId()))
+        {
+            return true;
+        }
+
+        for (GroupParameterPtr group = parameter->getParent().lock();
+             group;
+             group = group->getParent().lock())
+        {
+            if (_hasGroup(group->getId()))
+            {
+                return true;
+            }
+        }
+
+        return !m_tags.empty() &&
+                parameter->hasTags() &&
+                _hasTag(parameter->getTags());
+    }
+
+    //----------------------------------------
+    // interface Writeable
+    virtual void write(Writer& out, bool /*all*/) {
+
+        for (int16_t id : m_groups) {
+            out.write(static_cast<char>(SUBSCRIPTION_OPTIONS_GROUP));
+            out.write(id);
+        }
+
+        for (const std::string& tag : m_tags) {
+            out.write(static_cast<char>(SUBSCRIPTION_OPTIONS_TAG));
+            out.writeTinyString(tag);
+        }
+
+        // terminator
+        out.write(static_cast<char>(TERMINATOR));
+    }
+
+private:
+    bool _hasGroup(int16_t id) const {
+        return std::find(m_groups.begin(), m_groups.end(), id) != m_groups.end();
+    }
+
+    bool _hasTag(const std::string& tags) const {
+
+        // compare every word of tags without copying it
+        size_t start = 0;
+
+        while (start < tags.size())
+        {
+            if (std::isspace(static_cast<unsigned char>(tags[start])))
+            {
+                start++;
+                continue;
+            }
+
+            size_t end = start;
+            while (end < tags.size() &&
+                   !std::isspace(static_cast<unsigned char>(tags[end])))
+            {
+                end++;
+            }
+
+            for (const std::string& tag : m_tags)
+            {
+                if (tags.compare(start, end - start, tag) == 0)
+                {
+                    return true;
+                }
+            }
+
+            start = end;
+        }
+
+        return false;
+    }
+
+    std::vector<int16_t> m_groups;
+    std::vector<std::string> m_tags;
+    bool m_lazy{false};
+};
+}
+
+#endif // SUBSCRIPTIONDATA_H
@@ -0,0 +1,956 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "tcptransporter.h"
+
+#include <cstring>
+#include <iostream>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+// iovecs per write call: header and body per message
+static const size_t MAX_IOV = 128;
+// reads per readable event, so one busy connection can not starve others
+static const size_t MAX_READS = 16;
+static const size_t READ_SIZE = 64 * 1024;
+
+//------------------------------------------------------------------
+// TcpSocket
+int TcpSocket::listen(const std::string& address, int port, int& boundPort)
+{
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        std::cerr << "TcpSocket: socket failed: " << errno << "\n";
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (!address.empty() &&
+        inet_pton(AF_INET, address.c_str(), &addr.sin_addr) != 1)
+    {
+        std::cerr << "TcpSocket: invalid address: " << address << "\n";
+        ::close(fd);
+        return -1;
+    }
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        std::cerr << "TcpSocket: could not bind to port " << port << ": " << errno << "\n";
+        ::close(fd);
+        return -1;
+    }
+
+    socklen_t len = sizeof(addr);
+    getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    boundPort = ntohs(addr.sin_port);
+
+    return fd;
+}
+
+int TcpSocket::connect(const std::string& host, int port)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0)
+    {
+        std::cerr << "TcpSocket: could not resolve " << host << "\n";
+        return -1;
+    }
+
+    int fd = -1;
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next)
+    {
+        fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0)
+        {
+            continue;
+        }
+
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 ||
+            errno == EINPROGRESS)
+        {
+            break;
+        }
+
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0)
+    {
+        std::cerr << "TcpSocket: could not connect to " << host << ":" << port << "\n";
+    }
+
+    return fd;
+}
+
+int TcpSocket::accept(int listenFd)
+{
+    while (true)
+    {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0 &&
+            errno == EINTR)
+        {
+            continue;
+        }
+
+        // EAGAIN or out of descriptors, try again on next event
+        return fd;
+    }
+}
+
+int TcpSocket::connectError(int fd)
+{
+    int error = 0;
+    socklen_t len = sizeof(error);
+    getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len);
+    return error;
+}
+
+void TcpSocket::setNoDelay(int fd, bool noDelay)
+{
+    int value = noDelay ? 1 : 0;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+}
+
+void TcpSocket::close(int fd)
+{
+    if (fd >= 0)
+    {
+        ::close(fd);
+    }
+}
+
+
+//------------------------------------------------------------------
+// TcpStream
+TcpStream::TcpStream(EventLoop& loop, int fd, size_t maxMessageSize)
+    : m_loop(loop)
+    , m_fd(fd)
+    , m_maxMessageSize(maxMessageSize)
+{
+}
+
+TcpStream::~TcpStream()
+{
+    close();
+}
+
+bool TcpStream::isOpen()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+void TcpStream::setQueueBudget(size_t budget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_out.setBudget(budget);
+}
+
+bool TcpStream::send(const SharedBuffer& buffer)
+{
+    if (!m_lengthPrefix)
+    {
+        return send(nullptr, 0, buffer);
+    }
+
+    uint32_t size = static_cast<uint32_t>(buffer.size());
+
+    char header[HEADER_SIZE];
+    header[0] = static_cast<char>((size >> 24) & 0xFF);
+    header[1] = static_cast<char>((size >> 16) & 0xFF);
+    header[2] = static_cast<char>((size >> 8) & 0xFF);
+    header[3] = static_cast<char>(size & 0xFF);
+
+    return send(header, HEADER_SIZE, buffer);
+}
+
+bool TcpStream::send(const char* header, size_t headerSize, const SharedBuffer& body)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_open ||
+        headerSize > MAX_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    if (!m_out.push(header, headerSize, body))
+    {
+        // too slow, owner closes the stream
+        return false;
+    }
+
+    if (m_wantWrite)
+    {
+        // loop writes when the socket is writable again
+        return true;
+    }
+
+    // errors show up as EPOLLERR on the loop thread
+    _flush();
+
+    return true;
+}
+
+bool TcpStream::handleRead(const std::function<void(const char*, size_t)>& deliver)
+{
+    if (!m_lengthPrefix)
+    {
+        return handleReadRaw([this, &deliver](char* data, size_t available) -> size_t {
+
+            // continue after the bytes scanned by the last call
+            size_t scanned = m_scanner.packetSize();
+            m_scanner.scan(data + scanned, available - scanned);
+
+            if (m_scanner.hasError())
+            {
+                std::cerr << "TcpStream: malformed packet\n";
+                return CONSUME_ERROR;
+            }
+
+            if (!m_scanner.isComplete())
+            {
+                if (m_scanner.packetSize() > m_maxMessageSize)
+                {
+                    std::cerr << "TcpStream: message too big: " << m_scanner.packetSize() << "\n";
+                    return CONSUME_ERROR;
+                }
+
+                return 0;
+            }
+
+            size_t size = m_scanner.packetSize();
+            m_scanner.reset();
+
+            deliver(data, size);
+            return size;
+        });
+    }
+
+    return handleReadRaw([this, &deliver](char* data, size_t available) -> size_t {
+
+        if (available < HEADER_SIZE)
+        {
+            return 0;
+        }
+
+        const unsigned char* h = reinterpret_cast<const unsigned char*>(data);
+        size_t size = (size_t(h[0]) << 24) | (size_t(h[1]) << 16) | (size_t(h[2]) << 8) | size_t(h[3]);
+
+        if (size > m_maxMessageSize)
+        {
+            std::cerr << "TcpStream: message too big: " << size << "\n";
+            return CONSUME_ERROR;
+        }
+
+        if (available < HEADER_SIZE + size)
+        {
+            _reserve(HEADER_SIZE + size);
+            return 0;
+        }
+
+        deliver(data + HEADER_SIZE, size);
+        return HEADER_SIZE + size;
+    });
+}
+
+bool TcpStream::handleReadRaw(const Consumer& consume)
+{
+    for (size_t r = 0; r < MAX_READS; r++)
+    {
+        if (m_in.size() - m_inEnd < READ_SIZE / 4)
+        {
+            // make room: move unconsumed data to the front, then grow
+            _compact();
+
+            if (m_in.size() - m_inEnd < READ_SIZE / 4)
+            {
+                m_in.resize(m_in.size() + READ_SIZE);
+            }
+        }
+
+        ssize_t n = ::read(m_fd, m_in.data() + m_inEnd, m_in.size() - m_inEnd);
+
+        if (n == 0)
+        {
+            // closed by peer
+            return false;
+        }
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        m_inEnd += static_cast<size_t>(n);
+
+        while (m_inStart < m_inEnd)
+        {
+            size_t used = consume(m_in.data() + m_inStart, m_inEnd - m_inStart);
+
+            if (used == CONSUME_ERROR ||
+                m_fd < 0)
+            {
+                // broken or closed while consuming
+                return false;
+            }
+
+            if (used == 0)
+            {
+                break;
+            }
+
+            m_inStart += used;
+        }
+
+        if (m_inStart == m_inEnd)
+        {
+            m_inStart = 0;
+            m_inEnd = 0;
+        }
+    }
+
+    return true;
+}
+
+bool TcpStream::handleWrite()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_open)
+    {
+        return false;
+    }
+
+    return _flush();
+}
+
+void TcpStream::close()
+{
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_open)
+        {
+            return;
+        }
+
+        m_open = false;
+        m_out.clear();
+
+        fd = m_fd;
+        m_fd = -1;
+    }
+
+    m_loop.remove(fd);
+    ::close(fd);
+}
+
+size_t TcpStream::queuedMessages()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_out.messages();
+}
+
+size_t TcpStream::queuedBytes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_out.bytes();
+}
+
+OutboundQueue::Stats TcpStream::queueStats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_out.stats();
+}
+
+bool TcpStream::_flush()
+{
+    iovec iov[MAX_IOV];
+
+    while (!m_out.empty())
+    {
+        // gather as many queued messages as fit
+        size_t count = 0;
+
+        m_out.forEachSegment([&iov, &count](const char* data, size_t size) {
+            iov[count].iov_base = const_cast<char*>(data);
+            iov[count].iov_len = size;
+            count++;
+            return count < MAX_IOV;
+        });
+
+        msghdr msg{};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+
+        ssize_t n = ::sendmsg(m_fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (!m_wantWrite)
+                {
+                    m_wantWrite = true;
+                    m_loop.modify(m_fd, _events());
+                }
+                return true;
+            }
+
+            return false;
+        }
+
+        // drop what was written
+        m_out.consume(static_cast<size_t>(n));
+    }
+
+    if (m_wantWrite)
+    {
+        m_wantWrite = false;
+        m_loop.modify(m_fd, _events());
+    }
+
+    return true;
+}
+
+void TcpStream::_compact()
+{
+    if (m_inStart > 0)
+    {
+        std::memmove(m_in.data(), m_in.data() + m_inStart, m_inEnd - m_inStart);
+        m_inEnd -= m_inStart;
+        m_inStart = 0;
+    }
+}
+
+void TcpStream::_reserve(size_t size)
+{
+    // make sure a message of size fits
+    if (m_in.size() - m_inStart < size)
+    {
+        _compact();
+
+        if (m_in.size() < size)
+        {
+            m_in.resize(size);
+        }
+    }
+}
+
+uint32_t TcpStream::_events() const
+{
+    return static_cast<uint32_t>(EPOLLIN) |
+            (m_wantWrite ? static_cast<uint32_t>(EPOLLOUT) : static_cast<uint32_t>(0));
+}
+
+
+//------------------------------------------------------------------
+// TcpServerTransporter
+TcpServerTransporter::TcpServerTransporter()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+TcpServerTransporter::TcpServerTransporter(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+TcpServerTransporter::~TcpServerTransporter()
+{
+    unbind();
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+}
+
+void TcpServerTransporter::bind(int port)
+{
+    if (m_listenFd >= 0)
+    {
+        unbind();
+    }
+
+    int fd = TcpSocket::listen(m_bindAddress, port, m_port);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    m_listenFd = fd;
+    m_loop.add(fd, EPOLLIN, [this](uint32_t) { _accept(); });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+}
+
+void TcpServerTransporter::unbind()
+{
+    if (m_listenFd < 0)
+    {
+        return;
+    }
+
+    // close on the loop thread, handlers are not running concurrently
+    m_loop.invoke([this]() {
+
+        m_loop.remove(m_listenFd);
+        TcpSocket::close(m_listenFd);
+        m_listenFd = -1;
+
+        std::unordered_map<void*, TcpStreamPtr> connections;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            connections.swap(m_connections);
+        }
+
+        for (auto& kv : connections)
+        {
+            kv.second->close();
+            _clientDisconnected(kv.first);
+        }
+    });
+}
+
+void TcpServerTransporter::sendToOne(const char* data, size_t size, void* id)
+{
+    sendToOne(SharedBuffer(data, size), id);
+}
+
+void TcpServerTransporter::sendToAll(const char* data, size_t size, void* excludeId)
+{
+    sendToAll(SharedBuffer(data, size), excludeId);
+}
+
+void TcpServerTransporter::sendToOne(const SharedBuffer& buffer, void* id)
+{
+    TcpStreamPtr stream = _find(id);
+    if (stream)
+    {
+        _send(stream, buffer);
+    }
+}
+
+void TcpServerTransporter::sendToAll(const SharedBuffer& buffer, void* excludeId)
+{
+    sendToSome(buffer, [excludeId](void* id) { return id != excludeId; });
+}
+
+void TcpServerTransporter::sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter)
+{
+    std::lock_guard<std::mutex> send_lock(m_sendMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& kv : m_connections)
+        {
+            if (filter(kv.first))
+            {
+                m_sendList.push_back(kv.second);
+            }
+        }
+    }
+
+    for (auto& stream : m_sendList)
+    {
+        _send(stream, buffer);
+    }
+
+    m_sendList.clear();
+}
+
+int TcpServerTransporter::getConnectionCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_connections.size());
+}
+
+bool TcpServerTransporter::getQueueStats(void* id, OutboundQueue::Stats& stats)
+{
+    TcpStreamPtr stream = _find(id);
+    if (!stream)
+    {
+        return false;
+    }
+
+    stats = stream->queueStats();
+    return true;
+}
+
+void TcpServerTransporter::_accept()
+{
+    while (true)
+    {
+        int fd = TcpSocket::accept(m_listenFd);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        TcpSocket::setNoDelay(fd, m_noDelay);
+
+        TcpStreamPtr stream = std::make_shared<TcpStream>(m_loop, fd, m_maxMessageSize);
+        stream->setLengthPrefix(m_lengthPrefix);
+        stream->setQueueBudget(m_queueBudget);
+
+        // register before sending is possible
+        std::weak_ptr<TcpStream> weak = stream;
+        m_loop.add(fd, EPOLLIN, [this, weak](uint32_t events) {
+            TcpStreamPtr s = weak.lock();
+            if (s)
+            {
+                _handle(s, events);
+            }
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_connections[stream.get()] = stream;
+        }
+
+        _clientConnected(stream.get());
+    }
+}
+
+void TcpServerTransporter::_handle(const TcpStreamPtr& stream, uint32_t events)
+{
+    if ((events & EPOLLIN) ||
+        (events & EPOLLHUP))
+    {
+        void* id = stream.get();
+        bool ok = stream->handleRead([this, id](const char* data, size_t size) {
+            _received(data, size, id);
+        });
+
+        if (!ok)
+        {
+            _close(stream);
+            return;
+        }
+    }
+
+    if (events & EPOLLERR)
+    {
+        _close(stream);
+        return;
+    }
+
+    if (events & EPOLLOUT)
+    {
+        if (!stream->handleWrite())
+        {
+            _close(stream);
+        }
+    }
+}
+
+void TcpServerTransporter::_close(const TcpStreamPtr& stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connections.erase(stream.get()) == 0)
+        {
+            return;
+        }
+    }
+
+    stream->close();
+    _clientDisconnected(stream.get());
+}
+
+void TcpServerTransporter::_send(const TcpStreamPtr& stream, const SharedBuffer& buffer)
+{
+    if (stream->send(buffer) ||
+        !stream->isOpen())
+    {
+        return;
+    }
+
+    // over budget: close on the loop thread without waiting for it,
+    // the sender goes on with the other connections
+    std::weak_ptr<TcpStream> weak = stream;
+    m_loop.post([this, weak]() {
+        TcpStreamPtr s = weak.lock();
+        if (s &&
+            s->isOpen())
+        {
+            std::cerr << "TcpServerTransporter: closing slow connection, queued bytes: " << s->queuedBytes() << "\n";
+            m_slowConsumers++;
+            _close(s);
+        }
+    });
+}
+
+TcpStreamPtr TcpServerTransporter::_find(void* id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_connections.find(id);
+    if (it != m_connections.end())
+    {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
+
+//------------------------------------------------------------------
+// TcpClientTransporter
+TcpClientTransporter::TcpClientTransporter()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+TcpClientTransporter::TcpClientTransporter(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+TcpClientTransporter::~TcpClientTransporter()
+{
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+
+    TcpStreamPtr stream;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stream.swap(m_stream);
+    }
+
+    // no notification, listeners might be gone already
+    if (stream)
+    {
+        stream->close();
+    }
+}
+
+void TcpClientTransporter::connect(std::string host, int port, bool secure)
+{
+    if (secure)
+    {
+        std::cerr << "TcpClientTransporter: secure connections are not supported\n";
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stream)
+        {
+            // connected or connecting
+            return;
+        }
+    }
+
+    int fd = TcpSocket::connect(host, port);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    TcpSocket::setNoDelay(fd, m_noDelay);
+
+    TcpStreamPtr stream = std::make_shared<TcpStream>(m_loop, fd, m_maxMessageSize);
+    stream->setLengthPrefix(m_lengthPrefix);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stream = stream;
+    }
+
+    // writable when connected
+    std::weak_ptr<TcpStream> weak = stream;
+    m_loop.add(fd, EPOLLOUT, [this, weak](uint32_t events) {
+        TcpStreamPtr s = weak.lock();
+        if (s)
+        {
+            _handle(s, events);
+        }
+    });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+}
+
+void TcpClientTransporter::disconnect()
+{
+    TcpStreamPtr stream;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stream = m_stream;
+    }
+
+    if (stream)
+    {
+        m_loop.invoke([this, stream]() { _close(stream); });
+    }
+}
+
+bool TcpClientTransporter::isConnected()
+{
+    return m_connected.load(std::memory_order_acquire);
+}
+
+void TcpClientTransporter::send(const char* data, size_t size)
+{
+    send(SharedBuffer(data, size));
+}
+
+void TcpClientTransporter::send(const SharedBuffer& buffer)
+{
+    if (!m_connected.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    TcpStreamPtr stream;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stream = m_stream;
+    }
+
+    if (stream)
+    {
+        stream->send(buffer);
+    }
+}
+
+void TcpClientTransporter::_handle(const TcpStreamPtr& stream, uint32_t events)
+{
+    if (!m_connected.load(std::memory_order_acquire))
+    {
+        // connect finished
+        int error = TcpSocket::connectError(stream->fd());
+
+        if (error != 0 ||
+            (events & (EPOLLERR | EPOLLHUP)))
+        {
+            std::cerr << "TcpClientTransporter: connect failed: " << error << "\n";
+            _close(stream);
+            return;
+        }
+
+        m_loop.modify(stream->fd(), EPOLLIN);
+        m_connected.store(true, std::memory_order_release);
+
+        _connected();
+        return;
+    }
+
+    if ((events & EPOLLIN) ||
+        (events & EPOLLHUP))
+    {
+        bool ok = stream->handleRead([this](const char* data, size_t size) {
+            _received(data, size);
+        });
+
+        if (!ok)
+        {
+            _close(stream);
+            return;
+        }
+    }
+
+    if (events & EPOLLERR)
+    {
+        _close(stream);
+        return;
+    }
+
+    if (events & EPOLLOUT)
+    {
+        if (!stream->handleWrite())
+        {
+            _close(stream);
+        }
+    }
+}
+
+void TcpClientTransporter::_close(const TcpStreamPtr& stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stream != stream)
+        {
+            return;
+        }
+        m_stream.reset();
+    }
+
+    bool was_connected = m_connected.exchange(false);
+
+    stream->close();
+
+    if (was_connected)
+    {
+        _disconnected();
+    }
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,311 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_TCPTRANSPORTER_H
+#define RCP_TCPTRANSPORTER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "servertransporter.h"
+#include "clienttransporter.h"
+#include "sharedbuffer.h"
+#include "eventloop.h"
+#include "outboundqueue.h"
+#include "packetscanner.h"
+
+namespace rcp {
+
+/*
+* TcpSocket - non-blocking socket setup
+*
+* all functions return -1 on error.
+*/
+class TcpSocket
+{
+public:
+    // listening socket, empty address: all interfaces
+    static int listen(const std::string& address, int port, int& boundPort);
+    // started connect, finished when writable
+    static int connect(const std::string& host, int port);
+    static int accept(int listenFd);
+    // error of a finished connect, 0 on success
+    static int connectError(int fd);
+    static void setNoDelay(int fd, bool noDelay);
+    static void close(int fd);
+};
+
+
+/*
+* TcpStream - non-blocking socket with length-prefixed messages
+*
+* every message is sent with a 4 byte big-endian length prefix.
+* outgoing messages are queued as refcounted buffers and written
+* with one scatter/gather call per batch.
+* incoming messages are delivered straight from the read buffer.
+*
+* the raw interface (header + body, consume) lets other protocols
+* use their own framing on top of the same socket handling.
+*
+* without length prefix packets are sent as they are. incoming packets
+* are found with a PacketScanner while they stay in the read buffer,
+* bytes of a packet split over several reads are scanned once.
+*
+* with a queue budget a stream not keeping up with its messages
+* has its queue collapsed (see OutboundQueue), if that is not enough
+* send() fails and the owner closes the stream.
+*
+* send() is thread safe, reading is done on the loop thread.
+*/
+class TcpStream
+{
+public:
+    static const size_t HEADER_SIZE = 4;
+    static const size_t MAX_HEADER_SIZE = OutboundQueue::MAX_HEADER_SIZE;
+    static const size_t DEFAULT_MAX_MESSAGE_SIZE = 16 * 1024 * 1024;
+    // returned by a consume function to close the stream
+    static const size_t CONSUME_ERROR = static_cast<size_t>(-1);
+
+    // consume(data, size) returns the number of bytes it used,
+    // 0 if it needs more data, CONSUME_ERROR on error
+    // data may be modified in place
+    typedef std::function<size_t(char*, size_t)> Consumer;
+
+public:
+    TcpStream(EventLoop& loop, int fd, size_t maxMessageSize);
+    ~TcpStream();
+
+    TcpStream(const TcpStream&) = delete;
+    TcpStream& operator=(const TcpStream&) = delete;
+
+    int fd() const { return m_fd; }
+    bool isOpen();
+
+    // default: true, call before sending or reading
+    void setLengthPrefix(bool lengthPrefix) { m_lengthPrefix = lengthPrefix; }
+
+    // queued bytes allowed, 0: unlimited (default)
+    void setQueueBudget(size_t budget);
+
+    // queue and try to write
+    // returns false if closed or the queue is over budget
+    bool send(const SharedBuffer& buffer);
+
+    // raw: queue header (at most MAX_HEADER_SIZE bytes) followed by body
+    bool send(const char* header, size_t headerSize, const SharedBuffer& body);
+
+    // read available data, deliver(const char*, size_t) per message
+    // returns false if the stream was closed or is broken
+    bool handleRead(const std::function<void(const char*, size_t)>& deliver);
+
+    // raw: read available data and pass all unconsumed bytes to consume
+    bool handleReadRaw(const Consumer& consume);
+
+    // write queued data, returns false if broken
+    bool handleWrite();
+
+    // remove from loop and close socket
+    void close();
+
+    size_t queuedMessages();
+    size_t queuedBytes();
+    OutboundQueue::Stats queueStats();
+
+private:
+    bool _flush();
+    void _compact();
+    void _reserve(size_t size);
+    uint32_t _events() const;
+
+    EventLoop& m_loop;
+    int m_fd;
+    size_t m_maxMessageSize;
+    bool m_lengthPrefix{true};
+
+    std::mutex m_mutex;
+    bool m_open{true};
+    OutboundQueue m_out;
+    bool m_wantWrite{false};
+
+    // loop thread only
+    std::vector<char> m_in;
+    size_t m_inStart{0};
+    size_t m_inEnd{0};
+    PacketScanner m_scanner;
+};
+
+typedef std::shared_ptr<TcpStream> TcpStreamPtr;
+
+
+/*
+* TcpServerTransporter - epoll based tcp server
+*
+* all connections are served by one event loop thread.
+* the connection id passed to receivers is the TcpStream.
+*
+* with the default constructor the transporter runs its own loop thread,
+* with an EventLoop the application runs the loop.
+*/
+class TcpServerTransporter : public ServerTransporter
+{
+public:
+    TcpServerTransporter();
+    TcpServerTransporter(EventLoop& loop);
+    ~TcpServerTransporter();
+
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    // ServerTransporter
+    void bind(int port) override;
+    void unbind() override;
+
+    void sendToOne(const char* data, size_t size, void* id) override;
+    void sendToAll(const char* data, size_t size, void* excludeId) override;
+    void sendToOne(const SharedBuffer& buffer, void* id) override;
+    void sendToAll(const SharedBuffer& buffer, void* excludeId) override;
+    void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter) override;
+
+    int getConnectionCount() override;
+
+public:
+    // address to bind to, default: all interfaces
+    // call before bind()
+    void setBindAddress(const std::string& address) { m_bindAddress = address; }
+
+    // disable nagle, default: true
+    void setNoDelay(bool noDelay) { m_noDelay = noDelay; }
+    bool getNoDelay() const { return m_noDelay; }
+
+    // connections sending bigger messages are closed
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    // send packets without length prefix, see TcpStream
+    // both sides need the same setting, call before bind()
+    void setLengthPrefix(bool lengthPrefix) { m_lengthPrefix = lengthPrefix; }
+    bool getLengthPrefix() const { return m_lengthPrefix; }
+
+    // outbound bytes queued per connection, 0: unlimited
+    // value updates are collapsed when a connection exceeds it,
+    // connections still over budget are closed as too slow
+    // call before bind()
+    void setQueueBudget(size_t budget) { m_queueBudget = budget; }
+    size_t getQueueBudget() const { return m_queueBudget; }
+
+    // queue state of connection id, false if not connected
+    bool getQueueStats(void* id, OutboundQueue::Stats& stats);
+    // connections closed for exceeding the queue budget
+    size_t slowConsumerCount() const { return m_slowConsumers; }
+
+    bool isBound() const { return m_listenFd >= 0; }
+    // bound port, useful after bind(0)
+    int getPort() const { return m_port; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _accept();
+    void _handle(const TcpStreamPtr& stream, uint32_t events);
+    void _close(const TcpStreamPtr& stream);
+    void _send(const TcpStreamPtr& stream, const SharedBuffer& buffer);
+    TcpStreamPtr _find(void* id);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    std::string m_bindAddress;
+    bool m_noDelay{true};
+    size_t m_maxMessageSize{TcpStream::DEFAULT_MAX_MESSAGE_SIZE};
+    bool m_lengthPrefix{true};
+    size_t m_queueBudget{0};
+    std::atomic<size_t> m_slowConsumers{0};
+
+    int m_listenFd{-1};
+    int m_port{0};
+
+    std::mutex m_mutex;
+    std::unordered_map<void*, TcpStreamPtr> m_connections;
+    std::mutex m_sendMutex;
+    std::vector<TcpStreamPtr> m_sendList;
+};
+
+
+/*
+* TcpClientTransporter - epoll based tcp client
+*
+* connects non-blocking, connected() is called from the loop thread.
+* secure connections are not supported.
+*/
+class TcpClientTransporter : public ClientTransporter
+{
+public:
+    TcpClientTransporter();
+    TcpClientTransporter(EventLoop& loop);
+    ~TcpClientTransporter();
+
+    using ClientTransporter::send;
+
+    // ClientTransporter
+    void connect(std::string host, int port, bool secure = false) override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    void send(const char* data, size_t size) override;
+    void send(const SharedBuffer& buffer) override;
+
+public:
+    // disable nagle, default: true
+    void setNoDelay(bool noDelay) { m_noDelay = noDelay; }
+    bool getNoDelay() const { return m_noDelay; }
+
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    // send packets without length prefix, call before connect()
+    void setLengthPrefix(bool lengthPrefix) { m_lengthPrefix = lengthPrefix; }
+    bool getLengthPrefix() const { return m_lengthPrefix; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _handle(const TcpStreamPtr& stream, uint32_t events);
+    void _close(const TcpStreamPtr& stream);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    bool m_noDelay{true};
+    size_t m_maxMessageSize{TcpStream::DEFAULT_MAX_MESSAGE_SIZE};
+    bool m_lengthPrefix{true};
+
+    std::mutex m_mutex;
+    TcpStreamPtr m_stream;
+    std::atomic<bool> m_connected{false};
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_TCPTRANSPORTER_H
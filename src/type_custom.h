@@ -69,7 +69,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
         std::lock_guard<std::recursive_mutex> locker(obj->parameter.mutex());
@@ -189,7 +190,8 @@ public:
     //------------------------------------
     // IDefaultDefinition<T>
 
-    std::vector<char> readValue(std::istream& is) override
+    using IDefaultDefinition<std::vector<char>>::readValue;
+    std::vector<char> readValue(ByteReader& is) override
     {
         std::vector<char> data(obj->size);
         is.read(data.data(), obj->size);
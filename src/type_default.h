@@ -94,9 +94,11 @@ public:
     //------------------------------------
     // IDefaultDefinition<T>
 
-    T readValue(std::istream& is) override
+    using IDefaultDefinition<T>::readValue;
+    T readValue(ByteReader& is) override
     {
-        T value = readFromStream(is, value);
+        T value{};
+        value = readFromStream(is, value);
         return value;
     }
 
@@ -159,7 +161,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
         std::lock_guard<std::recursive_mutex> locker(obj->parameter.mutex());
@@ -107,7 +107,8 @@ public:
     //------------------------------------
     // IDefaultDefinition
 
-    TinyString readValue(std::istream& is) override
+    using IDefaultDefinition<TinyString>::readValue;
+    TinyString readValue(ByteReader& is) override
     {
         return readTinyString(is);
     }
@@ -277,7 +278,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
         std::lock_guard<std::recursive_mutex> locker(obj->parameter.mutex());
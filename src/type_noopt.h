@@ -71,7 +71,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
         // no options - expect terminator
 
@@ -165,7 +165,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
         std::lock_guard<std::recursive_mutex> locker(obj->parameter.mutex());
@@ -240,9 +241,11 @@ public:
 
     //------------------------------------
     // IDefaultDefinition
-    T readValue(std::istream& is) override
+    using IDefaultDefinition<T>::readValue;
+    T readValue(ByteReader& is) override
     {
-        T val = readFromStream(is, val);
+        T val{};
+        val = readFromStream(is, val);
         return val;
     }
 
@@ -137,7 +137,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
         std::lock_guard<std::recursive_mutex> locker(obj->parameter.mutex());
@@ -180,10 +181,13 @@ public:
 
     //------------------------------------
     // IDefaultDefinition<T>
-    Range<ElementType> readValue(std::istream& is) override
+    using IDefaultDefinition<Range<ElementType>>::readValue;
+    Range<ElementType> readValue(ByteReader& is) override
     {
-        ElementType v1 = readFromStream(is, v1);
-        ElementType v2 = readFromStream(is, v2);
+        ElementType v1{};
+        v1 = readFromStream(is, v1);
+        ElementType v2{};
+        v2 = readFromStream(is, v2);
         return Range<ElementType>(v1, v2);
     }
 
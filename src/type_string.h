@@ -65,7 +65,8 @@ public:
 
     //------------------------------------
     // IOptionparser
-    void parseOptions(std::istream& is) override
+    using IOptionparser::parseOptions;
+    void parseOptions(ByteReader& is) override
     {
 #ifndef RCP_PARAMETER_NO_LOCKING
         std::lock_guard<std::recursive_mutex> locker(obj->parameter.mutex());
@@ -154,7 +155,8 @@ public:
     //------------------------------------
     // IDefaultDefinition
 
-    std::string readValue(std::istream& is) override
+    using IDefaultDefinition<std::string>::readValue;
+    std::string readValue(ByteReader& is) override
     {
         return readLongString(is);
     }
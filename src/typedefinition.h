@@ -52,7 +52,12 @@ public:
     virtual bool hasDefault() const = 0;
     virtual void clearDefault() = 0;
 
-    virtual T readValue(std::istream& is) = 0;
+    virtual T readValue(ByteReader& is) = 0;
+
+    T readValue(std::istream& is) {
+        ByteReader reader(is);
+        return readValue(reader);
+    }
 };
 
 
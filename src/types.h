@@ -124,6 +124,8 @@ enum command_t {
     COMMAND_UPDATE = 4,
     COMMAND_REMOVE = 5,
     COMMAND_UPDATEVALUE = 6,
+    // extension of this implementation, see SubscriptionData
+    COMMAND_SUBSCRIBE = 7,
     COMMAND_MAX_
 };
 
@@ -175,6 +177,11 @@ enum infodata_options_t {
     INFODATA_OPTIONS_APPLICATIONID = 26
 };
 
+enum subscription_options_t {
+    SUBSCRIPTION_OPTIONS_GROUP = 1,
+    SUBSCRIPTION_OPTIONS_TAG = 2
+};
+
 enum array_options_t {
     ARRAY_OPTIONS_DEFAULT = 48
 };
@@ -0,0 +1,788 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "unixtransporter.h"
+
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace rcp {
+
+// messages per write call
+static const size_t MAX_SEND_BATCH = 64;
+// receive calls per readable event, so one busy connection can not starve others
+static const size_t MAX_READS = 16;
+
+static bool makeAddress(const std::string& path, sockaddr_un& addr, socklen_t& length)
+{
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+
+    if (path.empty() ||
+        path.size() >= sizeof(addr.sun_path))
+    {
+        std::cerr << "UnixTransporter: invalid path: " << path << "\n";
+        return false;
+    }
+
+    std::memcpy(addr.sun_path, path.data(), path.size());
+
+    if (path[0] == '@')
+    {
+        // abstract namespace, no terminating zero
+        addr.sun_path[0] = '\0';
+        length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+    }
+    else
+    {
+        length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+    }
+
+    return true;
+}
+
+// messages have to fit into the send buffer
+static void setSendBuffer(int fd, size_t maxMessageSize)
+{
+    int size = static_cast<int>(maxMessageSize * 2);
+    setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+}
+
+
+//------------------------------------------------------------------
+// UnixReceiveBuffers
+UnixReceiveBuffers::UnixReceiveBuffers(size_t maxMessageSize)
+    : m_maxMessageSize(maxMessageSize)
+    , m_data(new char[BATCH_SIZE * maxMessageSize])
+{
+}
+
+
+//------------------------------------------------------------------
+// UnixConnection
+UnixConnection::UnixConnection(EventLoop& loop, int fd)
+    : m_loop(loop)
+    , m_fd(fd)
+{
+}
+
+UnixConnection::~UnixConnection()
+{
+    close();
+}
+
+bool UnixConnection::isOpen()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_open;
+}
+
+bool UnixConnection::send(const SharedBuffer& buffer)
+{
+    if (buffer.size() == 0)
+    {
+        // an empty message reads like a closed socket
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_open)
+    {
+        return false;
+    }
+
+    m_out.push_back(buffer);
+
+    if (m_wantWrite)
+    {
+        // loop writes when the socket is writable again
+        return true;
+    }
+
+    // errors show up as EPOLLERR on the loop thread
+    _flush();
+
+    return true;
+}
+
+bool UnixConnection::handleRead(UnixReceiveBuffers& buffers, const std::function<void(const char*, size_t)>& deliver)
+{
+    mmsghdr messages[UnixReceiveBuffers::BATCH_SIZE];
+    iovec iov[UnixReceiveBuffers::BATCH_SIZE];
+
+    for (size_t r = 0; r < MAX_READS; r++)
+    {
+        std::memset(messages, 0, sizeof(messages));
+        for (size_t i = 0; i < UnixReceiveBuffers::BATCH_SIZE; i++)
+        {
+            iov[i].iov_base = buffers.buffer(i);
+            iov[i].iov_len = buffers.maxMessageSize();
+            messages[i].msg_hdr.msg_iov = &iov[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int n = ::recvmmsg(m_fd, messages, UnixReceiveBuffers::BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+        if (n == 0)
+        {
+            // closed by peer
+            return false;
+        }
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            if (messages[i].msg_len == 0)
+            {
+                // closed by peer
+                return false;
+            }
+
+            if (messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+            {
+                std::cerr << "UnixConnection: message too big\n";
+                return false;
+            }
+
+            deliver(buffers.buffer(i), messages[i].msg_len);
+
+            if (m_fd < 0)
+            {
+                // closed while delivering
+                return false;
+            }
+        }
+
+        if (static_cast<size_t>(n) < UnixReceiveBuffers::BATCH_SIZE)
+        {
+            // drained
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool UnixConnection::handleWrite()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_open)
+    {
+        return false;
+    }
+
+    return _flush();
+}
+
+void UnixConnection::close()
+{
+    int fd;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_open)
+        {
+            return;
+        }
+
+        m_open = false;
+        m_out.clear();
+
+        fd = m_fd;
+        m_fd = -1;
+    }
+
+    m_loop.remove(fd);
+    ::close(fd);
+}
+
+size_t UnixConnection::queuedMessages()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_out.size();
+}
+
+bool UnixConnection::_flush()
+{
+    mmsghdr messages[MAX_SEND_BATCH];
+    iovec iov[MAX_SEND_BATCH];
+
+    while (!m_out.empty())
+    {
+        size_t count = 0;
+        for (auto it = m_out.begin(); it != m_out.end() && count < MAX_SEND_BATCH; ++it)
+        {
+            iov[count].iov_base = const_cast<char*>(it->data());
+            iov[count].iov_len = it->size();
+
+            std::memset(&messages[count], 0, sizeof(mmsghdr));
+            messages[count].msg_hdr.msg_iov = &iov[count];
+            messages[count].msg_hdr.msg_iovlen = 1;
+            count++;
+        }
+
+        int n = ::sendmmsg(m_fd, messages, static_cast<unsigned int>(count), MSG_NOSIGNAL | MSG_DONTWAIT);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                if (!m_wantWrite)
+                {
+                    m_wantWrite = true;
+                    m_loop.modify(m_fd, _events());
+                }
+                return true;
+            }
+
+            if (errno == EMSGSIZE)
+            {
+                // never fits, drop it
+                std::cerr << "UnixConnection: message too big: " << m_out.front().size() << "\n";
+                m_out.pop_front();
+                continue;
+            }
+
+            return false;
+        }
+
+        // datagrams are sent completely or not at all
+        m_out.erase(m_out.begin(), m_out.begin() + n);
+    }
+
+    if (m_wantWrite)
+    {
+        m_wantWrite = false;
+        m_loop.modify(m_fd, _events());
+    }
+
+    return true;
+}
+
+uint32_t UnixConnection::_events() const
+{
+    return static_cast<uint32_t>(EPOLLIN) |
+            (m_wantWrite ? static_cast<uint32_t>(EPOLLOUT) : static_cast<uint32_t>(0));
+}
+
+
+//------------------------------------------------------------------
+// UnixServerTransporter
+std::string UnixServerTransporter::defaultPath(int port)
+{
+    return "@rcp-" + std::to_string(port);
+}
+
+UnixServerTransporter::UnixServerTransporter()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+UnixServerTransporter::UnixServerTransporter(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+UnixServerTransporter::~UnixServerTransporter()
+{
+    unbind();
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+}
+
+void UnixServerTransporter::bind(int port)
+{
+    if (m_listenFd >= 0)
+    {
+        unbind();
+    }
+
+    std::string path = m_path.empty() ? defaultPath(port) : m_path;
+
+    sockaddr_un addr;
+    socklen_t length;
+    if (!makeAddress(path, addr, length))
+    {
+        return;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        std::cerr << "UnixServerTransporter: socket failed: " << errno << "\n";
+        return;
+    }
+
+    if (path[0] != '@')
+    {
+        // socket file of a previous server
+        ::unlink(path.c_str());
+    }
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), length) != 0 ||
+        ::listen(fd, SOMAXCONN) != 0)
+    {
+        std::cerr << "UnixServerTransporter: could not bind to " << path << ": " << errno << "\n";
+        ::close(fd);
+        return;
+    }
+
+    m_boundPath = path;
+    m_port = port;
+    m_buffers.reset(new UnixReceiveBuffers(m_maxMessageSize));
+
+    m_listenFd = fd;
+    m_loop.add(fd, EPOLLIN, [this](uint32_t) { _accept(); });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+}
+
+void UnixServerTransporter::unbind()
+{
+    if (m_listenFd < 0)
+    {
+        return;
+    }
+
+    // close on the loop thread, handlers are not running concurrently
+    m_loop.invoke([this]() {
+
+        m_loop.remove(m_listenFd);
+        ::close(m_listenFd);
+        m_listenFd = -1;
+
+        if (m_boundPath[0] != '@')
+        {
+            ::unlink(m_boundPath.c_str());
+        }
+
+        std::unordered_map<void*, UnixConnectionPtr> connections;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            connections.swap(m_connections);
+        }
+
+        for (auto& kv : connections)
+        {
+            kv.second->close();
+            _clientDisconnected(kv.first);
+        }
+    });
+}
+
+void UnixServerTransporter::sendToOne(const char* data, size_t size, void* id)
+{
+    sendToOne(SharedBuffer(data, size), id);
+}
+
+void UnixServerTransporter::sendToAll(const char* data, size_t size, void* excludeId)
+{
+    sendToAll(SharedBuffer(data, size), excludeId);
+}
+
+void UnixServerTransporter::sendToOne(const SharedBuffer& buffer, void* id)
+{
+    UnixConnectionPtr connection = _find(id);
+    if (connection)
+    {
+        connection->send(buffer);
+    }
+}
+
+void UnixServerTransporter::sendToAll(const SharedBuffer& buffer, void* excludeId)
+{
+    sendToSome(buffer, [excludeId](void* id) { return id != excludeId; });
+}
+
+void UnixServerTransporter::sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter)
+{
+    std::lock_guard<std::mutex> send_lock(m_sendMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& kv : m_connections)
+        {
+            if (filter(kv.first))
+            {
+                m_sendList.push_back(kv.second);
+            }
+        }
+    }
+
+    for (auto& connection : m_sendList)
+    {
+        connection->send(buffer);
+    }
+
+    m_sendList.clear();
+}
+
+int UnixServerTransporter::getConnectionCount()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return static_cast<int>(m_connections.size());
+}
+
+void UnixServerTransporter::_accept()
+{
+    while (true)
+    {
+        int fd = ::accept4(m_listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            // EAGAIN or out of descriptors, try again on next event
+            return;
+        }
+
+        setSendBuffer(fd, m_maxMessageSize);
+
+        UnixConnectionPtr connection = std::make_shared<UnixConnection>(m_loop, fd);
+
+        // register before sending is possible
+        std::weak_ptr<UnixConnection> weak = connection;
+        m_loop.add(fd, EPOLLIN, [this, weak](uint32_t events) {
+            UnixConnectionPtr c = weak.lock();
+            if (c)
+            {
+                _handle(c, events);
+            }
+        });
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_connections[connection.get()] = connection;
+        }
+
+        _clientConnected(connection.get());
+    }
+}
+
+void UnixServerTransporter::_handle(const UnixConnectionPtr& connection, uint32_t events)
+{
+    if ((events & EPOLLIN) ||
+        (events & EPOLLHUP))
+    {
+        void* id = connection.get();
+        bool ok = connection->handleRead(*m_buffers, [this, id](const char* data, size_t size) {
+            _received(data, size, id);
+        });
+
+        if (!ok)
+        {
+            _close(connection);
+            return;
+        }
+    }
+
+    if (events & EPOLLERR)
+    {
+        _close(connection);
+        return;
+    }
+
+    if (events & EPOLLOUT)
+    {
+        if (!connection->handleWrite())
+        {
+            _close(connection);
+        }
+    }
+}
+
+void UnixServerTransporter::_close(const UnixConnectionPtr& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connections.erase(connection.get()) == 0)
+        {
+            return;
+        }
+    }
+
+    connection->close();
+    _clientDisconnected(connection.get());
+}
+
+UnixConnectionPtr UnixServerTransporter::_find(void* id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_connections.find(id);
+    if (it != m_connections.end())
+    {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
+
+//------------------------------------------------------------------
+// UnixClientTransporter
+UnixClientTransporter::UnixClientTransporter()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+UnixClientTransporter::UnixClientTransporter(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+UnixClientTransporter::~UnixClientTransporter()
+{
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+
+    UnixConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection.swap(m_connection);
+    }
+
+    // no notification, listeners might be gone already
+    if (connection)
+    {
+        connection->close();
+    }
+}
+
+void UnixClientTransporter::connect(std::string host, int port, bool secure)
+{
+    if (secure)
+    {
+        std::cerr << "UnixClientTransporter: secure connections are not supported\n";
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connection)
+        {
+            // connected or connecting
+            return;
+        }
+    }
+
+    std::string path = (!host.empty() && (host[0] == '/' || host[0] == '@')) ?
+                host : UnixServerTransporter::defaultPath(port);
+
+    sockaddr_un addr;
+    socklen_t length;
+    if (!makeAddress(path, addr, length))
+    {
+        return;
+    }
+
+    int fd = ::socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        std::cerr << "UnixClientTransporter: socket failed: " << errno << "\n";
+        return;
+    }
+
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), length) != 0)
+    {
+        std::cerr << "UnixClientTransporter: could not connect to " << path << ": " << errno << "\n";
+        ::close(fd);
+        return;
+    }
+
+    setSendBuffer(fd, m_maxMessageSize);
+
+    if (!m_buffers ||
+        m_buffers->maxMessageSize() != m_maxMessageSize)
+    {
+        m_buffers.reset(new UnixReceiveBuffers(m_maxMessageSize));
+    }
+
+    UnixConnectionPtr connection = std::make_shared<UnixConnection>(m_loop, fd);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connection = connection;
+    }
+
+    // connected() from the loop thread when writable
+    std::weak_ptr<UnixConnection> weak = connection;
+    m_loop.add(fd, EPOLLOUT, [this, weak](uint32_t events) {
+        UnixConnectionPtr c = weak.lock();
+        if (c)
+        {
+            _handle(c, events);
+        }
+    });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+}
+
+void UnixClientTransporter::disconnect()
+{
+    UnixConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection = m_connection;
+    }
+
+    if (connection)
+    {
+        m_loop.invoke([this, connection]() { _close(connection); });
+    }
+}
+
+bool UnixClientTransporter::isConnected()
+{
+    return m_connected.load(std::memory_order_acquire);
+}
+
+void UnixClientTransporter::send(const char* data, size_t size)
+{
+    send(SharedBuffer(data, size));
+}
+
+void UnixClientTransporter::send(const SharedBuffer& buffer)
+{
+    if (!m_connected.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    UnixConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection = m_connection;
+    }
+
+    if (connection)
+    {
+        connection->send(buffer);
+    }
+}
+
+void UnixClientTransporter::_handle(const UnixConnectionPtr& connection, uint32_t events)
+{
+    if (!m_connected.load(std::memory_order_acquire))
+    {
+        if (events & (EPOLLERR | EPOLLHUP))
+        {
+            _close(connection);
+            return;
+        }
+
+        m_loop.modify(connection->fd(), EPOLLIN);
+        m_connected.store(true, std::memory_order_release);
+
+        _connected();
+        return;
+    }
+
+    if ((events & EPOLLIN) ||
+        (events & EPOLLHUP))
+    {
+        bool ok = connection->handleRead(*m_buffers, [this](const char* data, size_t size) {
+            _received(data, size);
+        });
+
+        if (!ok)
+        {
+            _close(connection);
+            return;
+        }
+    }
+
+    if (events & EPOLLERR)
+    {
+        _close(connection);
+        return;
+    }
+
+    if (events & EPOLLOUT)
+    {
+        if (!connection->handleWrite())
+        {
+            _close(connection);
+        }
+    }
+}
+
+void UnixClientTransporter::_close(const UnixConnectionPtr& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connection != connection)
+        {
+            return;
+        }
+        m_connection.reset();
+    }
+
+    bool was_connected = m_connected.exchange(false);
+
+    connection->close();
+
+    if (was_connected)
+    {
+        _disconnected();
+    }
+}
+
+}
+
+#endif // __linux__
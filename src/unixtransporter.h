@@ -0,0 +1,240 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_UNIXTRANSPORTER_H
+#define RCP_UNIXTRANSPORTER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "servertransporter.h"
+#include "clienttransporter.h"
+#include "sharedbuffer.h"
+#include "eventloop.h"
+
+namespace rcp {
+
+/*
+* UnixReceiveBuffers - message buffers for batched receives
+*
+* used on the loop thread only, shared by all connections of a transporter.
+*/
+class UnixReceiveBuffers
+{
+public:
+    static const size_t BATCH_SIZE = 16;
+
+public:
+    UnixReceiveBuffers(size_t maxMessageSize);
+
+    UnixReceiveBuffers(const UnixReceiveBuffers&) = delete;
+    UnixReceiveBuffers& operator=(const UnixReceiveBuffers&) = delete;
+
+    size_t maxMessageSize() const { return m_maxMessageSize; }
+    char* buffer(size_t index) { return m_data.get() + index * m_maxMessageSize; }
+
+private:
+    size_t m_maxMessageSize;
+    std::unique_ptr<char[]> m_data;
+};
+
+
+/*
+* UnixConnection - non-blocking SOCK_SEQPACKET socket
+*
+* the socket keeps message boundaries, packets are sent without framing.
+* outgoing messages are queued as refcounted buffers and written with
+* one sendmmsg call per batch, incoming messages are read with recvmmsg.
+*
+* send() is thread safe, reading is done on the loop thread.
+*/
+class UnixConnection
+{
+public:
+    UnixConnection(EventLoop& loop, int fd);
+    ~UnixConnection();
+
+    UnixConnection(const UnixConnection&) = delete;
+    UnixConnection& operator=(const UnixConnection&) = delete;
+
+    int fd() const { return m_fd; }
+    bool isOpen();
+
+    // queue and try to write, returns false if closed
+    bool send(const SharedBuffer& buffer);
+
+    // read available messages, deliver(const char*, size_t) per message
+    // returns false if the socket was closed or is broken
+    bool handleRead(UnixReceiveBuffers& buffers, const std::function<void(const char*, size_t)>& deliver);
+
+    // write queued messages, returns false if broken
+    bool handleWrite();
+
+    // remove from loop and close socket
+    void close();
+
+    size_t queuedMessages();
+
+private:
+    bool _flush();
+    uint32_t _events() const;
+
+    EventLoop& m_loop;
+    int m_fd;
+
+    std::mutex m_mutex;
+    bool m_open{true};
+    std::deque<SharedBuffer> m_out;
+    bool m_wantWrite{false};
+};
+
+typedef std::shared_ptr<UnixConnection> UnixConnectionPtr;
+
+
+/*
+* UnixServerTransporter - unix domain socket server (SOCK_SEQPACKET)
+*
+* the socket path is defaultPath(port) unless set with setPath().
+* paths starting with '@' are in the abstract namespace and do not
+* show up in the file system.
+*
+* all connections are served by one event loop thread.
+* the connection id passed to receivers is the UnixConnection.
+*/
+class UnixServerTransporter : public ServerTransporter
+{
+public:
+    // messages have to fit into the socket send buffer
+    static const size_t DEFAULT_MAX_MESSAGE_SIZE = 128 * 1024;
+
+    static std::string defaultPath(int port);
+
+public:
+    UnixServerTransporter();
+    UnixServerTransporter(EventLoop& loop);
+    ~UnixServerTransporter();
+
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    // ServerTransporter
+    void bind(int port) override;
+    void unbind() override;
+
+    void sendToOne(const char* data, size_t size, void* id) override;
+    void sendToAll(const char* data, size_t size, void* excludeId) override;
+    void sendToOne(const SharedBuffer& buffer, void* id) override;
+    void sendToAll(const SharedBuffer& buffer, void* excludeId) override;
+    void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter) override;
+
+    int getConnectionCount() override;
+
+public:
+    // socket path, call before bind()
+    void setPath(const std::string& path) { m_path = path; }
+    const std::string& getPath() const { return m_boundPath; }
+
+    // connections sending bigger messages are closed, call before bind()
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    bool isBound() const { return m_listenFd >= 0; }
+    int getPort() const { return m_port; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _accept();
+    void _handle(const UnixConnectionPtr& connection, uint32_t events);
+    void _close(const UnixConnectionPtr& connection);
+    UnixConnectionPtr _find(void* id);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    std::string m_path;
+    std::string m_boundPath;
+    size_t m_maxMessageSize{DEFAULT_MAX_MESSAGE_SIZE};
+    std::unique_ptr<UnixReceiveBuffers> m_buffers;
+
+    int m_listenFd{-1};
+    int m_port{0};
+
+    std::mutex m_mutex;
+    std::unordered_map<void*, UnixConnectionPtr> m_connections;
+    std::mutex m_sendMutex;
+    std::vector<UnixConnectionPtr> m_sendList;
+};
+
+
+/*
+* UnixClientTransporter - unix domain socket client (SOCK_SEQPACKET)
+*
+* connect() uses host as socket path if it starts with '/' or '@',
+* UnixServerTransporter::defaultPath(port) otherwise.
+* connected() is called from the loop thread.
+*/
+class UnixClientTransporter : public ClientTransporter
+{
+public:
+    UnixClientTransporter();
+    UnixClientTransporter(EventLoop& loop);
+    ~UnixClientTransporter();
+
+    using ClientTransporter::send;
+
+    // ClientTransporter
+    void connect(std::string host, int port, bool secure = false) override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    void send(const char* data, size_t size) override;
+    void send(const SharedBuffer& buffer) override;
+
+public:
+    // call before connect()
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _handle(const UnixConnectionPtr& connection, uint32_t events);
+    void _close(const UnixConnectionPtr& connection);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    size_t m_maxMessageSize{UnixServerTransporter::DEFAULT_MAX_MESSAGE_SIZE};
+    std::unique_ptr<UnixReceiveBuffers> m_buffers;
+
+    std::mutex m_mutex;
+    UnixConnectionPtr m_connection;
+    std::atomic<bool> m_connected{false};
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_UNIXTRANSPORTER_H
@@ -0,0 +1,57 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_VALUECHANNEL_H
+#define RCP_VALUECHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rcp {
+
+/*
+* ValueChannel - unreliable fan-out for value updates
+*
+* ParameterServer sends UPDATEVALUE packets through the channel instead of
+* its transporters, structural packets stay on the transporters.
+* receivers report lost packets, the server resends the current values
+* of the affected parameters.
+*
+* all calls are made from ParameterServer::update() (or its sender
+* thread) with the parameter manager locked.
+*/
+class ValueChannel
+{
+public:
+    virtual ~ValueChannel() {}
+
+    // queue a serialized UPDATEVALUE packet of parameter id
+    // returns false if the packet can not be sent on this channel
+    virtual bool add(int16_t id, const char* data, size_t size) = 0;
+
+    // send queued packets
+    virtual void flush() = 0;
+
+    // collect parameters to resend after reported loss
+    // all is set if the loss can not be mapped to parameters
+    virtual void takeResync(std::vector<int16_t>& ids, bool& all) = 0;
+};
+
+}
+
+#endif // RCP_VALUECHANNEL_H
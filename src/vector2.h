@@ -18,6 +18,7 @@
 #ifndef VECTOR2_H
 #define VECTOR2_H
 
+#include <cstring>
 #include <type_traits>
 #include <ostream>
 
@@ -124,10 +125,12 @@ Vector2<T>& swap_endian(Vector2<T>& u)
 
 template <class T,
          typename = std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value > >
-Vector2<T> readFromStream(std::istream& is, const Vector2<T>& /*i*/)
+Vector2<T> readFromStream(ByteReader& is, const Vector2<T>& /*i*/)
 {
-    T x = readFromStream(is, x);
-    T y = readFromStream(is, y);
+    T x{};
+    x = readFromStream(is, x);
+    T y{};
+    y = readFromStream(is, y);
 
     return Vector2<T>(x, y);
 }
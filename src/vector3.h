@@ -18,6 +18,7 @@
 #ifndef VECTOR3_H
 #define VECTOR3_H
 
+#include <cstring>
 #include <type_traits>
 #include <ostream>
 
@@ -141,11 +142,14 @@ Vector3<T>& swap_endian(Vector3<T>& u)
 
 template <class T,
          typename = std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value > >
-Vector3<T> readFromStream(std::istream& is, const Vector3<T>& /*i*/)
+Vector3<T> readFromStream(ByteReader& is, const Vector3<T>& /*i*/)
 {
-    T x = readFromStream(is, x);
-    T y = readFromStream(is, y);
-    T z = readFromStream(is, z);
+    T x{};
+    x = readFromStream(is, x);
+    T y{};
+    y = readFromStream(is, y);
+    T z{};
+    z = readFromStream(is, z);
 
     return Vector3<T>(x, y, z);
 }
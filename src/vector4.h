@@ -19,6 +19,7 @@
 #define VECTOR4_H
 
 
+#include <cstring>
 #include <type_traits>
 #include <ostream>
 
@@ -159,12 +160,16 @@ Vector4<T>& swap_endian(Vector4<T>& u)
 
 template <class T,
          typename = std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value > >
-Vector4<T> readFromStream(std::istream& is, const Vector4<T>& /*i*/)
+Vector4<T> readFromStream(ByteReader& is, const Vector4<T>& /*i*/)
 {
-    T x = readFromStream(is, x);
-    T y = readFromStream(is, y);
-    T z = readFromStream(is, z);
-    T w = readFromStream(is, w);
+    T x{};
+    x = readFromStream(is, x);
+    T y{};
+    y = readFromStream(is, y);
+    T z{};
+    z = readFromStream(is, z);
+    T w{};
+    w = readFromStream(is, w);
 
     return Vector4<T>(x, y, z, w);
 }
@@ -0,0 +1,371 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#include "websocket.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace rcp {
+
+static const char* WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static inline uint32_t rotateLeft(uint32_t value, unsigned int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+//------------------------------------------------------------------
+// WebSocket
+std::string WebSocket::acceptKey(const std::string& key)
+{
+    std::string input = key + WEBSOCKET_GUID;
+
+    uint8_t digest[20];
+    sha1(input.data(), input.size(), digest);
+
+    return base64(digest, sizeof(digest));
+}
+
+size_t WebSocket::writeHeader(char* out, opcode_t opcode, uint64_t payloadSize, bool fin, const uint8_t* mask)
+{
+    size_t pos = 0;
+    uint8_t mask_bit = mask ? 0x80 : 0x00;
+
+    out[pos++] = static_cast<char>((fin ? 0x80 : 0x00) | (opcode & 0x0F));
+
+    if (payloadSize < 126)
+    {
+        out[pos++] = static_cast<char>(mask_bit | payloadSize);
+    }
+    else if (payloadSize <= 0xFFFF)
+    {
+        out[pos++] = static_cast<char>(mask_bit | 126);
+        out[pos++] = static_cast<char>((payloadSize >> 8) & 0xFF);
+        out[pos++] = static_cast<char>(payloadSize & 0xFF);
+    }
+    else
+    {
+        out[pos++] = static_cast<char>(mask_bit | 127);
+        for (int i = 7; i >= 0; i--)
+        {
+            out[pos++] = static_cast<char>((payloadSize >> (i * 8)) & 0xFF);
+        }
+    }
+
+    if (mask)
+    {
+        std::memcpy(out + pos, mask, 4);
+        pos += 4;
+    }
+
+    return pos;
+}
+
+void WebSocket::applyMask(char* data, size_t size, const uint8_t* mask, size_t offset)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = static_cast<char>(data[i] ^ mask[(i + offset) & 3]);
+    }
+}
+
+void WebSocket::sha1(const char* data, size_t size, uint8_t digest[20])
+{
+    uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+    // message + 0x80 + padding + 64 bit length
+    std::vector<uint8_t> message(data, data + size);
+    message.push_back(0x80);
+    while (message.size() % 64 != 56)
+    {
+        message.push_back(0x00);
+    }
+
+    uint64_t bits = static_cast<uint64_t>(size) * 8;
+    for (int i = 7; i >= 0; i--)
+    {
+        message.push_back(static_cast<uint8_t>((bits >> (i * 8)) & 0xFF));
+    }
+
+    for (size_t chunk = 0; chunk < message.size(); chunk += 64)
+    {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++)
+        {
+            const uint8_t* p = &message[chunk + i * 4];
+            w[i] = (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+        }
+        for (int i = 16; i < 80; i++)
+        {
+            w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0];
+        uint32_t b = h[1];
+        uint32_t c = h[2];
+        uint32_t d = h[3];
+        uint32_t e = h[4];
+
+        for (int i = 0; i < 80; i++)
+        {
+            uint32_t f;
+            uint32_t k;
+
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++)
+    {
+        digest[i * 4] = static_cast<uint8_t>((h[i] >> 24) & 0xFF);
+        digest[i * 4 + 1] = static_cast<uint8_t>((h[i] >> 16) & 0xFF);
+        digest[i * 4 + 2] = static_cast<uint8_t>((h[i] >> 8) & 0xFF);
+        digest[i * 4 + 3] = static_cast<uint8_t>(h[i] & 0xFF);
+    }
+}
+
+std::string WebSocket::base64(const uint8_t* data, size_t size)
+{
+    static const char* table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+
+    for (size_t i = 0; i < size; i += 3)
+    {
+        uint32_t value = uint32_t(data[i]) << 16;
+        if (i + 1 < size) value |= uint32_t(data[i + 1]) << 8;
+        if (i + 2 < size) value |= uint32_t(data[i + 2]);
+
+        out.push_back(table[(value >> 18) & 0x3F]);
+        out.push_back(table[(value >> 12) & 0x3F]);
+        out.push_back(i + 1 < size ? table[(value >> 6) & 0x3F] : '=');
+        out.push_back(i + 2 < size ? table[value & 0x3F] : '=');
+    }
+
+    return out;
+}
+
+std::string WebSocket::headerValue(const std::string& request, const std::string& name)
+{
+    std::string lower_request = request;
+    std::string lower_name = name;
+    std::transform(lower_request.begin(), lower_request.end(), lower_request.begin(), ::tolower);
+    std::transform(lower_name.begin(), lower_name.end(), lower_name.begin(), ::tolower);
+
+    size_t pos = 0;
+    while ((pos = lower_request.find("\r\n", pos)) != std::string::npos)
+    {
+        pos += 2;
+
+        if (lower_request.compare(pos, lower_name.size(), lower_name) == 0 &&
+            pos + lower_name.size() < lower_request.size() &&
+            lower_request[pos + lower_name.size()] == ':')
+        {
+            size_t start = pos + lower_name.size() + 1;
+            size_t end = request.find("\r\n", start);
+
+            std::string value = request.substr(start, end - start);
+
+            // trim
+            size_t first = value.find_first_not_of(" \t");
+            size_t last = value.find_last_not_of(" \t");
+            if (first == std::string::npos)
+            {
+                return "";
+            }
+            return value.substr(first, last - first + 1);
+        }
+    }
+
+    return "";
+}
+
+
+//------------------------------------------------------------------
+// WebSocketParser
+WebSocketParser::WebSocketParser(bool requireMask, size_t maxMessageSize)
+    : m_requireMask(requireMask)
+    , m_maxMessageSize(maxMessageSize)
+{
+}
+
+size_t WebSocketParser::parse(char* data, size_t size, const Handler& onMessage, const Handler& onControl)
+{
+    if (size < 2)
+    {
+        return 0;
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+
+    bool fin = (bytes[0] & 0x80) != 0;
+    WebSocket::opcode_t opcode = static_cast<WebSocket::opcode_t>(bytes[0] & 0x0F);
+    bool masked = (bytes[1] & 0x80) != 0;
+    uint64_t length = bytes[1] & 0x7F;
+
+    if ((bytes[0] & 0x70) != 0 ||
+        masked != m_requireMask)
+    {
+        // no extensions negotiated, masking is mandatory one way only
+        return PARSE_ERROR;
+    }
+
+    size_t pos = 2;
+
+    if (length == 126)
+    {
+        if (size < pos + 2)
+        {
+            return 0;
+        }
+        length = (uint64_t(bytes[2]) << 8) | uint64_t(bytes[3]);
+        pos += 2;
+    }
+    else if (length == 127)
+    {
+        if (size < pos + 8)
+        {
+            return 0;
+        }
+        length = 0;
+        for (int i = 0; i < 8; i++)
+        {
+            length = (length << 8) | uint64_t(bytes[2 + i]);
+        }
+        pos += 8;
+    }
+
+    if (length > m_maxMessageSize)
+    {
+        return PARSE_ERROR;
+    }
+
+    const uint8_t* mask = nullptr;
+    if (masked)
+    {
+        if (size < pos + 4)
+        {
+            return 0;
+        }
+        mask = bytes + pos;
+        pos += 4;
+    }
+
+    if (size < pos + length)
+    {
+        return 0;
+    }
+
+    char* payload = data + pos;
+    size_t payload_size = static_cast<size_t>(length);
+
+    if (mask)
+    {
+        WebSocket::applyMask(payload, payload_size, mask);
+    }
+
+    if (opcode >= WebSocket::OPCODE_CLOSE)
+    {
+        // control frames are not fragmented
+        if (!fin || payload_size > 125)
+        {
+            return PARSE_ERROR;
+        }
+
+        onControl(opcode, payload, payload_size);
+    }
+    else if (opcode == WebSocket::OPCODE_CONTINUATION)
+    {
+        if (!m_fragmented ||
+            m_fragments.size() + payload_size > m_maxMessageSize)
+        {
+            return PARSE_ERROR;
+        }
+
+        m_fragments.insert(m_fragments.end(), payload, payload + payload_size);
+
+        if (fin)
+        {
+            onMessage(m_fragmentOpcode, m_fragments.data(), m_fragments.size());
+            m_fragments.clear();
+            m_fragmented = false;
+        }
+    }
+    else if (opcode == WebSocket::OPCODE_TEXT ||
+             opcode == WebSocket::OPCODE_BINARY)
+    {
+        if (m_fragmented)
+        {
+            return PARSE_ERROR;
+        }
+
+        if (fin)
+        {
+            // deliver from input
+            onMessage(opcode, payload, payload_size);
+        }
+        else
+        {
+            m_fragmented = true;
+            m_fragmentOpcode = opcode;
+            m_fragments.assign(payload, payload + payload_size);
+        }
+    }
+    else
+    {
+        return PARSE_ERROR;
+    }
+
+    return pos + payload_size;
+}
+
+}
@@ -0,0 +1,103 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_WEBSOCKET_H
+#define RCP_WEBSOCKET_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace rcp {
+
+/*
+* WebSocket - rfc 6455 helpers
+*
+* handshake keys, frame headers and masking.
+*/
+class WebSocket
+{
+public:
+    enum opcode_t
+    {
+        OPCODE_CONTINUATION = 0x0,
+        OPCODE_TEXT = 0x1,
+        OPCODE_BINARY = 0x2,
+        OPCODE_CLOSE = 0x8,
+        OPCODE_PING = 0x9,
+        OPCODE_PONG = 0xA
+    };
+
+    static const size_t MAX_HEADER_SIZE = 14;
+
+public:
+    // Sec-WebSocket-Accept for a Sec-WebSocket-Key
+    static std::string acceptKey(const std::string& key);
+
+    // writes a frame header to out (MAX_HEADER_SIZE bytes)
+    // mask: 4 bytes or nullptr for unmasked frames
+    // returns header size
+    static size_t writeHeader(char* out, opcode_t opcode, uint64_t payloadSize, bool fin, const uint8_t* mask);
+
+    // xor data with mask, offset: position of data in the payload
+    static void applyMask(char* data, size_t size, const uint8_t* mask, size_t offset = 0);
+
+    static void sha1(const char* data, size_t size, uint8_t digest[20]);
+    static std::string base64(const uint8_t* data, size_t size);
+
+    // value of a http header (case insensitive name), empty if not found
+    static std::string headerValue(const std::string& request, const std::string& name);
+};
+
+
+/*
+* WebSocketParser - parses frames from a byte stream
+*
+* payloads are unmasked in place. unfragmented messages are delivered
+* directly from the input, fragmented messages are collected first.
+*/
+class WebSocketParser
+{
+public:
+    static const size_t PARSE_ERROR = static_cast<size_t>(-1);
+
+    typedef std::function<void(WebSocket::opcode_t opcode, const char* data, size_t size)> Handler;
+
+public:
+    // requireMask: true on the server, false on the client
+    WebSocketParser(bool requireMask, size_t maxMessageSize);
+
+    // parse one frame from data
+    // returns bytes used, 0 if more data is needed, PARSE_ERROR on protocol errors
+    // onMessage is called for complete text or binary messages,
+    // onControl for close, ping and pong frames
+    size_t parse(char* data, size_t size, const Handler& onMessage, const Handler& onControl);
+
+private:
+    bool m_requireMask;
+    size_t m_maxMessageSize;
+
+    std::vector<char> m_fragments;
+    WebSocket::opcode_t m_fragmentOpcode{WebSocket::OPCODE_BINARY};
+    bool m_fragmented{false};
+};
+
+}
+
+#endif // RCP_WEBSOCKET_H
@@ -0,0 +1,703 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifdef __linux__
+
+#include "websockettransporter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <sys/epoll.h>
+
+namespace rcp {
+
+// handshake requests and responses bigger than this are rejected
+static const size_t MAX_HANDSHAKE_SIZE = 8192;
+
+static size_t findHeaderEnd(const char* data, size_t size)
+{
+    static const char* marker = "\r\n\r\n";
+    const char* end = std::search(data, data + size, marker, marker + 4);
+
+    if (end == data + size)
+    {
+        return 0;
+    }
+
+    return static_cast<size_t>(end - data) + 4;
+}
+
+static bool containsToken(std::string value, const std::string& token)
+{
+    std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+    return value.find(token) != std::string::npos;
+}
+
+
+//------------------------------------------------------------------
+// WebSocketConnection
+bool WebSocketConnection::send(const SharedBuffer& buffer)
+{
+    char header[WebSocket::MAX_HEADER_SIZE];
+
+    if (!client)
+    {
+        size_t header_size = WebSocket::writeHeader(header, WebSocket::OPCODE_BINARY, buffer.size(), true, nullptr);
+        return stream->send(header, header_size, buffer);
+    }
+
+    // clients mask every frame, this needs a copy of the payload
+    uint8_t mask[4];
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t r = static_cast<uint32_t>(rng());
+        std::memcpy(mask, &r, 4);
+    }
+
+    std::vector<char> masked(buffer.data(), buffer.data() + buffer.size());
+    WebSocket::applyMask(masked.data(), masked.size(), mask);
+
+    size_t header_size = WebSocket::writeHeader(header, WebSocket::OPCODE_BINARY, masked.size(), true, mask);
+    return stream->send(header, header_size, SharedBuffer(std::move(masked)));
+}
+
+bool WebSocketConnection::sendControl(WebSocket::opcode_t opcode, const char* data, size_t size)
+{
+    char header[WebSocket::MAX_HEADER_SIZE];
+    std::vector<char> payload(data, data + std::min<size_t>(size, 125));
+
+    uint8_t mask[4];
+    uint8_t* mask_ptr = nullptr;
+
+    if (client)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        uint32_t r = static_cast<uint32_t>(rng());
+        std::memcpy(mask, &r, 4);
+        mask_ptr = mask;
+    }
+
+    if (mask_ptr)
+    {
+        WebSocket::applyMask(payload.data(), payload.size(), mask_ptr);
+    }
+
+    size_t header_size = WebSocket::writeHeader(header, opcode, payload.size(), true, mask_ptr);
+    return stream->send(header, header_size, SharedBuffer(std::move(payload)));
+}
+
+
+//------------------------------------------------------------------
+// WebSocketServerTransporter
+WebSocketServerTransporter::WebSocketServerTransporter()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+WebSocketServerTransporter::WebSocketServerTransporter(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+WebSocketServerTransporter::~WebSocketServerTransporter()
+{
+    unbind();
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+}
+
+void WebSocketServerTransporter::bind(int port)
+{
+    if (m_listenFd >= 0)
+    {
+        unbind();
+    }
+
+    int fd = TcpSocket::listen(m_bindAddress, port, m_port);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    m_listenFd = fd;
+    m_loop.add(fd, EPOLLIN, [this](uint32_t) { _accept(); });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+}
+
+void WebSocketServerTransporter::unbind()
+{
+    if (m_listenFd < 0)
+    {
+        return;
+    }
+
+    m_loop.invoke([this]() {
+
+        m_loop.remove(m_listenFd);
+        TcpSocket::close(m_listenFd);
+        m_listenFd = -1;
+
+        std::unordered_map<void*, WebSocketConnectionPtr> connections;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            connections.swap(m_connections);
+        }
+
+        for (auto& kv : connections)
+        {
+            kv.second->stream->close();
+
+            if (kv.second->open)
+            {
+                m_openCount--;
+                _clientDisconnected(kv.first);
+            }
+        }
+    });
+}
+
+void WebSocketServerTransporter::sendToOne(const char* data, size_t size, void* id)
+{
+    sendToOne(SharedBuffer(data, size), id);
+}
+
+void WebSocketServerTransporter::sendToAll(const char* data, size_t size, void* excludeId)
+{
+    sendToAll(SharedBuffer(data, size), excludeId);
+}
+
+void WebSocketServerTransporter::sendToOne(const SharedBuffer& buffer, void* id)
+{
+    WebSocketConnectionPtr connection = _find(id);
+
+    if (connection &&
+        connection->open)
+    {
+        connection->send(buffer);
+    }
+}
+
+void WebSocketServerTransporter::sendToAll(const SharedBuffer& buffer, void* excludeId)
+{
+    sendToSome(buffer, [excludeId](void* id) { return id != excludeId; });
+}
+
+void WebSocketServerTransporter::sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter)
+{
+    // same header for all connections
+    char header[WebSocket::MAX_HEADER_SIZE];
+    size_t header_size = WebSocket::writeHeader(header, WebSocket::OPCODE_BINARY, buffer.size(), true, nullptr);
+
+    std::lock_guard<std::mutex> send_lock(m_sendMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& kv : m_connections)
+        {
+            if (kv.second->open &&
+                filter(kv.first))
+            {
+                m_sendList.push_back(kv.second);
+            }
+        }
+    }
+
+    for (auto& connection : m_sendList)
+    {
+        connection->stream->send(header, header_size, buffer);
+    }
+
+    m_sendList.clear();
+}
+
+int WebSocketServerTransporter::getConnectionCount()
+{
+    return m_openCount.load();
+}
+
+void WebSocketServerTransporter::_accept()
+{
+    while (true)
+    {
+        int fd = TcpSocket::accept(m_listenFd);
+        if (fd < 0)
+        {
+            return;
+        }
+
+        TcpSocket::setNoDelay(fd, m_noDelay);
+
+        TcpStreamPtr stream = std::make_shared<TcpStream>(m_loop, fd, m_maxMessageSize);
+        WebSocketConnectionPtr connection = std::make_shared<WebSocketConnection>(stream, true, m_maxMessageSize);
+
+        std::weak_ptr<WebSocketConnection> weak = connection;
+        m_loop.add(fd, EPOLLIN, [this, weak](uint32_t events) {
+            WebSocketConnectionPtr c = weak.lock();
+            if (c)
+            {
+                _handle(c, events);
+            }
+        });
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connections[connection.get()] = connection;
+    }
+}
+
+void WebSocketServerTransporter::_handle(const WebSocketConnectionPtr& connection, uint32_t events)
+{
+    if ((events & EPOLLIN) ||
+        (events & EPOLLHUP))
+    {
+        bool ok = connection->stream->handleReadRaw([this, &connection](char* data, size_t size) {
+            return _consume(connection, data, size);
+        });
+
+        if (!ok)
+        {
+            _close(connection);
+            return;
+        }
+    }
+
+    if (events & EPOLLERR)
+    {
+        _close(connection);
+        return;
+    }
+
+    if (events & EPOLLOUT)
+    {
+        if (!connection->stream->handleWrite())
+        {
+            _close(connection);
+        }
+    }
+}
+
+size_t WebSocketServerTransporter::_consume(const WebSocketConnectionPtr& connection, char* data, size_t size)
+{
+    if (!connection->open)
+    {
+        return _handshake(connection, data, size);
+    }
+
+    bool close = false;
+    void* id = connection.get();
+
+    size_t used = connection->parser.parse(data, size,
+        [this, id](WebSocket::opcode_t /*opcode*/, const char* payload, size_t payloadSize) {
+            _received(payload, payloadSize, id);
+        },
+        [&connection, &close](WebSocket::opcode_t opcode, const char* payload, size_t payloadSize) {
+            if (opcode == WebSocket::OPCODE_PING)
+            {
+                connection->sendControl(WebSocket::OPCODE_PONG, payload, payloadSize);
+            }
+            else if (opcode == WebSocket::OPCODE_CLOSE)
+            {
+                // echo status code
+                connection->sendControl(WebSocket::OPCODE_CLOSE, payload, std::min<size_t>(payloadSize, 2));
+                close = true;
+            }
+        });
+
+    if (used == WebSocketParser::PARSE_ERROR)
+    {
+        // 1002: protocol error
+        const char status[2] = { 0x03, static_cast<char>(0xEA) };
+        connection->sendControl(WebSocket::OPCODE_CLOSE, status, 2);
+        return TcpStream::CONSUME_ERROR;
+    }
+
+    if (close)
+    {
+        return TcpStream::CONSUME_ERROR;
+    }
+
+    return used;
+}
+
+size_t WebSocketServerTransporter::_handshake(const WebSocketConnectionPtr& connection, char* data, size_t size)
+{
+    size_t end = findHeaderEnd(data, size);
+    if (end == 0)
+    {
+        return size > MAX_HANDSHAKE_SIZE ? TcpStream::CONSUME_ERROR : 0;
+    }
+
+    std::string request(data, end);
+    std::string key = WebSocket::headerValue(request, "Sec-WebSocket-Key");
+
+    if (request.compare(0, 4, "GET ") != 0 ||
+        !containsToken(WebSocket::headerValue(request, "Upgrade"), "websocket") ||
+        WebSocket::headerValue(request, "Sec-WebSocket-Version") != "13" ||
+        key.empty())
+    {
+        std::string response = "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+        connection->stream->send(nullptr, 0, SharedBuffer(response.data(), response.size()));
+        return TcpStream::CONSUME_ERROR;
+    }
+
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " + WebSocket::acceptKey(key) + "\r\n"
+                           "\r\n";
+    connection->stream->send(nullptr, 0, SharedBuffer(response.data(), response.size()));
+
+    connection->open = true;
+    m_openCount++;
+
+    _clientConnected(connection.get());
+
+    return end;
+}
+
+void WebSocketServerTransporter::_close(const WebSocketConnectionPtr& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connections.erase(connection.get()) == 0)
+        {
+            return;
+        }
+    }
+
+    connection->stream->close();
+
+    if (connection->open)
+    {
+        m_openCount--;
+        _clientDisconnected(connection.get());
+    }
+}
+
+WebSocketConnectionPtr WebSocketServerTransporter::_find(void* id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_connections.find(id);
+    if (it != m_connections.end())
+    {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
+
+//------------------------------------------------------------------
+// WebSocketClientTransporter
+WebSocketClientTransporter::WebSocketClientTransporter()
+    : m_ownLoop(new EventLoop())
+    , m_loop(*m_ownLoop)
+{
+}
+
+WebSocketClientTransporter::WebSocketClientTransporter(EventLoop& loop)
+    : m_loop(loop)
+{
+}
+
+WebSocketClientTransporter::~WebSocketClientTransporter()
+{
+    if (m_ownLoop)
+    {
+        m_ownLoop->stop();
+    }
+
+    WebSocketConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection.swap(m_connection);
+    }
+
+    // no notification, listeners might be gone already
+    if (connection)
+    {
+        connection->stream->close();
+    }
+}
+
+void WebSocketClientTransporter::connect(std::string host, int port, bool secure)
+{
+    if (secure)
+    {
+        std::cerr << "WebSocketClientTransporter: secure connections are not supported\n";
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connection)
+        {
+            // connected or connecting
+            return;
+        }
+    }
+
+    int fd = TcpSocket::connect(host, port);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    TcpSocket::setNoDelay(fd, m_noDelay);
+
+    TcpStreamPtr stream = std::make_shared<TcpStream>(m_loop, fd, m_maxMessageSize);
+    WebSocketConnectionPtr connection = std::make_shared<WebSocketConnection>(stream, false, m_maxMessageSize);
+    connection->client = true;
+
+    std::random_device random;
+    connection->rng.seed(random());
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_connection = connection;
+        m_host = host + ":" + std::to_string(port);
+        m_tcpConnected = false;
+    }
+
+    // writable when connected
+    std::weak_ptr<WebSocketConnection> weak = connection;
+    m_loop.add(fd, EPOLLOUT, [this, weak](uint32_t events) {
+        WebSocketConnectionPtr c = weak.lock();
+        if (c)
+        {
+            _handle(c, events);
+        }
+    });
+
+    if (m_ownLoop)
+    {
+        m_ownLoop->start();
+    }
+}
+
+void WebSocketClientTransporter::disconnect()
+{
+    WebSocketConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection = m_connection;
+    }
+
+    if (!connection)
+    {
+        return;
+    }
+
+    if (connection->open)
+    {
+        // 1000: normal closure
+        const char status[2] = { 0x03, static_cast<char>(0xE8) };
+        connection->sendControl(WebSocket::OPCODE_CLOSE, status, 2);
+    }
+
+    m_loop.invoke([this, connection]() { _close(connection); });
+}
+
+bool WebSocketClientTransporter::isConnected()
+{
+    return m_connected.load(std::memory_order_acquire);
+}
+
+void WebSocketClientTransporter::send(const char* data, size_t size)
+{
+    send(SharedBuffer(data, size));
+}
+
+void WebSocketClientTransporter::send(const SharedBuffer& buffer)
+{
+    if (!m_connected.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    WebSocketConnectionPtr connection;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        connection = m_connection;
+    }
+
+    if (connection)
+    {
+        connection->send(buffer);
+    }
+}
+
+void WebSocketClientTransporter::_handle(const WebSocketConnectionPtr& connection, uint32_t events)
+{
+    if (!m_tcpConnected)
+    {
+        int error = TcpSocket::connectError(connection->stream->fd());
+
+        if (error != 0 ||
+            (events & (EPOLLERR | EPOLLHUP)))
+        {
+            std::cerr << "WebSocketClientTransporter: connect failed: " << error << "\n";
+            _close(connection);
+            return;
+        }
+
+        m_tcpConnected = true;
+        m_loop.modify(connection->stream->fd(), EPOLLIN);
+
+        // opening handshake
+        uint8_t nonce[16];
+        for (size_t i = 0; i < sizeof(nonce); i++)
+        {
+            nonce[i] = static_cast<uint8_t>(connection->rng() & 0xFF);
+        }
+        connection->key = WebSocket::base64(nonce, sizeof(nonce));
+
+        std::string request = "GET " + m_path + " HTTP/1.1\r\n"
+                              "Host: " + m_host + "\r\n"
+                              "Upgrade: websocket\r\n"
+                              "Connection: Upgrade\r\n"
+                              "Sec-WebSocket-Key: " + connection->key + "\r\n"
+                              "Sec-WebSocket-Version: 13\r\n"
+                              "\r\n";
+        connection->stream->send(nullptr, 0, SharedBuffer(request.data(), request.size()));
+        return;
+    }
+
+    if ((events & EPOLLIN) ||
+        (events & EPOLLHUP))
+    {
+        bool ok = connection->stream->handleReadRaw([this, &connection](char* data, size_t size) {
+            return _consume(connection, data, size);
+        });
+
+        if (!ok)
+        {
+            _close(connection);
+            return;
+        }
+    }
+
+    if (events & EPOLLERR)
+    {
+        _close(connection);
+        return;
+    }
+
+    if (events & EPOLLOUT)
+    {
+        if (!connection->stream->handleWrite())
+        {
+            _close(connection);
+        }
+    }
+}
+
+size_t WebSocketClientTransporter::_consume(const WebSocketConnectionPtr& connection, char* data, size_t size)
+{
+    if (!connection->open)
+    {
+        return _handshake(connection, data, size);
+    }
+
+    bool close = false;
+
+    size_t used = connection->parser.parse(data, size,
+        [this](WebSocket::opcode_t /*opcode*/, const char* payload, size_t payloadSize) {
+            _received(payload, payloadSize);
+        },
+        [&connection, &close](WebSocket::opcode_t opcode, const char* payload, size_t payloadSize) {
+            if (opcode == WebSocket::OPCODE_PING)
+            {
+                connection->sendControl(WebSocket::OPCODE_PONG, payload, payloadSize);
+            }
+            else if (opcode == WebSocket::OPCODE_CLOSE)
+            {
+                connection->sendControl(WebSocket::OPCODE_CLOSE, payload, std::min<size_t>(payloadSize, 2));
+                close = true;
+            }
+        });
+
+    if (used == WebSocketParser::PARSE_ERROR ||
+        close)
+    {
+        return TcpStream::CONSUME_ERROR;
+    }
+
+    return used;
+}
+
+size_t WebSocketClientTransporter::_handshake(const WebSocketConnectionPtr& connection, char* data, size_t size)
+{
+    size_t end = findHeaderEnd(data, size);
+    if (end == 0)
+    {
+        return size > MAX_HANDSHAKE_SIZE ? TcpStream::CONSUME_ERROR : 0;
+    }
+
+    std::string response(data, end);
+    std::string status_line = response.substr(0, response.find("\r\n"));
+
+    if (status_line.find(" 101") == std::string::npos ||
+        WebSocket::headerValue(response, "Sec-WebSocket-Accept") != WebSocket::acceptKey(connection->key))
+    {
+        std::cerr << "WebSocketClientTransporter: handshake failed: " << status_line << "\n";
+        return TcpStream::CONSUME_ERROR;
+    }
+
+    connection->open = true;
+    m_connected.store(true, std::memory_order_release);
+
+    _connected();
+
+    return end;
+}
+
+void WebSocketClientTransporter::_close(const WebSocketConnectionPtr& connection)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_connection != connection)
+        {
+            return;
+        }
+        m_connection.reset();
+    }
+
+    bool was_connected = m_connected.exchange(false);
+    m_tcpConnected = false;
+
+    connection->stream->close();
+
+    if (was_connected)
+    {
+        _disconnected();
+    }
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,204 @@
+/*
+********************************************************************
+* rabbitcontrol - a protocol and data-format for remote control.
+*
+* https://rabbitcontrol.cc
+* https://github.com/rabbitControl/rcp-cpp
+*
+* This file is part of rabbitcontrol for c++.
+*
+* Written by Ingo Randolf, 2018-2024
+*
+* This Source Code Form is subject to the terms of the Mozilla Public
+* License, v. 2.0. If a copy of the MPL was not distributed with this
+* file, You can obtain one at https://mozilla.org/MPL/2.0/.
+*********************************************************************
+*/
+
+#ifndef RCP_WEBSOCKETTRANSPORTER_H
+#define RCP_WEBSOCKETTRANSPORTER_H
+
+#ifdef __linux__
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "servertransporter.h"
+#include "clienttransporter.h"
+#include "sharedbuffer.h"
+#include "eventloop.h"
+#include "tcptransporter.h"
+#include "websocket.h"
+
+namespace rcp {
+
+/*
+* WebSocketConnection - one websocket on a TcpStream
+*/
+class WebSocketConnection
+{
+public:
+    WebSocketConnection(const TcpStreamPtr& stream, bool server, size_t maxMessageSize)
+        : stream(stream)
+        , parser(server, maxMessageSize)
+    {}
+
+    // send one binary message
+    // server frames are not masked, the payload buffer is sent as it is
+    bool send(const SharedBuffer& buffer);
+    bool sendControl(WebSocket::opcode_t opcode, const char* data, size_t size);
+
+    TcpStreamPtr stream;
+    WebSocketParser parser;
+
+    // handshake done
+    bool open{false};
+    // client only: key sent with the handshake
+    std::string key;
+    // client only: masking keys
+    std::mt19937 rng;
+    std::mutex mutex;
+    bool client{false};
+};
+
+typedef std::shared_ptr<WebSocketConnection> WebSocketConnectionPtr;
+
+
+/*
+* WebSocketServerTransporter - rfc 6455 server on an EventLoop
+*
+* every packet (or frame of packets) is sent as one binary message.
+* frame headers are written separately, the serialized buffer is
+* passed to the socket without copying.
+* queued messages are written in batches with one call.
+*
+* the connection id passed to receivers is the WebSocketConnection.
+* tls is not supported.
+*/
+class WebSocketServerTransporter : public ServerTransporter
+{
+public:
+    WebSocketServerTransporter();
+    WebSocketServerTransporter(EventLoop& loop);
+    ~WebSocketServerTransporter();
+
+    using ServerTransporter::sendToOne;
+    using ServerTransporter::sendToAll;
+
+    // ServerTransporter
+    void bind(int port) override;
+    void unbind() override;
+
+    void sendToOne(const char* data, size_t size, void* id) override;
+    void sendToAll(const char* data, size_t size, void* excludeId) override;
+    void sendToOne(const SharedBuffer& buffer, void* id) override;
+    void sendToAll(const SharedBuffer& buffer, void* excludeId) override;
+    void sendToSome(const SharedBuffer& buffer, const std::function<bool(void*)>& filter) override;
+
+    // connections with finished handshake
+    int getConnectionCount() override;
+
+public:
+    // address to bind to, default: all interfaces
+    void setBindAddress(const std::string& address) { m_bindAddress = address; }
+
+    // disable nagle, default: true
+    void setNoDelay(bool noDelay) { m_noDelay = noDelay; }
+
+    // connections sending bigger messages are closed
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    bool isBound() const { return m_listenFd >= 0; }
+    int getPort() const { return m_port; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _accept();
+    void _handle(const WebSocketConnectionPtr& connection, uint32_t events);
+    size_t _consume(const WebSocketConnectionPtr& connection, char* data, size_t size);
+    size_t _handshake(const WebSocketConnectionPtr& connection, char* data, size_t size);
+    void _close(const WebSocketConnectionPtr& connection);
+    WebSocketConnectionPtr _find(void* id);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    std::string m_bindAddress;
+    bool m_noDelay{true};
+    size_t m_maxMessageSize{TcpStream::DEFAULT_MAX_MESSAGE_SIZE};
+
+    int m_listenFd{-1};
+    int m_port{0};
+
+    std::mutex m_mutex;
+    std::unordered_map<void*, WebSocketConnectionPtr> m_connections;
+    std::atomic<int> m_openCount{0};
+    std::mutex m_sendMutex;
+    std::vector<WebSocketConnectionPtr> m_sendList;
+};
+
+
+/*
+* WebSocketClientTransporter - rfc 6455 client on an EventLoop
+*
+* connected() is called after the handshake.
+* client frames have to be masked, so payloads are copied once.
+* tls is not supported.
+*/
+class WebSocketClientTransporter : public ClientTransporter
+{
+public:
+    WebSocketClientTransporter();
+    WebSocketClientTransporter(EventLoop& loop);
+    ~WebSocketClientTransporter();
+
+    using ClientTransporter::send;
+
+    // ClientTransporter
+    void connect(std::string host, int port, bool secure = false) override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    void send(const char* data, size_t size) override;
+    void send(const SharedBuffer& buffer) override;
+
+public:
+    // request path, default: "/"
+    void setPath(const std::string& path) { m_path = path; }
+
+    void setNoDelay(bool noDelay) { m_noDelay = noDelay; }
+    void setMaxMessageSize(size_t size) { m_maxMessageSize = size; }
+
+    EventLoop& loop() { return m_loop; }
+
+private:
+    void _handle(const WebSocketConnectionPtr& connection, uint32_t events);
+    size_t _consume(const WebSocketConnectionPtr& connection, char* data, size_t size);
+    size_t _handshake(const WebSocketConnectionPtr& connection, char* data, size_t size);
+    void _close(const WebSocketConnectionPtr& connection);
+
+    std::unique_ptr<EventLoop> m_ownLoop;
+    EventLoop& m_loop;
+
+    std::string m_path{"/"};
+    std::string m_host;
+    bool m_noDelay{true};
+    size_t m_maxMessageSize{TcpStream::DEFAULT_MAX_MESSAGE_SIZE};
+
+    std::mutex m_mutex;
+    WebSocketConnectionPtr m_connection;
+    bool m_tcpConnected{false};
+    std::atomic<bool> m_connected{false};
+};
+
+}
+
+#endif // __linux__
+
+#endif // RCP_WEBSOCKETTRANSPORTER_H